@@ -0,0 +1,124 @@
+#include "allocstats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+	std::atomic<uint64_t> g_allocations(0);
+	std::atomic<uint64_t> g_frees(0);
+	std::atomic<uint64_t> g_bytes(0);
+	std::atomic<uint64_t> g_freedBytes(0);
+	std::atomic<uint64_t> g_live(0);
+	std::atomic<uint64_t> g_peak(0);
+	bool g_enabled = false;
+
+	struct Phase {
+		const char* name;
+		AllocStats::Counters start;
+		AllocStats::Counters end;
+	};
+	// Only touched between phases, allocating here is counted like anything else
+	std::vector<Phase>* g_phases = NULL;
+	Phase g_current;
+};
+
+#if defined(ESCTOOL_ALLOC_STATS)
+// Every block carries its size in front so delete can account it. The
+// header keeps the default new alignment.
+static const size_t AllocHeader = alignof(std::max_align_t);
+
+static void* countedAlloc(size_t size) {
+	void* p = malloc(size + AllocHeader);
+	if(NULL == p) return NULL;
+	*(size_t*)p = size;
+	g_allocations.fetch_add(1,std::memory_order_relaxed);
+	g_bytes.fetch_add(size,std::memory_order_relaxed);
+	uint64_t live = g_live.fetch_add(size,std::memory_order_relaxed) + size;
+	uint64_t peak = g_peak.load(std::memory_order_relaxed);
+	while(live > peak && !g_peak.compare_exchange_weak(peak,live,std::memory_order_relaxed));
+	return (uint8_t*)p + AllocHeader;
+}
+
+static void countedFree(void* ptr) {
+	if(NULL == ptr) return;
+	void* p = (uint8_t*)ptr - AllocHeader;
+	size_t size = *(size_t*)p;
+	g_frees.fetch_add(1,std::memory_order_relaxed);
+	g_freedBytes.fetch_add(size,std::memory_order_relaxed);
+	g_live.fetch_sub(size,std::memory_order_relaxed);
+	free(p);
+}
+
+void* operator new(size_t size) {
+	void* p = countedAlloc(size);
+	if(NULL == p) throw std::bad_alloc();
+	return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+bool AllocStats::available(void) { return true; }
+#else
+bool AllocStats::available(void) { return false; }
+#endif
+
+void AllocStats::enable(const bool on) { g_enabled = on; }
+bool AllocStats::enabled(void) { return g_enabled && available(); }
+
+AllocStats::Counters AllocStats::current(void) {
+	Counters c;
+	c.allocations = g_allocations.load(std::memory_order_relaxed);
+	c.frees = g_frees.load(std::memory_order_relaxed);
+	c.bytes = g_bytes.load(std::memory_order_relaxed);
+	c.freedBytes = g_freedBytes.load(std::memory_order_relaxed);
+	c.live = g_live.load(std::memory_order_relaxed);
+	c.peak = g_peak.load(std::memory_order_relaxed);
+	return c;
+}
+
+void AllocStats::beginPhase(const char* name) {
+	if(NULL == g_phases) g_phases = new std::vector<Phase>;
+	g_phases->reserve(g_phases->size() + 1);
+	g_current.name = name;
+	// Peak within the phase starts from what is live now
+	g_peak.store(g_live.load(std::memory_order_relaxed),std::memory_order_relaxed);
+	g_current.start = current();
+}
+
+void AllocStats::endPhase(void) {
+	g_current.end = current();
+	g_phases->push_back(g_current);
+}
+
+void AllocStats::printReport(FILE* f) {
+	if(!available()) {
+		fprintf(f,"Allocation statistics are not available, build with -DESCTOOL_ALLOC_STATS=ON\n");
+		return;
+	}
+	fprintf(f,"%-24s %12s %14s %14s %14s\n","Phase","Allocations","Bytes","Peak live","Still live");
+	if(NULL != g_phases) {
+		for(const Phase& p : *g_phases) {
+			fprintf(f,"%-24s %12lu %14lu %14lu %14ld\n",p.name,
+				(unsigned long)(p.end.allocations - p.start.allocations),
+				(unsigned long)(p.end.bytes - p.start.bytes),
+				(unsigned long)p.end.peak,
+				(long)(p.end.live - p.start.live));
+		}
+	}
+	Counters c = current();
+	fprintf(f,"%-24s %12lu %14lu %14s %14lu\n","Total",(unsigned long)c.allocations,
+		(unsigned long)c.bytes,"",(unsigned long)c.live);
+	fprintf(f,"%lu of %lu allocations were never freed\n",
+		(unsigned long)(c.allocations - c.frees),(unsigned long)c.allocations);
+}
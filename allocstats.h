@@ -0,0 +1,53 @@
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * Heap accounting through a counting global operator new/delete. The hook
+ * is only compiled in with -DESCTOOL_ALLOC_STATS=ON (cmake), without it
+ * available() is false and phases record nothing.
+ */
+namespace AllocStats {
+	struct Counters {
+		uint64_t allocations = 0;
+		uint64_t frees = 0;
+		uint64_t bytes = 0; // Allocated
+		uint64_t freedBytes = 0;
+		uint64_t live = 0; // Currently allocated bytes
+		uint64_t peak = 0; // Highest live
+	};
+
+	bool available(void);
+	void enable(const bool on = true);
+	bool enabled(void);
+	Counters current(void);
+
+	// Phases are recorded in the order they end, nesting is not supported
+	void beginPhase(const char* name);
+	void endPhase(void);
+	// Per phase allocations, bytes, peak live and bytes still live (leaked)
+	// at the end of the phase, plus the totals
+	void printReport(FILE* f);
+};
+
+/** Accounts everything allocated from construction to end() or destruction to a phase */
+class AllocPhase {
+public:
+	AllocPhase(const char* name) : m_running(AllocStats::enabled()) {
+		if(m_running) AllocStats::beginPhase(name);
+	};
+	~AllocPhase() { end(); };
+	AllocPhase(const AllocPhase&) = delete;
+	AllocPhase& operator=(const AllocPhase&) = delete;
+
+	void end(void) {
+		if(!m_running) return;
+		m_running = false;
+		AllocStats::endPhase();
+	};
+private:
+	bool m_running;
+};
+
+#endif /* ALLOCSTATS_H */
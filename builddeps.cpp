@@ -0,0 +1,46 @@
+#include "builddeps.h"
+#include "jsonwriter.h"
+#include "outputsink.h"
+
+// Spaces, '#' and '$' need escaping in Makefile rules
+static void appendMakePath(std::string& out, const std::string& path) {
+	for(char c : path) {
+		if(c == ' ' || c == '#') out += '\\';
+		if(c == '$') out += '$';
+		out += c;
+	}
+}
+
+bool BuildDeps::writeDepfile(const std::string& file, const std::vector<std::string>& outputs,
+	const std::vector<std::string>& inputs)
+{
+	std::string rule;
+	for(const std::string& o : outputs) {
+		if(!rule.empty()) rule += " \\\n ";
+		appendMakePath(rule,o);
+	}
+	rule += ":";
+	for(const std::string& i : inputs) {
+		rule += " \\\n ";
+		appendMakePath(rule,i);
+	}
+	rule += "\n";
+	DirectorySink sink;
+	return sink.write(file,rule);
+}
+
+bool BuildDeps::writeOutputManifest(const std::string& file, const std::vector<std::string>& outputs,
+	const std::vector<std::string>& inputs)
+{
+	JSONWriter json;
+	json.beginObject();
+	json.beginArray("inputs");
+	for(const std::string& i : inputs) json.value(NULL,i);
+	json.endArray();
+	json.beginArray("outputs");
+	for(const std::string& o : outputs) json.value(NULL,o);
+	json.endArray();
+	json.endObject();
+	DirectorySink sink;
+	return sink.write(file,json.str() + "\n");
+}
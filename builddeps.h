@@ -0,0 +1,20 @@
+#ifndef BUILDDEPS_H
+#define BUILDDEPS_H
+#include <string>
+#include <vector>
+
+/**
+ * What a run read and produced, for build systems running esctool
+ * (--depfile, --output-manifest). Both files go through a DirectorySink,
+ * so they are only rewritten when their content changes.
+ */
+namespace BuildDeps {
+	// Makefile rule "outputs: inputs", as compilers write it with -MD
+	bool writeDepfile(const std::string& file, const std::vector<std::string>& outputs,
+		const std::vector<std::string>& inputs);
+	// JSON document { "inputs": [ ... ], "outputs": [ ... ] }
+	bool writeOutputManifest(const std::string& file, const std::vector<std::string>& outputs,
+		const std::vector<std::string>& inputs);
+};
+
+#endif /* BUILDDEPS_H */
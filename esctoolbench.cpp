@@ -0,0 +1,316 @@
+/**
+ * @file esctoolbench.cpp
+ *
+ * @brief Micro-benchmarks for the ESI parser, the SII encoder/decoder, the
+ * SSC writer and the template engine
+ *
+ * Every case runs a few warm-up rounds and is then timed per sample. The
+ * median, p99, min and max per operation are written as JSON, so runs can
+ * be compared across commits. Inputs come from the ESI generator, nothing
+ * but a writable temporary directory is needed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "esctool.h"
+#include "esctoolhelpers.h"
+#include "esixmlparsing.h"
+#include "sii.h"
+#include "siireader.h"
+#include "soesconfigwriter.h"
+#include "templateengine.h"
+#include "textemitter.h"
+#include "outputsink.h"
+#include "jsonwriter.h"
+#include "esigenerator.h"
+
+// Shipped templates, set by the build
+#ifndef ESCTOOL_TEMPLATE_DIR
+#define ESCTOOL_TEMPLATE_DIR "templates"
+#endif
+
+struct BenchResult {
+	std::string name;
+	unsigned int batch; // Operations per sample
+	unsigned long bytes; // Size of the input or output of one operation
+	std::vector<double> samples; // ns per operation
+};
+
+struct BenchOptions {
+	unsigned int iterations = 50;
+	unsigned int warmup = 5;
+	const char* filter = NULL;
+};
+
+static BenchOptions options;
+static std::vector<BenchResult> results;
+static volatile uint64_t benchsink; // Keeps results of pure functions alive
+
+/** Sends stdout to /dev/null while the chatty parser and writers run */
+class QuietStdout {
+public:
+	QuietStdout() {
+		fflush(stdout);
+		m_saved = dup(STDOUT_FILENO);
+		int devnull = open("/dev/null",O_WRONLY);
+		if(devnull >= 0) {
+			dup2(devnull,STDOUT_FILENO);
+			close(devnull);
+		}
+	};
+	~QuietStdout() {
+		fflush(stdout);
+		if(m_saved >= 0) {
+			dup2(m_saved,STDOUT_FILENO);
+			close(m_saved);
+		}
+	};
+private:
+	int m_saved;
+};
+
+// Runs fn batch times per sample, iterations samples after warmup samples.
+// Costly cases pass a divisor to run fewer iterations.
+template<typename F>
+static void bench(const char* name, unsigned long bytes, unsigned int batch, unsigned int divisor, F fn)
+{
+	if(NULL != options.filter && NULL == strstr(name,options.filter)) return;
+	fprintf(stderr,"%s...\n",name);
+	BenchResult r;
+	r.name = name;
+	r.batch = batch;
+	r.bytes = bytes;
+	unsigned int iterations = std::max(3u,options.iterations / divisor);
+	unsigned int warmup = std::max(1u,options.warmup / divisor);
+
+	QuietStdout quiet;
+	for(unsigned int i = 0; i < warmup; ++i)
+		for(unsigned int b = 0; b < batch; ++b) fn();
+	r.samples.reserve(iterations);
+	for(unsigned int i = 0; i < iterations; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		for(unsigned int b = 0; b < batch; ++b) fn();
+		auto end = std::chrono::steady_clock::now();
+		r.samples.push_back(std::chrono::duration<double,std::nano>(end - start).count() / batch);
+	}
+	results.push_back(r);
+}
+
+// Nearest rank percentile of sorted samples
+static double percentile(const std::vector<double>& sorted, const double p)
+{
+	size_t rank = (size_t)std::ceil(p * sorted.size());
+	return sorted[std::min(sorted.size(),std::max((size_t)1,rank)) - 1];
+}
+
+static void writeResults(FILE* f)
+{
+	JSONWriter json(true);
+	json.beginObject();
+	json.value("tool",APP_NAME "_bench");
+	json.value("version",APP_VERSION);
+	json.value("iterations",options.iterations);
+	json.value("warmup",options.warmup);
+	json.beginArray("results");
+	for(BenchResult& r : results) {
+		std::sort(r.samples.begin(),r.samples.end());
+		json.beginObject();
+		json.value("name",r.name);
+		json.value("samples",r.samples.size());
+		json.value("batch",r.batch);
+		if(r.bytes) json.value("bytes",r.bytes);
+		json.value("median_ns",percentile(r.samples,0.5));
+		json.value("p99_ns",percentile(r.samples,0.99));
+		json.value("min_ns",r.samples.front());
+		json.value("max_ns",r.samples.back());
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	json.write(f);
+}
+
+static bool writeFile(const std::string& file, const std::string& data)
+{
+	FILE* f = fopen(file.c_str(),"wb");
+	if(NULL == f) return false;
+	bool ok = fwrite(data.data(),1,data.size(),f) == data.size();
+	return 0 == fclose(f) && ok;
+}
+
+static void printUsage(const char* name)
+{
+	printf("Usage: %s [options]\n",name);
+	printf("\t-i/--iterations <n>\tTimed samples per case (default %u)\n",options.iterations);
+	printf("\t-w/--warmup <n>\t\tUntimed samples before timing (default %u)\n",options.warmup);
+	printf("\t-f/--filter <text>\tOnly run cases whose name contains text\n");
+	printf("\t-o/--output <file>\tWrite the JSON results to file instead of stdout\n");
+}
+
+int main(int argc, char* argv[])
+{
+	const char* output = NULL;
+	for(int i = 1; i < argc; ++i) {
+		if(i + 1 < argc && (0 == strcmp(argv[i],"-i") || 0 == strcmp(argv[i],"--iterations"))) {
+			options.iterations = std::max(1,atoi(argv[++i]));
+		} else
+		if(i + 1 < argc && (0 == strcmp(argv[i],"-w") || 0 == strcmp(argv[i],"--warmup"))) {
+			options.warmup = std::max(0,atoi(argv[++i]));
+		} else
+		if(i + 1 < argc && (0 == strcmp(argv[i],"-f") || 0 == strcmp(argv[i],"--filter"))) {
+			options.filter = argv[++i];
+		} else
+		if(i + 1 < argc && (0 == strcmp(argv[i],"-o") || 0 == strcmp(argv[i],"--output"))) {
+			output = argv[++i];
+		} else
+		{
+			printUsage(argv[0]);
+			return 0 == strcmp(argv[i],"-h") || 0 == strcmp(argv[i],"--help") ? 0 : 1;
+		}
+	}
+
+	char tmpdir[] = "/tmp/esctool_bench.XXXXXX";
+	if(NULL == mkdtemp(tmpdir)) {
+		fprintf(stderr,"Could not create a temporary directory\n");
+		return 1;
+	}
+	struct Input {
+		const char* name;
+		unsigned int objects;
+		unsigned int divisor;
+		std::string file = "";	// Written below
+		size_t size = 0;
+	};
+	Input inputs[] = {
+		{ "esixml/parse/small", 8, 1 },
+		{ "esixml/parse/medium", 1000, 5 },
+		{ "esixml/parse/huge", 20000, 25 },
+	};
+	for(Input& in : inputs) {
+		ESIGenerator::Params params;
+		params.objects = in.objects;
+		std::string xml;
+		ESIGenerator(params).generate(xml);
+		in.file = std::string(tmpdir) + "/" + std::to_string(in.objects) + ".xml";
+		in.size = xml.size();
+		if(!writeFile(in.file,xml)) {
+			fprintf(stderr,"Could not write '%s'\n",in.file.c_str());
+			return 1;
+		}
+	}
+
+	// Huge parses take long, hence the divisors keeping their number down
+	for(const Input& in : inputs) {
+		bench(in.name,in.size,1,in.divisor,[&in]() {
+			ESIXML esixml;
+			esixml.parse(in.file);
+			benchsink += esixml.getDevices().size();
+		});
+	}
+
+	const char* hexdec[] = { "#x1A00", "4096", "0x6000", "#x00001337", "255", "#x7FFFFFFF" };
+	bench("helpers/hexdecstr2uint32",0,1024,1,[&hexdec]() {
+		static unsigned int n = 0;
+		benchsink += hexdecstr2uint32(hexdec[n++ % (sizeof(hexdec)/sizeof(hexdec[0]))]);
+	});
+
+	uint8_t configdata[EC_SII_CONFIGDATA_SIZEB] = { 0x05, 0x0E, 0x03, 0x44, 0x0A };
+	bench("helpers/crc8",EC_SII_CONFIGDATA_SIZEB - 2,1024,1,[&configdata]() {
+		benchsink += crc8(configdata,EC_SII_CONFIGDATA_SIZEB - 2);
+	});
+
+	// The rest works on the medium device
+	ESIXML esixml;
+	Device* dev = NULL;
+	std::vector<uint8_t> eeprom;
+	{
+		QuietStdout quiet;
+		esixml.parse(inputs[1].file);
+		if(!esixml.getDevices().empty()) dev = esixml.getDevices().front();
+		if(NULL != dev && !SII::encodeEEPROM(esixml.getVendorID(),dev,true,eeprom)) dev = NULL;
+	}
+	if(NULL == dev) {
+		fprintf(stderr,"Could not parse and encode the generated ESI file\n");
+		return 1;
+	}
+	bench("sii/encode",eeprom.size(),1,1,[&esixml,dev,&eeprom]() {
+		SII::encodeEEPROM(esixml.getVendorID(),dev,true,eeprom);
+		benchsink += eeprom.size();
+	});
+
+	JSONWriter json;
+	bench("sii/decode",eeprom.size(),1,1,[&eeprom,&json]() {
+		json.clear();
+		SII::Reader reader(SII::ByteSpan(eeprom.data(),eeprom.size()));
+		SII::writeEEPROMJSON(reader,json);
+		benchsink += json.str().size();
+	});
+
+	MemorySink sink;
+	SOESConfigWriter writer("",false,&sink);
+	unsigned long written = 0;
+	{
+		QuietStdout quiet;
+		writer.writeSSCFiles(dev,{});
+	}
+	for(const auto& f : sink.files()) written += f.second.size();
+	bench("soes/writeSSCFiles",written,1,2,[&sink,&writer,dev]() {
+		sink.clear();
+		writer.writeSSCFiles(dev,{});
+		benchsink += sink.files().size();
+	});
+	bench("soes/writeSSCFiles/parallel",written,1,2,[&sink,&writer,dev]() {
+		sink.clear();
+		writer.writeSSCFiles(dev,{ .jobs = 0 });
+		benchsink += sink.files().size();
+	});
+
+	// The shipped templates of the files the writer wrote, so both make
+	// the same output
+	std::vector<std::pair<Template,const std::string*>> templates;
+	for(const auto& f : sink.files()) {
+		std::string error;
+		templates.emplace_back(Template(),&f.second);
+		if(!templates.back().first.load(std::string(ESCTOOL_TEMPLATE_DIR) + "/" + f.first + ".tpl",error)) {
+			fprintf(stderr,"Could not load the template of %s: %s\n",f.first.c_str(),error.c_str());
+			return 1;
+		}
+		TextEmitter out;
+		templates.back().first.render(dev,esixml.getVendorID(),out);
+		if(out.str() != f.second) {
+			fprintf(stderr,"The template of %s does not render what the writer wrote\n",f.first.c_str());
+			return 1;
+		}
+	}
+	bench("template/render",written,1,2,[&templates,&esixml,dev]() {
+		SOESValues values(dev);
+		for(const auto& t : templates) {
+			TextEmitter out(t.second->size());
+			t.first.render(dev,esixml.getVendorID(),out,&values);
+			benchsink += out.size();
+		}
+	});
+
+	for(const Input& in : inputs) unlink(in.file.c_str());
+	rmdir(tmpdir);
+
+	if(NULL != output) {
+		FILE* f = fopen(output,"w");
+		if(NULL == f) {
+			fprintf(stderr,"Could not open '%s' for writing\n",output);
+			return 1;
+		}
+		writeResults(f);
+		fclose(f);
+	} else writeResults(stdout);
+	return 0;
+}
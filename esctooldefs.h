@@ -149,19 +149,21 @@ struct Slot {
 	uint8_t slotno = 0;
 	uint8_t slotpdoincrement = 0;
 	uint8_t slotindexincrement = 0;
-	std::list<uint8_t> moduleidents;
+	const char* name = NULL;
+	std::list<uint32_t> moduleidents;
 };
 
 struct Slots {
-	uint8_t maxslotcount;
+	uint8_t maxslotcount = 0;
 	uint8_t slotpdoincrement = 0;
 	uint8_t slotindexincrement = 0;
 	std::list<Slot*> slots;
 };
 
 struct Module {
-	uint8_t ident;
-	const char* type;
+	uint32_t ident = 0;
+	const char* type = NULL;
+	const char* name = NULL;
 	std::list<Pdo*> txpdo;
 	std::list<Pdo*> rxpdo;
 };
@@ -0,0 +1,106 @@
+/**
+ * @file esctoolgen.cpp
+ *
+ * @brief Synthetic ESI generator for stress and scaling tests
+ *
+ * Writes a deterministic (per seed) ETG.2000 ESI file of configurable size,
+ * so parser, encoder and writer performance can be reproduced without
+ * vendor files.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <cstring>
+#include <string>
+
+#include "esigenerator.h"
+
+static void printUsage(const char* name)
+{
+	ESIGenerator::Params p;
+	printf("Usage: %s [options]\n",name);
+	printf("\t--seed <n>\t\tRandom seed, same seed gives the same file (default %llu)\n",(unsigned long long)p.seed);
+	printf("\t--devices <n>\t\tDevices in the file (default %u)\n",p.devices);
+	printf("\t--objects <n>\t\tDictionary objects per device, at most %u (default %u)\n",ESIGenerator::MaxObjects,p.objects);
+	printf("\t--records <percent>\tShare of record objects (default %u)\n",p.records);
+	printf("\t--arrays <percent>\tShare of array objects (default %u)\n",p.arrays);
+	printf("\t--subitems <n>\t\tMost members per record or array (default %u)\n",p.subitems);
+	printf("\t--rxpdos <n>\t\tRxPdos per device (default %u)\n",p.rxpdos);
+	printf("\t--txpdos <n>\t\tTxPdos per device (default %u)\n",p.txpdos);
+	printf("\t--entries <n>\t\tEntries per PDO (default %u)\n",p.entries);
+	printf("\t--modules <n>\t\tModule types, adds slots to every device (default %u)\n",p.modules);
+	printf("\t--slots <n>\t\tSlots of modular devices (default %u)\n",p.slots);
+	printf("\t--opmodes <n>\t\tDC opmodes besides free run (default %u)\n",p.opmodes);
+	printf("\t-o/--output <file>\tWrite to file instead of stdout\n");
+}
+
+int main(int argc, char* argv[])
+{
+	ESIGenerator::Params params;
+	const char* output = NULL;
+	struct {
+		const char* name;
+		unsigned int* value;
+	} counts[] = {
+		{ "--devices", &params.devices },
+		{ "--objects", &params.objects },
+		{ "--records", &params.records },
+		{ "--arrays", &params.arrays },
+		{ "--subitems", &params.subitems },
+		{ "--rxpdos", &params.rxpdos },
+		{ "--txpdos", &params.txpdos },
+		{ "--entries", &params.entries },
+		{ "--modules", &params.modules },
+		{ "--slots", &params.slots },
+		{ "--opmodes", &params.opmodes },
+	};
+
+	for(int i = 1; i < argc; ++i) {
+		bool handled = false;
+		if(i + 1 < argc) {
+			if(0 == strcmp(argv[i],"--seed")) {
+				params.seed = strtoull(argv[++i],NULL,0);
+				handled = true;
+			} else
+			if(0 == strcmp(argv[i],"-o") || 0 == strcmp(argv[i],"--output")) {
+				output = argv[++i];
+				handled = true;
+			} else
+			{
+				for(auto& c : counts) {
+					if(0 == strcmp(argv[i],c.name)) {
+						*c.value = (unsigned int)strtoul(argv[++i],NULL,0);
+						handled = true;
+						break;
+					}
+				}
+			}
+		}
+		if(!handled) {
+			printUsage(argv[0]);
+			return 0 == strcmp(argv[i],"-h") || 0 == strcmp(argv[i],"--help") ? 0 : 1;
+		}
+	}
+
+	ESIGenerator generator(params);
+	if(!generator.validate()) return 1;
+
+	std::string xml;
+	generator.generate(xml);
+
+	FILE* f = stdout;
+	if(NULL != output) {
+		f = fopen(output,"wb");
+		if(NULL == f) {
+			fprintf(stderr,"Could not open '%s' for writing\n",output);
+			return 1;
+		}
+	}
+	bool ok = fwrite(xml.data(),1,xml.size(),f) == xml.size();
+	if(NULL != output && 0 != fclose(f)) ok = false;
+	if(!ok) {
+		fprintf(stderr,"Failed writing the ESI file\n");
+		return 1;
+	}
+	return 0;
+}
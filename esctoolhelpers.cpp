@@ -1,4 +1,5 @@
 #include "esctoolhelpers.h"
+#include "esctooldefs.h"
 #include <cstdio>
 
 uint8_t getCoEDataType(const char* dt) {
@@ -44,21 +45,143 @@ const char* getCategoryString(const uint16_t category) {
 	return "NULL";
 };
 
-unsigned char crc8(unsigned char* ptr, unsigned char len)
-{
-	unsigned char i;
-	unsigned char crc = 0xff;/*  The initial of the calculation crc value  */
+// True for the categories getCategoryString() has a name for
+bool isKnownCategory(const uint16_t category) {
+	switch(category) {
+		case EEPROMCategorySTRINGS:
+		case EEPROMCategoryDataTypes:
+		case EEPROMCategoryGeneral:
+		case EEPROMCategoryFMMU:
+		case EEPROMCategorySyncM:
+		case EEPROMCategoryFMMUX:
+		case EEPROMCategorySyncUnit:
+		case EEPROMCategoryTXPDO:
+		case EEPROMCategoryRXPDO:
+		case EEPROMCategoryDC:
+		case EEPROMCategoryTimeouts:
+		case EEPROMCategoryDictionary:
+		case EEPROMCategoryHardware:
+		case EEPROMCategoryVendorInformation:
+		case EEPROMCategoryImages:
+			return true;
+	}
+	return false;
+};
+
+// SII SyncM category type (ETG2010 Table 9)
+uint8_t getSyncManagerType(const char* type) {
+	if(NULL == type) return 0x0;
+	if(0 == strcmp(type,"MBoxOut")) return 0x1;
+	if(0 == strcmp(type,"MBoxIn")) return 0x2;
+	if(0 == strcmp(type,"Outputs")) return 0x3;
+	if(0 == strcmp(type,"Inputs")) return 0x4;
+	return 0x0;
+};
 
-	while (len--)
-	{
-		crc ^= *ptr++;  /*  XOR with the data to be calculated each time , After calculation, point to the next data  */
-		for (i = 8; i > 0; --i)   /*  The following calculation process is the same as calculating a byte crc equally  */
-		{
-			if (crc & 0x80) crc = (crc << 1) ^ 0x07;// polynomial
-			else crc = (crc << 1);
+// SII FMMU category usage (ETG2010 Table 8)
+uint8_t getFMMUType(const char* type) {
+	if(NULL == type) return 0x0;
+	if(0 == strcmp(type,"Outputs")) return 0x1;
+	if(0 == strcmp(type,"Inputs")) return 0x2;
+	if(0 == strcmp(type,"MBoxState")) return 0x3;
+	return 0x0;
+};
+
+// Physical port nibbles of the General category from Device@Physics
+uint16_t getPhysicalPortConfig(const char* physics) {
+	uint16_t physicalport = 0x0;
+	if(NULL == physics) return physicalport;
+	for(uint8_t ppidx = 0; ppidx < 4 && physics[ppidx] != '\0'; ++ppidx) {
+		// 0x00: not use
+		// 0x01: MII
+		// 0x02: reserved
+		// 0x03: EBUS
+		// 0x04: Fast Hot Connect
+		switch (physics[ppidx]){
+			case 'Y':
+				physicalport |= 0x1 << (ppidx*4);
+			break;
+			case 'K': // LVDS, EBUS? TODO
+				physicalport |= 0x3 << (ppidx*4);
+			break;
+			case 'H':
+				physicalport |= 0x4 << (ppidx*4);
+			break;
+			case ' ':
+				physicalport |= 0x0 << (ppidx*4);
+			break;
 		}
 	}
-	return (crc);
+	return physicalport;
+};
+
+// SII mailbox protocol word (ETG2010 Table 2)
+uint16_t getMailboxProtocols(const Mailbox* mailbox) {
+	uint16_t proto = 0x0;
+	if(NULL == mailbox) return proto;
+	if(mailbox->aoe) proto |= 0x0001;
+	if(mailbox->eoe) proto |= 0x0002;
+	if(mailbox->coe) proto |= 0x0004;
+	if(mailbox->foe) proto |= 0x0008;
+	if(mailbox->soe) proto |= 0x0010;
+	if(mailbox->voe) proto |= 0x0020;
+	return proto;
+};
+
+// CoE details of the General category (ETG2000 Table 7)
+uint8_t getCoEDetails(const Mailbox* mailbox) {
+	uint8_t details = 0x0;
+	if(NULL == mailbox) return details;
+	details |= mailbox->coe ? 0x1 : 0x0;
+	details |= mailbox->coe_sdoinfo ? (0x1 << 1) : 0x0;
+	details |= mailbox->coe_pdoassign ? (0x1 << 2) : 0x0;
+	details |= mailbox->coe_pdoconfig ? (0x1 << 3) : 0x0;
+	details |= mailbox->coe_pdoupload ? (0x1 << 4) : 0x0;
+	details |= mailbox->coe_completeaccess ? (0x1 << 5) : 0x0;
+	return details;
+};
+
+// Flags of the General category, only those the ESI model knows about
+uint8_t getGeneralFlags(const Mailbox* mailbox) {
+	uint8_t flags = 0x0;
+	// flags |= StartToSafeopNoSync ? 0x1 : 0x0; // TODO Esi:Info:StateMachine:Behavior:StartToSafeopNoSync
+	// flags |= Enable notLRW ? (0x1 << 1) : 0x0; // TODO Esi:DeviceType:Type
+	if(mailbox && mailbox->datalinklayer)
+		flags |= (0x1 << 2);
+	// flags |= Identification ? (0x1 << 3) : 0x0; // TODO ETG2000 Table 8
+	// flags |= Identification ? (0x1 << 4) : 0x0; // TODO ETG2000 Table 8
+	return flags;
+};
+
+// Flags of a TXPDO/RXPDO category
+uint16_t getPdoFlags(const Pdo* pdo) {
+	uint16_t flags = 0x0;
+	if(pdo->mandatory) flags |= 0x0001;
+	if(pdo->fixed) flags |= 0x0010;
+	// TODO more flags...
+	return flags;
+};
+
+// CRC8 (polynomial 0x07, initial value 0xFF) lookup table, generated at
+// compile time so the hot loop is a single table lookup per byte
+struct CRC8Table {
+	uint8_t t[256];
+	constexpr CRC8Table() : t() {
+		for(int i = 0; i < 256; ++i) {
+			uint8_t crc = i;
+			for(int b = 0; b < 8; ++b)
+				crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+			t[i] = crc;
+		}
+	}
+};
+static constexpr CRC8Table crc8table;
+
+uint8_t crc8(const uint8_t* ptr, size_t len)
+{
+	uint8_t crc = 0xff; /*  The initial of the calculation crc value  */
+	while (len--) crc = crc8table.t[crc ^ *ptr++];
+	return crc;
 };
 
 uint32_t hexdecstr2uint32(const char* s) {
@@ -4,6 +4,9 @@
 #include <cstring>
 #include "esidefs.h"
 
+struct Mailbox;
+struct Pdo;
+
 const char BOOLstr[]		= "BOOL";
 const char BITstr[]		= "BOOL";
 const char SINTstr[]		= "SINT";
@@ -31,7 +34,15 @@ const char subIndex000Str[]	= "SubIndex 000";
 
 uint8_t getCoEDataType(const char* dt);
 const char* getCategoryString(const uint16_t category);
-unsigned char crc8(unsigned char* ptr, unsigned char len);
+bool isKnownCategory(const uint16_t category);
+uint8_t getSyncManagerType(const char* type);
+uint8_t getFMMUType(const char* type);
+uint16_t getPhysicalPortConfig(const char* physics);
+uint16_t getMailboxProtocols(const Mailbox* mailbox);
+uint8_t getCoEDetails(const Mailbox* mailbox);
+uint8_t getGeneralFlags(const Mailbox* mailbox);
+uint16_t getPdoFlags(const Pdo* pdo);
+uint8_t crc8(const uint8_t* ptr, size_t len);
 
 uint32_t hexdecstr2uint32(const char* s);
 uint32_t EC_SII_HexToUint32(const char* s);
@@ -11,6 +11,7 @@
 #define ESI_DEVICE_PRODUCTCODE_ATTR_NAME	"ProductCode"
 #define ESI_DEVICE_REVISIONNO_ATTR_NAME		"RevisionNo"
 
+#define EC_SII_CONFIGDATA_CHECKSUM_OFFSET_BYTE	(0x07 * 2)
 #define EC_SII_EEPROM_VENDOR_OFFSET_BYTE	(0x08 * 2)
 #define EC_SII_EEPROM_MAILBOX_OUT_OFFSET_BYTE	(0x18 * 2)
 #define EC_SII_EEPROM_MAILBOX_IN_OFFSET_BYTE	(0x1A * 2)
@@ -0,0 +1,360 @@
+#include "esigenerator.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include "esctoolhelpers.h"
+
+struct BaseType {
+	const char* name;
+	unsigned int bits;
+};
+
+static const BaseType baseTypes[] = {
+	{ SINTstr, 8 },
+	{ INTstr, 16 },
+	{ DINTstr, 32 },
+	{ USINTstr, 8 },
+	{ UINTstr, 16 },
+	{ UDINTstr, 32 },
+	{ ULINTstr, 64 },
+};
+static const unsigned int baseTypeCount = sizeof(baseTypes) / sizeof(baseTypes[0]);
+
+// Names are made unique with a number, C identifiers are derived from them
+static const char* words[] = {
+	"Position", "Velocity", "Torque", "Current", "Voltage", "Temperature",
+	"Pressure", "Status", "Control", "Counter", "Setpoint", "Limit",
+};
+static const unsigned int wordCount = sizeof(words) / sizeof(words[0]);
+
+static void emit(std::string& xml, const char* fmt, ...) __attribute__((format(printf,2,3)));
+static void emit(std::string& xml, const char* fmt, ...)
+{
+	char buf[512];
+	va_list ap;
+	va_start(ap,fmt);
+	int n = vsnprintf(buf,sizeof(buf),fmt,ap);
+	va_end(ap);
+	if(n < 0) return;
+	if((size_t)n < sizeof(buf)) {
+		xml.append(buf,n);
+		return;
+	}
+	size_t len = xml.size();
+	xml.resize(len + n + 1);
+	va_start(ap,fmt);
+	vsnprintf(&xml[len],n + 1,fmt,ap);
+	va_end(ap);
+	xml.resize(len + n);
+}
+
+// Zero DefaultData of a type, two hex digits per byte
+static std::string zeroes(const unsigned int bits)
+{
+	return std::string((bits + 7) / 8 * 2,'0');
+}
+
+// The bitsize esctool expects for a constructed type: subindex 0 plus
+// padding (16), the members, rounded like main.cpp validates it
+static unsigned int constructedBits(const unsigned int members)
+{
+	unsigned int bits = 16 + members;
+	return bits + bits % 16;
+}
+
+uint64_t ESIGenerator::next(void)
+{
+	uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+unsigned int ESIGenerator::range(unsigned int lo, unsigned int hi)
+{
+	if(hi <= lo) return lo;
+	return lo + (unsigned int)(next() % (hi - lo + 1));
+}
+
+bool ESIGenerator::validate(void) const
+{
+	const Params& p = m_params;
+	bool ok = true;
+	if(0 == p.devices) {
+		fprintf(stderr,"At least one device is needed\n");
+		ok = false;
+	}
+	if(p.objects > MaxObjects) {
+		fprintf(stderr,"At most %u objects fit a device (0x2000-0xFFFF)\n",MaxObjects);
+		ok = false;
+	}
+	if(p.records + p.arrays > 100) {
+		fprintf(stderr,"Records and arrays can not be more than 100%% of the objects\n");
+		ok = false;
+	}
+	if(0 == p.subitems || p.subitems > 254) {
+		fprintf(stderr,"Records and arrays need 1 to 254 subitems\n");
+		ok = false;
+	}
+	if(p.rxpdos > MaxPdos || p.txpdos > MaxPdos) {
+		fprintf(stderr,"At most %u PDOs per direction\n",MaxPdos);
+		ok = false;
+	}
+	if(p.entries > 255) {
+		fprintf(stderr,"At most 255 entries per PDO\n");
+		ok = false;
+	}
+	// esctool can not synthesize the dictionary of empty PDOs
+	if((p.rxpdos || p.txpdos) && (0 == p.entries || 0 == p.objects)) {
+		fprintf(stderr,"PDOs need at least one entry and objects to map\n");
+		ok = false;
+	}
+	if(p.modules > MaxModules) {
+		fprintf(stderr,"At most %u module types\n",MaxModules);
+		ok = false;
+	}
+	if(p.modules && (0 == p.slots || p.slots > 255)) {
+		fprintf(stderr,"Modular devices need 1 to 255 slots\n");
+		ok = false;
+	}
+	return ok;
+}
+
+void ESIGenerator::generate(std::string& xml)
+{
+	m_state = m_params.seed;
+	emit(xml,"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	emit(xml,"<!-- Generated by esctool_gen, seed %llu -->\n",(unsigned long long)m_params.seed);
+	emit(xml,"<EtherCATInfo Version=\"1.11\">\n");
+	emit(xml,"\t<Vendor>\n\t\t<Id>#x00000EE5</Id>\n\t\t<Name>Synthetic Devices</Name>\n\t</Vendor>\n");
+	emit(xml,"\t<Descriptions>\n");
+	emit(xml,"\t\t<Groups>\n\t\t\t<Group>\n\t\t\t\t<Type>Synthetic</Type>\n\t\t\t\t<Name>Synthetic devices</Name>\n\t\t\t</Group>\n\t\t</Groups>\n");
+	emit(xml,"\t\t<Devices>\n");
+	for(unsigned int d = 0; d < m_params.devices; ++d) generateDevice(xml,d);
+	emit(xml,"\t\t</Devices>\n");
+	if(m_params.modules) generateModules(xml);
+	emit(xml,"\t</Descriptions>\n");
+	emit(xml,"</EtherCATInfo>\n");
+}
+
+void ESIGenerator::generateModules(std::string& xml)
+{
+	emit(xml,"\t\t<Modules>\n");
+	for(unsigned int m = 1; m <= m_params.modules; ++m) {
+		emit(xml,"\t\t\t<Module>\n");
+		emit(xml,"\t\t\t\t<Type ModuleIdent=\"#x%.08X\">Module%u</Type>\n",m,m);
+		emit(xml,"\t\t\t\t<Name>Module %u</Name>\n",m);
+		// Slot relative, index = index + slot * SlotIndexIncrement
+		for(const char* element : { "RxPdo", "TxPdo" }) {
+			bool rx = 0 == strcmp(element,"RxPdo");
+			emit(xml,"\t\t\t\t<%s Fixed=\"1\" Sm=\"%u\">\n",element,rx ? 2 : 3);
+			emit(xml,"\t\t\t\t\t<Index DependOnSlot=\"1\">#x%.04X</Index>\n",rx ? 0x1700 : 0x1B00);
+			emit(xml,"\t\t\t\t\t<Name>Module %u %s</Name>\n",m,rx ? "outputs" : "inputs");
+			unsigned int entries = range(1,m_params.entries ? m_params.entries : 1);
+			for(unsigned int e = 1; e <= entries; ++e) {
+				const BaseType& t = baseTypes[range(0,baseTypeCount - 1)];
+				emit(xml,"\t\t\t\t\t<Entry>\n");
+				emit(xml,"\t\t\t\t\t\t<Index DependOnSlot=\"1\">#x%.04X</Index>\n",rx ? 0x7000 : 0x6000);
+				emit(xml,"\t\t\t\t\t\t<SubIndex>%u</SubIndex>\n",e);
+				emit(xml,"\t\t\t\t\t\t<BitLen>%u</BitLen>\n",t.bits);
+				emit(xml,"\t\t\t\t\t\t<Name>%s %u</Name>\n",rx ? "Output" : "Input",e);
+				emit(xml,"\t\t\t\t\t\t<DataType>%s</DataType>\n",t.name);
+				emit(xml,"\t\t\t\t\t</Entry>\n");
+			}
+			emit(xml,"\t\t\t\t</%s>\n",element);
+		}
+		emit(xml,"\t\t\t</Module>\n");
+	}
+	emit(xml,"\t\t</Modules>\n");
+}
+
+void ESIGenerator::generatePdos(std::string& xml, const char* element, uint16_t index,
+	unsigned int count, unsigned int sm, const std::vector<Mappable>& mappable)
+{
+	// 16 bit mappables, to keep the mapping 16 bit aligned
+	std::vector<const Mappable*> words;
+	for(const Mappable& m : mappable)
+		if(16 == m.bits) words.push_back(&m);
+
+	for(unsigned int p = 0; p < count; ++p, ++index) {
+		emit(xml,"\t\t\t\t<%s Fixed=\"1\" Mandatory=\"1\" Sm=\"%u\">\n",element,sm);
+		emit(xml,"\t\t\t\t\t<Index>#x%.04X</Index>\n",index);
+		emit(xml,"\t\t\t\t\t<Name>%s %u</Name>\n",0x1600 == (index & 0xFE00) ? "Outputs" : "Inputs",p);
+		std::vector<const Mappable*> entries;
+		unsigned int bits = 0;
+		for(unsigned int e = 0; e < m_params.entries; ++e) {
+			entries.push_back(&mappable[range(0,mappable.size() - 1)]);
+			bits += entries.back()->bits;
+		}
+		// esctool pads the synthesized mapping type to 16 bits, which only
+		// matches its bitsize check if the entries add up to whole words.
+		// Types are 8 bit or multiples of 16, so one byte entry is swapped
+		// for a word, or doubled when there are no words to map
+		if(bits % 16) {
+			for(size_t e = entries.size(); e-- > 0;) {
+				if(8 != entries[e]->bits) continue;
+				if(!words.empty()) entries[e] = words[range(0,words.size() - 1)];
+				else if(entries.size() < 255) entries.push_back(entries[e]);
+				else entries.erase(entries.begin() + e);
+				break;
+			}
+		}
+		for(const Mappable* entry : entries) {
+			const Mappable& m = *entry;
+			emit(xml,"\t\t\t\t\t<Entry>\n");
+			emit(xml,"\t\t\t\t\t\t<Index>#x%.04X</Index>\n",m.index);
+			emit(xml,"\t\t\t\t\t\t<SubIndex>%u</SubIndex>\n",m.subindex);
+			emit(xml,"\t\t\t\t\t\t<BitLen>%u</BitLen>\n",m.bits);
+			emit(xml,"\t\t\t\t\t\t<Name>%s</Name>\n",m.name.c_str());
+			emit(xml,"\t\t\t\t\t\t<DataType>%s</DataType>\n",m.type);
+			emit(xml,"\t\t\t\t\t</Entry>\n");
+		}
+		emit(xml,"\t\t\t\t</%s>\n",element);
+	}
+}
+
+void ESIGenerator::generateDevice(std::string& xml, unsigned int devno)
+{
+	const Params& p = m_params;
+	char name[64];
+	snprintf(name,sizeof(name),"Synthetic device %u",devno);
+
+	std::string types;
+	std::string objects;
+	std::vector<Mappable> mappable;
+
+	for(const BaseType& t : baseTypes)
+		emit(types,"\t\t\t\t\t\t<DataType>\n\t\t\t\t\t\t\t<Name>%s</Name>\n\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n\t\t\t\t\t\t</DataType>\n",t.name,t.bits);
+	emit(types,"\t\t\t\t\t\t<DataType>\n\t\t\t\t\t\t\t<Name>STRING(%lu)</Name>\n\t\t\t\t\t\t\t<BitSize>%lu</BitSize>\n\t\t\t\t\t\t</DataType>\n",
+		strlen(name),strlen(name) * 8);
+
+	emit(objects,"\t\t\t\t\t\t<Object>\n\t\t\t\t\t\t\t<Index>#x1000</Index>\n\t\t\t\t\t\t\t<Name>%s</Name>\n\t\t\t\t\t\t\t<Type>UDINT</Type>\n"
+		"\t\t\t\t\t\t\t<BitSize>32</BitSize>\n\t\t\t\t\t\t\t<Info>\n\t\t\t\t\t\t\t\t<DefaultData>00001389</DefaultData>\n\t\t\t\t\t\t\t</Info>\n"
+		"\t\t\t\t\t\t\t<Flags>\n\t\t\t\t\t\t\t\t<Access>ro</Access>\n\t\t\t\t\t\t\t</Flags>\n\t\t\t\t\t\t</Object>\n",devTypeStr);
+	emit(objects,"\t\t\t\t\t\t<Object>\n\t\t\t\t\t\t\t<Index>#x1008</Index>\n\t\t\t\t\t\t\t<Name>%s</Name>\n\t\t\t\t\t\t\t<Type>STRING(%lu)</Type>\n"
+		"\t\t\t\t\t\t\t<BitSize>%lu</BitSize>\n\t\t\t\t\t\t\t<Info>\n\t\t\t\t\t\t\t\t<DefaultString>%s</DefaultString>\n\t\t\t\t\t\t\t</Info>\n"
+		"\t\t\t\t\t\t\t<Flags>\n\t\t\t\t\t\t\t\t<Access>ro</Access>\n\t\t\t\t\t\t\t</Flags>\n\t\t\t\t\t\t</Object>\n",
+		devNameStr,strlen(name),strlen(name) * 8,name);
+
+	for(unsigned int o = 0; o < p.objects; ++o) {
+		uint16_t index = 0x2000 + o;
+		unsigned int kind = range(0,99);
+		const char* access = range(0,1) ? "rw" : "ro";
+		char oname[64];
+		snprintf(oname,sizeof(oname),"%s %u",words[range(0,wordCount - 1)],o);
+
+		emit(objects,"\t\t\t\t\t\t<Object>\n\t\t\t\t\t\t\t<Index>#x%.04X</Index>\n\t\t\t\t\t\t\t<Name>%s</Name>\n",index,oname);
+		if(kind < p.arrays) {
+			const BaseType& t = baseTypes[range(0,baseTypeCount - 1)];
+			unsigned int elements = range(1,p.subitems);
+			// Keep the array 16 bit aligned, esctool warns otherwise
+			if(elements * t.bits % 16) ++elements;
+			unsigned int bits = constructedBits(elements * t.bits);
+			emit(types,"\t\t\t\t\t\t<DataType>\n\t\t\t\t\t\t\t<Name>DT%.04XARR</Name>\n\t\t\t\t\t\t\t<BaseType>%s</BaseType>\n"
+				"\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n\t\t\t\t\t\t\t<ArrayInfo>\n\t\t\t\t\t\t\t\t<LBound>1</LBound>\n"
+				"\t\t\t\t\t\t\t\t<Elements>%u</Elements>\n\t\t\t\t\t\t\t</ArrayInfo>\n\t\t\t\t\t\t</DataType>\n",
+				index,t.name,elements * t.bits,elements);
+			emit(types,"\t\t\t\t\t\t<DataType>\n\t\t\t\t\t\t\t<Name>DT%.04X</Name>\n\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n"
+				"\t\t\t\t\t\t\t<SubItem>\n\t\t\t\t\t\t\t\t<SubIdx>0</SubIdx>\n\t\t\t\t\t\t\t\t<Name>%s</Name>\n\t\t\t\t\t\t\t\t<Type>USINT</Type>\n"
+				"\t\t\t\t\t\t\t\t<BitSize>8</BitSize>\n\t\t\t\t\t\t\t\t<BitOffs>0</BitOffs>\n\t\t\t\t\t\t\t</SubItem>\n"
+				"\t\t\t\t\t\t\t<SubItem>\n\t\t\t\t\t\t\t\t<Name>Elements</Name>\n\t\t\t\t\t\t\t\t<Type>DT%.04XARR</Type>\n"
+				"\t\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n\t\t\t\t\t\t\t\t<BitOffs>16</BitOffs>\n\t\t\t\t\t\t\t</SubItem>\n\t\t\t\t\t\t</DataType>\n",
+				index,bits,subIndex000Str,index,elements * t.bits);
+			emit(objects,"\t\t\t\t\t\t\t<Type>DT%.04X</Type>\n\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n\t\t\t\t\t\t\t<Info>\n",index,bits);
+			emit(objects,"\t\t\t\t\t\t\t\t<SubItem>\n\t\t\t\t\t\t\t\t\t<Name>%s</Name>\n\t\t\t\t\t\t\t\t\t<Info>\n"
+				"\t\t\t\t\t\t\t\t\t\t<DefaultData>%.02X</DefaultData>\n\t\t\t\t\t\t\t\t\t</Info>\n\t\t\t\t\t\t\t\t</SubItem>\n",
+				subIndex000Str,elements);
+			for(unsigned int e = 1; e <= elements; ++e) {
+				emit(objects,"\t\t\t\t\t\t\t\t<SubItem>\n\t\t\t\t\t\t\t\t\t<Name>%s %u</Name>\n\t\t\t\t\t\t\t\t\t<Info>\n"
+					"\t\t\t\t\t\t\t\t\t\t<DefaultData>%s</DefaultData>\n\t\t\t\t\t\t\t\t\t</Info>\n\t\t\t\t\t\t\t\t</SubItem>\n",
+					oname,e,zeroes(t.bits).c_str());
+				mappable.push_back({ index, (uint8_t)e, t.name, t.bits, std::string(oname) + " " + std::to_string(e) });
+			}
+			emit(objects,"\t\t\t\t\t\t\t</Info>\n");
+		} else
+		if(kind < p.arrays + p.records) {
+			unsigned int members = range(1,p.subitems);
+			std::vector<const BaseType*> mt;
+			unsigned int sum = 0;
+			for(unsigned int m = 0; m < members; ++m) {
+				mt.push_back(&baseTypes[range(0,baseTypeCount - 1)]);
+				sum += mt.back()->bits;
+			}
+			unsigned int bits = constructedBits(sum);
+			emit(types,"\t\t\t\t\t\t<DataType>\n\t\t\t\t\t\t\t<Name>DT%.04X</Name>\n\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n"
+				"\t\t\t\t\t\t\t<SubItem>\n\t\t\t\t\t\t\t\t<SubIdx>0</SubIdx>\n\t\t\t\t\t\t\t\t<Name>%s</Name>\n\t\t\t\t\t\t\t\t<Type>USINT</Type>\n"
+				"\t\t\t\t\t\t\t\t<BitSize>8</BitSize>\n\t\t\t\t\t\t\t\t<BitOffs>0</BitOffs>\n\t\t\t\t\t\t\t</SubItem>\n",
+				index,bits,subIndex000Str);
+			unsigned int offset = 16;
+			for(unsigned int m = 1; m <= members; ++m) {
+				emit(types,"\t\t\t\t\t\t\t<SubItem>\n\t\t\t\t\t\t\t\t<SubIdx>%u</SubIdx>\n\t\t\t\t\t\t\t\t<Name>Member %u</Name>\n"
+					"\t\t\t\t\t\t\t\t<Type>%s</Type>\n\t\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n\t\t\t\t\t\t\t\t<BitOffs>%u</BitOffs>\n\t\t\t\t\t\t\t</SubItem>\n",
+					m,m,mt[m-1]->name,mt[m-1]->bits,offset);
+				offset += mt[m-1]->bits;
+			}
+			emit(types,"\t\t\t\t\t\t</DataType>\n");
+			emit(objects,"\t\t\t\t\t\t\t<Type>DT%.04X</Type>\n\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n\t\t\t\t\t\t\t<Info>\n",index,bits);
+			emit(objects,"\t\t\t\t\t\t\t\t<SubItem>\n\t\t\t\t\t\t\t\t\t<Name>%s</Name>\n\t\t\t\t\t\t\t\t\t<Info>\n"
+				"\t\t\t\t\t\t\t\t\t\t<DefaultData>%.02X</DefaultData>\n\t\t\t\t\t\t\t\t\t</Info>\n\t\t\t\t\t\t\t\t</SubItem>\n",
+				subIndex000Str,members);
+			for(unsigned int m = 1; m <= members; ++m) {
+				char mname[80];
+				snprintf(mname,sizeof(mname),"%s %s %u",oname,words[range(0,wordCount - 1)],m);
+				emit(objects,"\t\t\t\t\t\t\t\t<SubItem>\n\t\t\t\t\t\t\t\t\t<Name>%s</Name>\n\t\t\t\t\t\t\t\t\t<Info>\n"
+					"\t\t\t\t\t\t\t\t\t\t<DefaultData>%s</DefaultData>\n\t\t\t\t\t\t\t\t\t</Info>\n\t\t\t\t\t\t\t\t</SubItem>\n",
+					mname,zeroes(mt[m-1]->bits).c_str());
+				mappable.push_back({ index, (uint8_t)m, mt[m-1]->name, mt[m-1]->bits, mname });
+			}
+			emit(objects,"\t\t\t\t\t\t\t</Info>\n");
+		} else
+		{
+			const BaseType& t = baseTypes[range(0,baseTypeCount - 1)];
+			emit(objects,"\t\t\t\t\t\t\t<Type>%s</Type>\n\t\t\t\t\t\t\t<BitSize>%u</BitSize>\n\t\t\t\t\t\t\t<Info>\n"
+				"\t\t\t\t\t\t\t\t<DefaultData>%s</DefaultData>\n\t\t\t\t\t\t\t</Info>\n",t.name,t.bits,zeroes(t.bits).c_str());
+			mappable.push_back({ index, 0, t.name, t.bits, oname });
+		}
+		emit(objects,"\t\t\t\t\t\t\t<Flags>\n\t\t\t\t\t\t\t\t<Access>%s</Access>\n\t\t\t\t\t\t\t\t<PdoMapping>RT</PdoMapping>\n\t\t\t\t\t\t\t</Flags>\n\t\t\t\t\t\t</Object>\n",access);
+	}
+
+	emit(xml,"\t\t\t<Device Physics=\"YY\">\n");
+	emit(xml,"\t\t\t\t<Type ProductCode=\"#x%.08X\" RevisionNo=\"#x00010000\">SYN%.04u</Type>\n",devno + 1,devno);
+	emit(xml,"\t\t\t\t<Name>%s</Name>\n",name);
+	emit(xml,"\t\t\t\t<GroupType>Synthetic</GroupType>\n");
+	emit(xml,"\t\t\t\t<Profile>\n\t\t\t\t\t<Dictionary>\n\t\t\t\t\t\t<DataTypes>\n");
+	xml += types;
+	emit(xml,"\t\t\t\t\t\t</DataTypes>\n\t\t\t\t\t\t<Objects>\n");
+	xml += objects;
+	emit(xml,"\t\t\t\t\t\t</Objects>\n\t\t\t\t\t</Dictionary>\n\t\t\t\t</Profile>\n");
+	emit(xml,"\t\t\t\t<Fmmu>Outputs</Fmmu>\n\t\t\t\t<Fmmu>Inputs</Fmmu>\n\t\t\t\t<Fmmu>MBoxState</Fmmu>\n");
+	emit(xml,"\t\t\t\t<Sm DefaultSize=\"128\" StartAddress=\"#x1000\" ControlByte=\"#x26\" Enable=\"1\">MBoxOut</Sm>\n");
+	emit(xml,"\t\t\t\t<Sm DefaultSize=\"128\" StartAddress=\"#x1080\" ControlByte=\"#x22\" Enable=\"1\">MBoxIn</Sm>\n");
+	emit(xml,"\t\t\t\t<Sm StartAddress=\"#x1100\" ControlByte=\"#x64\" Enable=\"1\">Outputs</Sm>\n");
+	emit(xml,"\t\t\t\t<Sm StartAddress=\"#x1180\" ControlByte=\"#x20\" Enable=\"1\">Inputs</Sm>\n");
+	generatePdos(xml,"RxPdo",0x1600,p.rxpdos,2,mappable);
+	generatePdos(xml,"TxPdo",0x1A00,p.txpdos,3,mappable);
+	emit(xml,"\t\t\t\t<Mailbox DataLinkLayer=\"1\">\n\t\t\t\t\t<CoE SdoInfo=\"1\" PdoAssign=\"%u\" PdoConfig=\"0\" CompleteAccess=\"0\"/>\n\t\t\t\t</Mailbox>\n",
+		p.modules ? 1 : 0);
+	emit(xml,"\t\t\t\t<Dc>\n");
+	emit(xml,"\t\t\t\t\t<OpMode>\n\t\t\t\t\t\t<Name>FreeRun</Name>\n\t\t\t\t\t\t<Desc>FreeRun/SM-Synchron</Desc>\n\t\t\t\t\t\t<AssignActivate>#x0</AssignActivate>\n\t\t\t\t\t</OpMode>\n");
+	for(unsigned int o = 0; o < p.opmodes; ++o) {
+		emit(xml,"\t\t\t\t\t<OpMode>\n\t\t\t\t\t\t<Name>DC%u</Name>\n\t\t\t\t\t\t<Desc>DC-Synchron %u</Desc>\n",o,o);
+		emit(xml,"\t\t\t\t\t\t<AssignActivate>#x%s</AssignActivate>\n",o % 2 ? "700" : "300");
+		emit(xml,"\t\t\t\t\t\t<CycleTimeSync0 Factor=\"1\">0</CycleTimeSync0>\n\t\t\t\t\t\t<ShiftTimeSync0>%u</ShiftTimeSync0>\n",range(0,10) * 1000);
+		if(o % 2) emit(xml,"\t\t\t\t\t\t<CycleTimeSync1 Factor=\"1\">0</CycleTimeSync1>\n\t\t\t\t\t\t<ShiftTimeSync1>0</ShiftTimeSync1>\n");
+		emit(xml,"\t\t\t\t\t</OpMode>\n");
+	}
+	emit(xml,"\t\t\t\t</Dc>\n");
+	if(p.modules) {
+		emit(xml,"\t\t\t\t<Slots MaxSlotCount=\"%u\" SlotPdoIncrement=\"1\" SlotIndexIncrement=\"#x10\">\n",p.slots);
+		emit(xml,"\t\t\t\t\t<Slot MinInstances=\"0\" MaxInstances=\"%u\">\n\t\t\t\t\t\t<Name>Slot</Name>\n",p.slots);
+		for(unsigned int m = 1; m <= p.modules; ++m)
+			emit(xml,"\t\t\t\t\t\t<ModuleIdent>#x%.08X</ModuleIdent>\n",m);
+		emit(xml,"\t\t\t\t\t</Slot>\n\t\t\t\t</Slots>\n");
+	}
+	// Room for the PDO categories and their strings when they are encoded
+	unsigned int pdobytes = (p.rxpdos + p.txpdos) * (8 + p.entries * 8 + (1 + p.entries) * 32);
+	unsigned int eepromsize = 2048;
+	while(eepromsize < 1024 + pdobytes && eepromsize < 0x10000) eepromsize *= 2;
+	emit(xml,"\t\t\t\t<Eeprom>\n\t\t\t\t\t<ByteSize>%u</ByteSize>\n\t\t\t\t\t<ConfigData>050E03440A000000</ConfigData>\n\t\t\t\t</Eeprom>\n",eepromsize);
+	emit(xml,"\t\t\t</Device>\n");
+}
@@ -0,0 +1,68 @@
+#ifndef ESIGENERATOR_H
+#define ESIGENERATOR_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Synthetic ETG.2000 ESI files for stress and scaling tests. The output
+ * only depends on the parameters, the same seed always gives the same
+ * file. Devices get a dictionary of variables, records and arrays with
+ * their DT types, PDOs mapping into it, DC opmodes and optionally slots
+ * with modules.
+ */
+class ESIGenerator {
+public:
+	// Device specific objects live in 0x2000-0xFFFF
+	static const unsigned int MaxObjects = 0xE000;
+	// RxPdo 0x1600-0x17FF and TxPdo 0x1A00-0x1BFF
+	static const unsigned int MaxPdos = 0x200;
+	// Module types, every slot accepts each of them
+	static const unsigned int MaxModules = 0xFF;
+
+	struct Params {
+		uint64_t seed = 1;
+		unsigned int devices = 1;
+		unsigned int objects = 100; // Per device, not counting subitems
+		unsigned int records = 30; // Percent of the objects
+		unsigned int arrays = 20; // Percent of the objects
+		unsigned int subitems = 8; // Most members of a record or array
+		unsigned int rxpdos = 1;
+		unsigned int txpdos = 1;
+		unsigned int entries = 8; // Per PDO, as far as there are objects to map
+		unsigned int modules = 0; // Module types, more than 0 adds slots
+		unsigned int slots = 4;
+		unsigned int opmodes = 1; // DC opmodes besides free run
+	};
+
+	ESIGenerator(const Params& params) : m_params(params) {};
+
+	// Prints what is wrong with the parameters and returns false
+	bool validate(void) const;
+	// Appends the ESI XML to xml
+	void generate(std::string& xml);
+private:
+	// A PDO mappable object or subitem
+	struct Mappable {
+		uint16_t index;
+		uint8_t subindex;
+		const char* type;
+		unsigned int bits;
+		std::string name;
+	};
+
+	Params m_params;
+	uint64_t m_state;
+
+	// SplitMix64, fixed here so the output does not depend on the C++ library
+	uint64_t next(void);
+	// Uniform in [lo, hi]
+	unsigned int range(unsigned int lo, unsigned int hi);
+
+	void generateModules(std::string& xml);
+	void generateDevice(std::string& xml, unsigned int devno);
+	void generatePdos(std::string& xml, const char* element, uint16_t index, unsigned int count,
+		unsigned int sm, const std::vector<Mappable>& mappable);
+};
+
+#endif /* ESIGENERATOR_H */
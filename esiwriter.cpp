@@ -0,0 +1,331 @@
+#include "esiwriter.h"
+#include <cstdio>
+#include <set>
+#include "tinyxml2/tinyxml2.h"
+#include "esidefs.h"
+
+namespace {
+
+typedef tinyxml2::XMLPrinter Printer;
+
+// ESI hex notation, the parser reads most numbers only like this
+std::string hex(uint32_t v, int digits) {
+	char buf[16];
+	snprintf(buf,sizeof(buf),"#x%.*X",digits,v);
+	return buf;
+}
+
+// Missing strings are left out, the parser keeps them NULL then
+void element(Printer& p, const char* name, const char* text) {
+	if(NULL == text) return;
+	p.OpenElement(name);
+	p.PushText(text);
+	p.CloseElement();
+}
+
+void element(Printer& p, const char* name, const std::string& text) {
+	element(p,name,text.c_str());
+}
+
+void element(Printer& p, const char* name, unsigned int v) {
+	p.OpenElement(name);
+	p.PushText(v);
+	p.CloseElement();
+}
+
+void flag(Printer& p, const char* name, bool set) {
+	if(set) p.PushAttribute(name,"1");
+}
+
+void writeFlags(Printer& p, const ObjectFlags* flags, bool object) {
+	p.OpenElement("Flags");
+	if(flags->access) {
+		p.OpenElement("Access");
+		if(flags->access->readrestrictions) p.PushAttribute("ReadRestrictions",flags->access->readrestrictions);
+		if(flags->access->writerestrictions) p.PushAttribute("WriteRestrictions",flags->access->writerestrictions);
+		if(flags->access->access) p.PushText(flags->access->access);
+		p.CloseElement();
+	}
+	element(p,"Category",flags->category);
+	element(p,"PdoMapping",flags->pdomapping);
+	if(object) element(p,"SdoAccess",flags->sdoaccess);
+	p.CloseElement();
+}
+
+// What a subitem inherits from its parent is not repeated
+void writeDataType(Printer& p, const DataType* dt, const DataType* parent) {
+	p.OpenElement(parent ? "SubItem" : "DataType");
+	if(parent && dt->subindex) element(p,"SubIdx",dt->subindex);
+	element(p,"Name",dt->name);
+	element(p,"Type",dt->type);
+	element(p,"BaseType",dt->basetype);
+	if(dt->bitsize) element(p,"BitSize",dt->bitsize);
+	if(dt->bitoffset) element(p,"BitOffs",dt->bitoffset);
+	if(dt->arrayinfo) {
+		p.OpenElement("ArrayInfo");
+		element(p,"LBound",dt->arrayinfo->lowerbound);
+		element(p,"Elements",dt->arrayinfo->elements);
+		p.CloseElement();
+	}
+	for(const DataType* si : dt->subitems) writeDataType(p,si,dt);
+	if(dt->flags && (NULL == parent || dt->flags != parent->flags)) writeFlags(p,dt->flags,false);
+	p.CloseElement();
+}
+
+void writeObject(Printer& p, const Object* o) {
+	const Object* parent = o->parent;
+	p.OpenElement(parent ? "SubItem" : "Object");
+	if(NULL == parent || o->index != parent->index) element(p,"Index",hex(o->index,4));
+	element(p,"Name",o->name);
+	if(NULL == parent || o->type != parent->type) element(p,"Type",o->type);
+	if(o->bitsize) element(p,"BitSize",o->bitsize);
+	if(o->bitoffset) element(p,"BitOffs",o->bitoffset);
+	if(o->defaultstring || o->defaultdata || !o->subitems.empty()) {
+		p.OpenElement("Info");
+		element(p,"DefaultString",o->defaultstring);
+		element(p,"DefaultData",o->defaultdata);
+		for(const Object* si : o->subitems) writeObject(p,si);
+		p.CloseElement();
+	}
+	if(o->flags && (NULL == parent || o->flags != parent->flags)) writeFlags(p,o->flags,true);
+	p.CloseElement();
+}
+
+void writePdo(Printer& p, const char* name, const Pdo* pdo) {
+	p.OpenElement(name);
+	flag(p,"Fixed",pdo->fixed);
+	flag(p,"Mandatory",pdo->mandatory);
+	p.PushAttribute("Sm",pdo->syncmanager);
+	if(pdo->syncunit) p.PushAttribute("Su",pdo->syncunit);
+	p.OpenElement("Index");
+	flag(p,"DependOnSlot",pdo->dependonslot);
+	p.PushText(hex(pdo->index,4).c_str());
+	p.CloseElement();
+	element(p,"Name",pdo->name);
+	for(const PdoEntry* entry : pdo->entries) {
+		p.OpenElement("Entry");
+		p.OpenElement("Index");
+		flag(p,"DependOnSlot",entry->dependonslot);
+		p.PushText(hex(entry->index,4).c_str());
+		p.CloseElement();
+		// Padding has neither subindex nor name
+		if(entry->index) element(p,"SubIndex",entry->subindex);
+		element(p,"BitLen",entry->bitlen);
+		element(p,"Name",entry->name);
+		element(p,"DataType",entry->datatype);
+		p.CloseElement();
+	}
+	p.CloseElement();
+}
+
+void writeDc(Printer& p, const DistributedClock* dc) {
+	p.OpenElement("Dc");
+	for(const DcOpmode* opmode : dc->opmodes) {
+		p.OpenElement("OpMode");
+		element(p,"Name",opmode->name);
+		element(p,"Desc",opmode->desc);
+		element(p,"AssignActivate",hex(opmode->assignactivate,4));
+		if(opmode->cycletimesync0 || opmode->cycletimesync0factor) {
+			p.OpenElement("CycleTimeSync0");
+			if(opmode->cycletimesync0factor) p.PushAttribute("Factor",opmode->cycletimesync0factor);
+			p.PushText(opmode->cycletimesync0);
+			p.CloseElement();
+		}
+		if(opmode->shifttimesync0) element(p,"ShiftTimeSync0",opmode->shifttimesync0);
+		if(opmode->cycletimesync1 || opmode->cycletimesync1factor) {
+			p.OpenElement("CycleTimeSync1");
+			if(opmode->cycletimesync1factor) p.PushAttribute("Factor",opmode->cycletimesync1factor);
+			p.PushText(opmode->cycletimesync1);
+			p.CloseElement();
+		}
+		if(opmode->shifttimesync1) element(p,"ShiftTimeSync1",opmode->shifttimesync1);
+		p.CloseElement();
+	}
+	p.CloseElement();
+}
+
+void writeEeprom(Printer& p, const Device* dev) {
+	// The parser only sets the CRC byte when there was ConfigData, so
+	// all zero means there was none. Bytes past the seven words are
+	// only kept if the source had them
+	bool configdata = false;
+	for(unsigned int i = 0; i < EC_SII_CONFIGDATA_SIZEB; ++i)
+		if(dev->configdata[i]) configdata = true;
+	if(!configdata && 0 == dev->eepromsize) return;
+
+	p.OpenElement("Eeprom");
+	if(dev->eepromsize) element(p,"ByteSize",dev->eepromsize);
+	if(configdata) {
+		unsigned int len = EC_SII_CONFIGDATA_SIZEB - 2;
+		if(dev->configdata[EC_SII_CONFIGDATA_SIZEB - 1]) len = EC_SII_CONFIGDATA_SIZEB;
+		else while(len > 1 && 0 == dev->configdata[len - 1]) --len;
+		std::string data;
+		char buf[4];
+		for(unsigned int i = 0; i < len; ++i) {
+			snprintf(buf,sizeof(buf),"%.2X",dev->configdata[i]);
+			data += buf;
+		}
+		element(p,"ConfigData",data);
+	}
+	p.CloseElement();
+}
+
+};
+
+void ESIWriter::write(uint32_t vendorid, const char* vendorname, const Device* dev, std::string& xml) const {
+	Printer p(NULL,true);
+	p.PushHeader(false,true);
+	p.OpenElement(ESI_ROOTNODE_NAME);
+
+	p.OpenElement("Vendor");
+	element(p,"Id",hex(vendorid,8));
+	element(p,"Name",vendorname);
+	p.CloseElement();
+
+	p.OpenElement("Descriptions");
+	if(dev->group) {
+		p.OpenElement("Groups");
+		p.OpenElement("Group");
+		element(p,"Type",dev->group->type);
+		element(p,"Name",dev->group->name);
+		p.CloseElement();
+		p.CloseElement();
+	}
+
+	p.OpenElement("Devices");
+	p.OpenElement("Device");
+	if(dev->physics) p.PushAttribute("Physics",dev->physics);
+	p.OpenElement("Type");
+	p.PushAttribute("ProductCode",hex(dev->product_code,8).c_str());
+	p.PushAttribute("RevisionNo",hex(dev->revision_no,8).c_str());
+	if(dev->type) p.PushText(dev->type);
+	p.CloseElement();
+	element(p,"Name",dev->name);
+	if(dev->group) element(p,"GroupType",dev->group->type);
+
+	if((m_parts & KeepDictionary) && dev->profile && dev->profile->dictionary) {
+		p.OpenElement("Profile");
+		p.OpenElement("Dictionary");
+		p.OpenElement("DataTypes");
+		for(const DataType* dt : dev->profile->dictionary->datatypes) writeDataType(p,dt,NULL);
+		p.CloseElement();
+		p.OpenElement("Objects");
+		for(const Object* o : dev->profile->dictionary->objects) writeObject(p,o);
+		p.CloseElement();
+		p.CloseElement();
+		p.CloseElement();
+	}
+
+	for(const FMMU* fmmu : dev->fmmus) {
+		p.OpenElement("Fmmu");
+		if(fmmu->syncmanager >= 0) p.PushAttribute("Sm",fmmu->syncmanager);
+		if(fmmu->syncunit >= 0) p.PushAttribute("Su",fmmu->syncunit);
+		if(fmmu->type) p.PushText(fmmu->type);
+		p.CloseElement();
+	}
+	for(const SyncManager* sm : dev->syncmanagers) {
+		p.OpenElement("Sm");
+		if(sm->minsize) p.PushAttribute("MinSize",hex(sm->minsize,4).c_str());
+		if(sm->maxsize) p.PushAttribute("MaxSize",hex(sm->maxsize,4).c_str());
+		if(sm->defaultsize) p.PushAttribute("DefaultSize",(unsigned int)sm->defaultsize);
+		p.PushAttribute("StartAddress",hex(sm->startaddress,4).c_str());
+		p.PushAttribute("ControlByte",hex(sm->controlbyte,2).c_str());
+		flag(p,"Enable",sm->enable);
+		if(sm->type) p.PushText(sm->type);
+		p.CloseElement();
+	}
+	if(dev->syncunit) {
+		p.OpenElement("Su");
+		flag(p,"SeparateSu",dev->syncunit->separate_su);
+		flag(p,"SeparateFrame",dev->syncunit->separate_frame);
+		flag(p,"DependOnInputState",dev->syncunit->depend_on_input_state);
+		flag(p,"FrameRepeatSupport",dev->syncunit->frame_repeat_support);
+		p.CloseElement();
+	}
+	for(const Pdo* pdo : dev->rxpdo) writePdo(p,"RxPdo",pdo);
+	for(const Pdo* pdo : dev->txpdo) writePdo(p,"TxPdo",pdo);
+
+	if(dev->mailbox) {
+		const Mailbox* mb = dev->mailbox;
+		p.OpenElement("Mailbox");
+		flag(p,"DataLinkLayer",mb->datalinklayer);
+		if(mb->coe) {
+			p.OpenElement("CoE");
+			flag(p,"SdoInfo",mb->coe_sdoinfo);
+			flag(p,"PdoAssign",mb->coe_pdoassign);
+			flag(p,"PdoConfig",mb->coe_pdoconfig);
+			flag(p,"PdoUpload",mb->coe_pdoupload);
+			flag(p,"CompleteAccess",mb->coe_completeaccess);
+			p.CloseElement();
+		}
+		p.CloseElement();
+	}
+
+	if(dev->dc) writeDc(p,dev->dc);
+
+	// Modules accepted by a slot, all of them if no slot names any
+	std::set<uint32_t> idents;
+	bool modules = (m_parts & KeepModules) && dev->slots;
+	if(modules) {
+		p.OpenElement("Slots");
+		p.PushAttribute("MaxSlotCount",(unsigned int)dev->slots->maxslotcount);
+		if(dev->slots->slotpdoincrement) p.PushAttribute("SlotPdoIncrement",(unsigned int)dev->slots->slotpdoincrement);
+		if(dev->slots->slotindexincrement) p.PushAttribute("SlotIndexIncrement",hex(dev->slots->slotindexincrement,2).c_str());
+		for(const Slot* slot : dev->slots->slots) {
+			p.OpenElement("Slot");
+			if(slot->slotpdoincrement) p.PushAttribute("SlotPdoIncrement",(unsigned int)slot->slotpdoincrement);
+			if(slot->slotindexincrement) p.PushAttribute("SlotIndexIncrement",hex(slot->slotindexincrement,2).c_str());
+			// Name is required, a source without one gets the slot number
+			if(slot->name) element(p,"Name",slot->name);
+			else element(p,"Name","Slot " + std::to_string(slot->slotno));
+			for(uint32_t ident : slot->moduleidents) {
+				element(p,"ModuleIdent",hex(ident,8));
+				idents.insert(ident);
+			}
+			p.CloseElement();
+		}
+		p.CloseElement();
+	}
+
+	writeEeprom(p,dev);
+	p.CloseElement(); // Device
+	p.CloseElement(); // Devices
+
+	if(modules && dev->modules && !dev->modules->empty()) {
+		p.OpenElement("Modules");
+		for(const Module* module : *dev->modules) {
+			if(!idents.empty() && 0 == idents.count(module->ident)) continue;
+			p.OpenElement("Module");
+			p.OpenElement("Type");
+			p.PushAttribute("ModuleIdent",hex(module->ident,8).c_str());
+			if(module->type) p.PushText(module->type);
+			p.CloseElement();
+			// Name is required, a source without one gets the type
+			element(p,"Name",module->name ? module->name : module->type);
+			for(const Pdo* pdo : module->rxpdo) writePdo(p,"RxPdo",pdo);
+			for(const Pdo* pdo : module->txpdo) writePdo(p,"TxPdo",pdo);
+			p.CloseElement();
+		}
+		p.CloseElement();
+	}
+
+	p.CloseElement(); // Descriptions
+	p.CloseElement(); // EtherCATInfo
+	xml.append(p.CStr(),p.CStrSize() - 1);
+}
+
+bool ESIWriter::parseParts(const std::string& list, unsigned int& parts) {
+	parts = 0;
+	size_t start = 0;
+	while(start <= list.size()) {
+		size_t comma = list.find(',',start);
+		if(comma == std::string::npos) comma = list.size();
+		std::string name = list.substr(start,comma - start);
+		if(name == "dictionary") parts |= KeepDictionary;
+		else if(name == "modules") parts |= KeepModules;
+		else if(name == "all") parts |= KeepAll;
+		else if(!name.empty()) return false;
+		start = comma + 1;
+	}
+	return true;
+}
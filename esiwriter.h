@@ -0,0 +1,37 @@
+#ifndef ESIWRITER_H
+#define ESIWRITER_H
+#include <cstdint>
+#include <string>
+#include "esctooldefs.h"
+
+/**
+ * Writes a parsed device back as an ESI file of its own: the vendor, the
+ * group of the device and the device with what the SII and the master
+ * need (type, mailbox, sync managers, FMMUs, PDOs, DC opmodes, EEPROM).
+ * The object dictionary and the slots with the modules they accept are
+ * only written on request. Elements come from the model in a fixed order
+ * and format, so equal devices give equal files whatever the source
+ * looked like, and parsing the result gives the same SII.
+ */
+class ESIWriter {
+public:
+	// Optional parts of the device
+	enum Parts : unsigned int {
+		KeepDictionary	= 0x1,
+		KeepModules	= 0x2,
+		KeepAll		= 0x3
+	};
+
+	ESIWriter(unsigned int parts = 0) : m_parts(parts) {};
+
+	// Appends the ESI XML to xml
+	void write(uint32_t vendorid, const char* vendorname, const Device* dev, std::string& xml) const;
+
+	// Parts from a comma separated list of dictionary, modules and all,
+	// false on an unknown name
+	static bool parseParts(const std::string& list, unsigned int& parts);
+private:
+	unsigned int m_parts;
+};
+
+#endif /* ESIWRITER_H */
@@ -1,29 +1,144 @@
 
 #include "esixmlparsing.h"
+#include <algorithm>
+#include <functional>
+#include <set>
 #include "esctoolhelpers.h"
+#include "profiler.h"
+#include "runstats.h"
+
+// Print an ESI element or attribute the parser does not know and count it
+#define UNHANDLED(kind, ...) do { \
+		++RunStats::instance().unhandled##kind##s; \
+		printf(__VA_ARGS__); \
+	} while(0)
 
 ESIXML::ESIXML(const int verbosity) :
 	verbose(verbosity != 0), very_verbose(verbosity & 0x2),
 	vendor_id(0x0), vendor_name(NULL) {}
 
-ESIXML::~ESIXML() {};
+ESIXML::~ESIXML() {
+	release();
+};
+
+void ESIXML::release(void) {
+	// Objects, data types, array infos and flags may be shared once the
+	// dictionary has been synthesized, so collect everything first and
+	// delete each pointer once
+	std::set<Object*> objects;
+	std::set<DataType*> datatypes;
+	std::set<ArrayInfo*> arrayinfos;
+	std::set<ObjectFlags*> flags;
+	std::set<Pdo*> pdos;
+	std::function<void(Object*)> collectObject = [&](Object* o) {
+		if(!objects.insert(o).second) return;
+		if(o->flags) flags.insert(o->flags);
+		for(Object* si : o->subitems) collectObject(si);
+	};
+	std::function<void(DataType*)> collectDataType = [&](DataType* dt) {
+		if(!datatypes.insert(dt).second) return;
+		if(dt->arrayinfo) arrayinfos.insert(dt->arrayinfo);
+		if(dt->flags) flags.insert(dt->flags);
+		for(DataType* si : dt->subitems) collectDataType(si);
+	};
+	for(Module* module : modules) {
+		for(auto pdoList : { module->txpdo, module->rxpdo })
+			pdos.insert(pdoList.begin(),pdoList.end());
+		delete module;
+	}
+	for(Group* group : groups) delete group;
+	for(Device* dev : devices) {
+		for(FMMU* fmmu : dev->fmmus) delete fmmu;
+		for(SyncManager* sm : dev->syncmanagers) delete sm;
+		for(auto pdoList : { dev->txpdo, dev->rxpdo })
+			pdos.insert(pdoList.begin(),pdoList.end());
+		if(dev->dc) {
+			for(DcOpmode* opmode : dev->dc->opmodes) delete opmode;
+			delete dev->dc;
+		}
+		if(dev->slots) {
+			for(Slot* slot : dev->slots->slots) delete slot;
+			delete dev->slots;
+		}
+		if(dev->profile) {
+			if(Dictionary* dict = dev->profile->dictionary) {
+				for(Object* o : dict->objects) collectObject(o);
+				for(DataType* dt : dict->datatypes) collectDataType(dt);
+				delete dict;
+			}
+			delete dev->profile->channelinfo;
+			delete dev->profile;
+		}
+		delete dev->mailbox;
+		delete dev->syncunit;
+		delete dev;
+	}
+	for(Pdo* pdo : pdos) {
+		for(PdoEntry* entry : pdo->entries) delete entry;
+		delete pdo;
+	}
+	for(Object* o : objects) delete o;
+	for(DataType* dt : datatypes) delete dt;
+	for(ArrayInfo* ai : arrayinfos) delete ai;
+	for(ObjectFlags* f : flags) {
+		delete f->access;
+		delete f;
+	}
+	modules.clear();
+	groups.clear();
+	devices.clear();
+}
 
 std::list<Device*>& ESIXML::getDevices(void) { return devices; } ;
 const uint32_t ESIXML::getVendorID(void) const { return vendor_id; };
 const char* ESIXML::getVendorName(void) const { return vendor_name; };
 
-void ESIXML::parse(const std::string& file) {
+Device* ESIXML::findDevice(const std::string& selector) {
+	if(!selector.empty() && std::all_of(selector.begin(),selector.end(),::isdigit)) {
+		size_t index = strtoul(selector.c_str(),NULL,10);
+		return index < devices.size() ? *std::next(devices.begin(),index) : NULL;
+	}
+	if(0 == selector.compare(0,2,"#x") || 0 == selector.compare(0,2,"0x")) {
+		const uint32_t productcode = hexdecstr2uint32(("#x" + selector.substr(2)).c_str());
+		for(Device* dev : devices) if(dev->product_code == productcode) return dev;
+		return NULL;
+	}
+	for(Device* dev : devices) if(NULL != dev->name && selector == dev->name) return dev;
+	return NULL;
+}
+
+bool ESIXML::parse(const std::string& file) {
+	ScopedTimer loadtimer("Load XML",file);
 	if(tinyxml2::XML_SUCCESS != doc.LoadFile( file.c_str() )) {
 		printf("Could not open '%s'\n",file.c_str());
-		return;
+		return false;
 	}
+	loadtimer.stop();
+	return parseDocument(file);
+}
+
+bool ESIXML::parse(const char* data, size_t len, const std::string& name) {
+	ScopedTimer loadtimer("Load XML",name);
+	if(tinyxml2::XML_SUCCESS != doc.Parse(data,len)) {
+		printf("Could not parse '%s': %s\n",name.c_str(),doc.ErrorStr());
+		return false;
+	}
+	loadtimer.stop();
+	return parseDocument(name);
+}
+
+bool ESIXML::parseDocument(const std::string& file) {
 	const tinyxml2::XMLElement* root = doc.RootElement();
-	if(NULL != root) {
+	if(NULL == root) return false;
+	{
 		if(0 != strcmp(ESI_ROOTNODE_NAME,root->Name())) {
 			printf("Document seemingly does not contain EtherCAT information (root node name is not '%s' but '%s')\n",ESI_ROOTNODE_NAME,root->Name());
-			return;
+			return false;
 		}
+		ScopedTimer parsetimer("Parse XML",file);
 		parseXMLElement(root);
+		parsetimer.stop();
+		countStats(root);
 		printf("ESIXML: Parsed '%lu' device(s) from vendor 0x%.04X:'%s'\n",devices.size(),vendor_id,vendor_name);
 		int devno = 1;
 		for(Device* dev : devices) {
@@ -40,6 +155,37 @@ void ESIXML::parse(const std::string& file) {
 			}
 		}
 	}
+	return true;
+}
+
+void ESIXML::countStats(const tinyxml2::XMLElement* root) {
+	RunStats& stats = RunStats::instance();
+	std::function<unsigned long(const tinyxml2::XMLElement*)> countElements =
+		[&countElements](const tinyxml2::XMLElement* e) {
+			unsigned long n = 1;
+			for(const tinyxml2::XMLElement* c = e->FirstChildElement(); c != 0; c = c->NextSiblingElement())
+				n += countElements(c);
+			return n;
+		};
+	std::function<unsigned long(const std::list<Object*>&)> countObjects =
+		[&countObjects](const std::list<Object*>& objs) {
+			unsigned long n = objs.size();
+			for(Object* o : objs) n += countObjects(o->subitems);
+			return n;
+		};
+	stats.elements += countElements(root);
+	stats.devices += devices.size();
+	for(Device* dev : devices) {
+		for(auto pdoList : { &dev->txpdo, &dev->rxpdo }) {
+			stats.pdos += pdoList->size();
+			for(Pdo* pdo : *pdoList) stats.pdoEntries += pdo->entries.size();
+		}
+		if(dev->profile && dev->profile->dictionary) {
+			stats.objects += countObjects(dev->profile->dictionary->objects);
+			for(DataType* dt : dev->profile->dictionary->datatypes)
+				stats.datatypes += 1 + dt->subitems.size();
+		}
+	}
 }
 
 void ESIXML::parseXMLGroup(const tinyxml2::XMLElement* xmlgroup) {
@@ -56,7 +202,7 @@ void ESIXML::parseXMLGroup(const tinyxml2::XMLElement* xmlgroup) {
 			printf("Group/Type: '%s'\n",group->type);
 		} else
 		{
-			printf("Unhandled Group element '%s':'%s'\n",child->Name(),child->Value());
+			UNHANDLED(Element,"Unhandled Group element '%s':'%s'\n",child->Name(),child->Value());
 		}
 	}
 	groups.push_back(group);
@@ -73,15 +219,18 @@ void ESIXML::parseXMLModule(const tinyxml2::XMLElement* xmlmodule) {
 				attr != 0; attr = attr->Next())
 			{
 				if(0 == strcmp(attr->Name(),"ModuleIdent")) {
-					module->ident = (hexdecstr2uint32(attr->Value()) & 0xFF);
+					module->ident = hexdecstr2uint32(attr->Value());
 				} else
 				{
-					printf("Unhandled Module Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+					UNHANDLED(Attribute,"Unhandled Module Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
 				}
 			}
 
 			module->type = child->GetText();
-			if(verbose) printf("Module/Type: '%s' (@ModuleIdent: '%d')\n",module->type,module->ident);
+			if(verbose) printf("Module/Type: '%s' (@ModuleIdent: '#x%.08X')\n",module->type,module->ident);
+		} else
+		if(0 == strcmp (child->Name(),"Name")) {
+			module->name = child->GetText();
 		} else
 		if(0 == strcmp (child->Name(),"TxPdo")) {
 			parseXMLPdo(child,&(module->txpdo));
@@ -90,7 +239,7 @@ void ESIXML::parseXMLModule(const tinyxml2::XMLElement* xmlmodule) {
 			parseXMLPdo(child,&(module->rxpdo));
 		} else
 		{
-			printf("Unhandled Module element '%s':'%s'\n",child->Name(),child->Value());
+			UNHANDLED(Element,"Unhandled Module element '%s':'%s'\n",child->Name(),child->Value());
 		}
 	}
 	if(module->ident != 0) {
@@ -113,7 +262,7 @@ void ESIXML::parseXMLMailbox(const tinyxml2::XMLElement* xmlmailbox, Device* dev
 			printf("Mailbox/@DataLinkLayer: %s ('%s')\n",mb->datalinklayer?"yes":"no",attr->Value());
 		} else
 		{
-			printf("Unhandled Device/Mailbox Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+			UNHANDLED(Attribute,"Unhandled Device/Mailbox Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
 		}
 	}
 	for (const tinyxml2::XMLElement* mboxchild = xmlmailbox->FirstChildElement();
@@ -151,12 +300,12 @@ void ESIXML::parseXMLMailbox(const tinyxml2::XMLElement* xmlmailbox, Device* dev
 					printf("Mailbox/CoE/@CompleteAccess: %s ('%s')\n",mb->coe_completeaccess?"yes":"no",coeattr->Value());
 				}
 				else {
-					printf("Unhandled Device/Mailbox/CoE attribute: '%s' = '%s'\n",coeattr->Name(),coeattr->Value());
+					UNHANDLED(Attribute,"Unhandled Device/Mailbox/CoE attribute: '%s' = '%s'\n",coeattr->Name(),coeattr->Value());
 				}
 			}
 		} else
 		{
-			printf("Unhandled Device/Mailbox element '%s':'%s'\n",mboxchild->Name(),mboxchild->GetText());
+			UNHANDLED(Element,"Unhandled Device/Mailbox element '%s':'%s'\n",mboxchild->Name(),mboxchild->GetText());
 		}
 	}
 	dev->mailbox = mb;
@@ -186,7 +335,7 @@ void ESIXML::parseXMLPdo(const tinyxml2::XMLElement* xmlpdo, std::list<Pdo*>* pd
 			if(very_verbose) printf("[Module/Device]/%s/@Su: '%d'\n",xmlpdo->Name(),pdo->syncunit);
 		} else
 		{
-			printf("Unhandled Device/%s Attribute: '%s' = '%s'\n",xmlpdo->Name(),attr->Name(),attr->Value());
+			UNHANDLED(Attribute,"Unhandled Device/%s Attribute: '%s' = '%s'\n",xmlpdo->Name(),attr->Name(),attr->Value());
 		}
 	}
 	for (const tinyxml2::XMLElement* pdochild = xmlpdo->FirstChildElement();
@@ -202,7 +351,7 @@ void ESIXML::parseXMLPdo(const tinyxml2::XMLElement* xmlpdo, std::list<Pdo*>* pd
 					pdo->dependonslot = attr->BoolValue();
 					if(verbose) printf("[Module/Device]/%s/Index/@DependOnSlot: '%s'\n",xmlpdo->Name(),pdo->dependonslot ? "yes":"no");
 				} else {
-					printf("Unhandled [Module/Device]/%s/Index Attribute: '%s' = '%s'\n",xmlpdo->Name(),attr->Name(),attr->Value());
+					UNHANDLED(Attribute,"Unhandled [Module/Device]/%s/Index Attribute: '%s' = '%s'\n",xmlpdo->Name(),attr->Name(),attr->Value());
 				}
 			}
 		} else
@@ -229,7 +378,7 @@ void ESIXML::parseXMLPdo(const tinyxml2::XMLElement* xmlpdo, std::list<Pdo*>* pd
 							entry->dependonslot = attr->BoolValue();
 							if(very_verbose) printf("[Module/Device]/%s/Index/Entry/@DependOnSlot: '%s'\n",xmlpdo->Name(),entry->dependonslot ? "yes":"no");
 						} else {
-							printf("Unhandled [Module/Device]/%s/Index/Entry Attribute: '%s' = '%s'\n",xmlpdo->Name(),attr->Name(),attr->Value());
+							UNHANDLED(Attribute,"Unhandled [Module/Device]/%s/Index/Entry Attribute: '%s' = '%s'\n",xmlpdo->Name(),attr->Name(),attr->Value());
 						}
 					}
 				} else
@@ -247,13 +396,13 @@ void ESIXML::parseXMLPdo(const tinyxml2::XMLElement* xmlpdo, std::list<Pdo*>* pd
 					if(very_verbose) printf("Device/%s/Entry/DataType: '%s'\n",xmlpdo->Name(),entry->datatype);
 				} else
 				{
-					printf("Unhandled Device/%s/Entry Element: '%s' = '%s'\n",xmlpdo->Name(),entrychild->Name(),entrychild->GetText());
+					UNHANDLED(Element,"Unhandled Device/%s/Entry Element: '%s' = '%s'\n",xmlpdo->Name(),entrychild->Name(),entrychild->GetText());
 				}
 			}
 			pdo->entries.push_back(entry);
 		} else
 		{
-			printf("Unhandled Device/%s Element: '%s' = '%s'\n",xmlpdo->Name(),pdochild->Name(),pdochild->GetText());
+			UNHANDLED(Element,"Unhandled Device/%s Element: '%s' = '%s'\n",xmlpdo->Name(),pdochild->Name(),pdochild->GetText());
 		}
 	}
 	pdolist->push_back(pdo);
@@ -285,7 +434,7 @@ void ESIXML::parseXMLSyncUnit(const tinyxml2::XMLElement* xmlsu, Device* dev) {
 			if(very_verbose) printf("Device/Su/@FrameRepeatSupport: %s ('%s')\n",su->frame_repeat_support ? "yes" : "no",attr->Value());
 		} else
 		{
-			printf("Unhandled Device/%s Attribute: '%s' = '%s'\n",xmlsu->Name(),attr->Name(),attr->Value());
+			UNHANDLED(Attribute,"Unhandled Device/%s Attribute: '%s' = '%s'\n",xmlsu->Name(),attr->Name(),attr->Value());
 		}
 	}
 	dev->syncunit = su;
@@ -318,7 +467,7 @@ void ESIXML::parseXMLDistributedClock(const tinyxml2::XMLElement* xmldc, Distrib
 							opmode->cycletimesync0factor = cts0attr->IntValue();
 						} else
 						{
-							printf("Unhandled Device/Dc/Opmode/CycleTimeSync0 attribute: '%s' = '%s'\n",cts0attr->Name(),cts0attr->Value());
+							UNHANDLED(Attribute,"Unhandled Device/Dc/Opmode/CycleTimeSync0 attribute: '%s' = '%s'\n",cts0attr->Name(),cts0attr->Value());
 						}
 					}
 				} else
@@ -332,7 +481,7 @@ void ESIXML::parseXMLDistributedClock(const tinyxml2::XMLElement* xmldc, Distrib
 							opmode->cycletimesync1factor = cts1attr->IntValue();
 						} else
 						{
-							printf("Unhandled Device/Dc/Opmode/CycleTimeSync1 attribute: '%s' = '%s'\n",cts1attr->Name(),cts1attr->Value());
+							UNHANDLED(Attribute,"Unhandled Device/Dc/Opmode/CycleTimeSync1 attribute: '%s' = '%s'\n",cts1attr->Name(),cts1attr->Value());
 						}
 					}
 				} else
@@ -342,7 +491,7 @@ void ESIXML::parseXMLDistributedClock(const tinyxml2::XMLElement* xmldc, Distrib
 					for (const tinyxml2::XMLAttribute* sts0attr = dcopmodechild->FirstAttribute();
 						sts0attr != 0; sts0attr = sts0attr->Next())
 					{
-						printf("Unhandled Device/Dc/Opmode/ShiftTimeSync0 attribute: '%s' = '%s'\n",sts0attr->Name(),sts0attr->Value());
+						UNHANDLED(Attribute,"Unhandled Device/Dc/Opmode/ShiftTimeSync0 attribute: '%s' = '%s'\n",sts0attr->Name(),sts0attr->Value());
 					}
 				} else
 				if(0 == strcmp(dcopmodechild->Name(),"ShiftTimeSync1")) {
@@ -351,7 +500,7 @@ void ESIXML::parseXMLDistributedClock(const tinyxml2::XMLElement* xmldc, Distrib
 					for (const tinyxml2::XMLAttribute* sts1attr = dcopmodechild->FirstAttribute();
 						sts1attr != 0; sts1attr = sts1attr->Next())
 					{
-						printf("Unhandled Device/Dc/Opmode/ShiftTimeSync1 attribute: '%s' = '%s'\n",sts1attr->Name(),sts1attr->Value());
+						UNHANDLED(Attribute,"Unhandled Device/Dc/Opmode/ShiftTimeSync1 attribute: '%s' = '%s'\n",sts1attr->Name(),sts1attr->Value());
 					}
 				} else
 				if(0 == strcmp(dcopmodechild->Name(),"AssignActivate")) { // HexDecInt
@@ -359,13 +508,13 @@ void ESIXML::parseXMLDistributedClock(const tinyxml2::XMLElement* xmldc, Distrib
 					if(verbose) printf("Device/Dc/Opmode/AssignActivate: 0x%.04X\n",opmode->assignactivate);
 				}
 				else {
-					printf("Unhandled Device/Dc/Opmode element: '%s' = '%s'\n",dcopmodechild->Name(),dcopmodechild->GetText());
+					UNHANDLED(Element,"Unhandled Device/Dc/Opmode element: '%s' = '%s'\n",dcopmodechild->Name(),dcopmodechild->GetText());
 				}
 			}
 			dc->opmodes.push_back(opmode);
 		} else
 		{
-			printf("Unhandled Device/Dc element: '%s' = '%s'\n",dcchild->Name(),dcchild->GetText());
+			UNHANDLED(Element,"Unhandled Device/Dc element: '%s' = '%s'\n",dcchild->Name(),dcchild->GetText());
 		}
 	}
 }
@@ -411,7 +560,7 @@ void ESIXML::parseXMLObject(const tinyxml2::XMLElement* xmlobject, Dictionary* d
 					parseXMLObject(infochild,dict,obj);
 				} else
 				{
-					printf("Unhandled Device/Profile/Objects/Object/Info element: '%s' = '%s'\n",objchild->Name(),objchild->GetText());
+					UNHANDLED(Element,"Unhandled Device/Profile/Objects/Object/Info element: '%s' = '%s'\n",objchild->Name(),objchild->GetText());
 				}
 			}
 		} else
@@ -433,7 +582,7 @@ void ESIXML::parseXMLObject(const tinyxml2::XMLElement* xmlobject, Dictionary* d
 							access->writerestrictions = attr->Value();
 						} else
 						{
-							printf("Unhandled Device/Profile/Objects/Object/Flags/Access Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+							UNHANDLED(Attribute,"Unhandled Device/Profile/Objects/Object/Flags/Access Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
 						}
 					}
 					flags->access = access;
@@ -448,7 +597,7 @@ void ESIXML::parseXMLObject(const tinyxml2::XMLElement* xmlobject, Dictionary* d
 					flags->sdoaccess = flagschild->GetText();
 				} else
 				{
-					printf("Unhandled Device/Profile/Objects/Object/Flags element: '%s' = '%s'\n",objchild->Name(),objchild->GetText());
+					UNHANDLED(Element,"Unhandled Device/Profile/Objects/Object/Flags element: '%s' = '%s'\n",objchild->Name(),objchild->GetText());
 				}
 
 			}
@@ -458,7 +607,7 @@ void ESIXML::parseXMLObject(const tinyxml2::XMLElement* xmlobject, Dictionary* d
 			parseXMLObject(objchild,dict,obj);
 		} else
 		{
-			printf("Unhandled Device/Profile/Objects/Object element: '%s' = '%s'\n",objchild->Name(),objchild->GetText());
+			UNHANDLED(Element,"Unhandled Device/Profile/Objects/Object element: '%s' = '%s'\n",objchild->Name(),objchild->GetText());
 		}
 	}
 
@@ -515,7 +664,7 @@ void ESIXML::parseXMLDataType(const tinyxml2::XMLElement* xmldatatype, Dictionar
 					if(very_verbose) printf("DataType/ArrayInfo/Elements: '%d'\n",arrinfo->elements);
 				} else
 				{
-					printf("Unhandled Device/Profile/DataTypes/DataType/ArrayInfo element: '%s' = '%s'\n",arrchild->Name(),arrchild->GetText());
+					UNHANDLED(Element,"Unhandled Device/Profile/DataTypes/DataType/ArrayInfo element: '%s' = '%s'\n",arrchild->Name(),arrchild->GetText());
 				}
 			}
 			datatype->arrayinfo = arrinfo;
@@ -538,7 +687,7 @@ void ESIXML::parseXMLDataType(const tinyxml2::XMLElement* xmldatatype, Dictionar
 							access->writerestrictions = attr->Value();
 						} else
 						{
-							printf("Unhandled Device/Profile/DataTypes/DataType/Flags/Access Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+							UNHANDLED(Attribute,"Unhandled Device/Profile/DataTypes/DataType/Flags/Access Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
 						}
 					}
 					flags->access = access;
@@ -550,7 +699,7 @@ void ESIXML::parseXMLDataType(const tinyxml2::XMLElement* xmldatatype, Dictionar
 					flags->pdomapping = flagschild->GetText();
 				} else
 				{
-					printf("Unhandled Device/Profile/DataTypes/DataType/Flags element: '%s' = '%s'\n",dtchild->Name(),dtchild->GetText());
+					UNHANDLED(Element,"Unhandled Device/Profile/DataTypes/DataType/Flags element: '%s' = '%s'\n",dtchild->Name(),dtchild->GetText());
 				}
 
 			}
@@ -560,7 +709,7 @@ void ESIXML::parseXMLDataType(const tinyxml2::XMLElement* xmldatatype, Dictionar
 			parseXMLDataType(dtchild,dict,datatype);
 		} else
 		{
-			printf("Unhandled Device/Profile/DataTypes element: '%s' = '%s'\n",dtchild->Name(),dtchild->GetText());
+			UNHANDLED(Element,"Unhandled Device/Profile/DataTypes element: '%s' = '%s'\n",dtchild->Name(),dtchild->GetText());
 		}
 	}
 
@@ -588,8 +737,34 @@ void ESIXML::parseXMLSlots(const tinyxml2::XMLElement* xmlslots, Device *dev) {
 			slots->slotindexincrement = hexdecstr2uint32(attr->Value());
 		} else
 		{
-			printf("Unhandled Device Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+			UNHANDLED(Attribute,"Unhandled Device Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+		}
+	}
+	// Only the names and module idents of slots, instance counts and
+	// module classes are not used
+	for (const tinyxml2::XMLElement* child = xmlslots->FirstChildElement("Slot");
+		child != 0; child = child->NextSiblingElement("Slot"))
+	{
+		Slot* slot = new Slot;
+		slot->slotno = slots->slots.size();
+		for (const tinyxml2::XMLAttribute* attr = child->FirstAttribute();
+			attr != 0; attr = attr->Next())
+		{
+			if(0 == strcmp(attr->Name(),"SlotPdoIncrement")) {
+				slot->slotpdoincrement = hexdecstr2uint32(attr->Value());
+			} else
+			if(0 == strcmp(attr->Name(),"SlotIndexIncrement")) {
+				slot->slotindexincrement = hexdecstr2uint32(attr->Value());
+			}
+		}
+		const tinyxml2::XMLElement* name = child->FirstChildElement("Name");
+		if(NULL != name) slot->name = name->GetText();
+		for (const tinyxml2::XMLElement* ident = child->FirstChildElement("ModuleIdent");
+			ident != 0; ident = ident->NextSiblingElement("ModuleIdent"))
+		{
+			if(NULL != ident->GetText()) slot->moduleidents.push_back(hexdecstr2uint32(ident->GetText()));
 		}
+		slots->slots.push_back(slot);
 	}
 	dev->slots = slots;
 	dev->modules = &modules;
@@ -615,7 +790,7 @@ void ESIXML::parseXMLProfile(const tinyxml2::XMLElement* xmlprofile, Device *dev
 							parseXMLObject(objschild,dict);
 						} else
 						{
-							printf("Unhandled Device/Profile/Dictionary/Objects element: '%s' = '%s'\n",objschild->Name(),objschild->GetText());
+							UNHANDLED(Element,"Unhandled Device/Profile/Dictionary/Objects element: '%s' = '%s'\n",objschild->Name(),objschild->GetText());
 						}
 					}
 				} else
@@ -627,17 +802,17 @@ void ESIXML::parseXMLProfile(const tinyxml2::XMLElement* xmlprofile, Device *dev
 							parseXMLDataType(dtchild,dict);
 						} else
 						{
-							printf("Unhandled Device/Profile/Dictionary/DataTypes element: '%s' = '%s'\n",dtchild->Name(),dtchild->GetText());
+							UNHANDLED(Element,"Unhandled Device/Profile/Dictionary/DataTypes element: '%s' = '%s'\n",dtchild->Name(),dtchild->GetText());
 						}
 					}
 				} else
 				{
-					printf("Unhandled Device/Profile/Dictionary element: '%s' = '%s'\n",dictchild->Name(),dictchild->GetText());
+					UNHANDLED(Element,"Unhandled Device/Profile/Dictionary element: '%s' = '%s'\n",dictchild->Name(),dictchild->GetText());
 				}
 			}
 		} else
 		{
-			printf("Unhandled Device/Profile element: '%s' = '%s'\n",child->Name(),child->GetText());
+			UNHANDLED(Element,"Unhandled Device/Profile element: '%s' = '%s'\n",child->Name(),child->GetText());
 		}
 	}
 }
@@ -653,7 +828,7 @@ void ESIXML::parseXMLDevice(const tinyxml2::XMLElement* xmldevice) {
 			dev->physics = attr->Value();
 		} else
 		{
-			printf("Unhandled Device Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+			UNHANDLED(Attribute,"Unhandled Device Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
 		}
 	}
 	for (const tinyxml2::XMLElement* child = xmldevice->FirstChildElement();
@@ -677,7 +852,7 @@ void ESIXML::parseXMLDevice(const tinyxml2::XMLElement* xmldevice) {
 					if(very_verbose) printf("Device/Type/@RevisionNo: 0x%.08X\n",dev->revision_no);
 				} else
 				{
-					printf("Unhandled Device/Type Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+					UNHANDLED(Attribute,"Unhandled Device/Type Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
 				}
 			}
 		} else
@@ -713,7 +888,7 @@ void ESIXML::parseXMLDevice(const tinyxml2::XMLElement* xmldevice) {
 					fmmu->syncunit = (int32_t)hexdecstr2uint32(attr->Value());
 				} else
 				{
-					printf("Unhandled Device/Fmmu Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+					UNHANDLED(Attribute,"Unhandled Device/Fmmu Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
 				}
 			}
 			dev->fmmus.push_back(fmmu);
@@ -752,7 +927,7 @@ void ESIXML::parseXMLDevice(const tinyxml2::XMLElement* xmldevice) {
 					if(very_verbose) printf("Device/Eeprom/ByteSize: %u\n",dev->eepromsize);
 				} else
 				{
-					printf("Unhandled Device/Eeprom element: '%s' = '%s'\n",eepchild->Name(),eepchild->GetText());
+					UNHANDLED(Element,"Unhandled Device/Eeprom element: '%s' = '%s'\n",eepchild->Name(),eepchild->GetText());
 				}
 			}
 		} else
@@ -794,7 +969,7 @@ void ESIXML::parseXMLDevice(const tinyxml2::XMLElement* xmldevice) {
 					if(verbose) printf("Device/Sm/@MaxSize: 0x%.04X\n",sm->maxsize);
 				} else
 				{
-					printf("Unhandled Device/Sm Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
+					UNHANDLED(Attribute,"Unhandled Device/Sm Attribute: '%s' = '%s'\n",attr->Name(),attr->Value());
 				}
 			}
 			dev->syncmanagers.push_back(sm);
@@ -812,7 +987,7 @@ void ESIXML::parseXMLDevice(const tinyxml2::XMLElement* xmldevice) {
 			parseXMLPdo(child,&(dev->rxpdo));
 		} else
 		{
-			printf("Unhandled Device element '%s':'%s'\n",child->Name(),child->GetText());
+			UNHANDLED(Element,"Unhandled Device element '%s':'%s'\n",child->Name(),child->GetText());
 		}
 	}
 	devices.push_back(dev);
@@ -853,7 +1028,7 @@ void ESIXML::parseXMLElement(const tinyxml2::XMLElement* element, void* data) {
 		} else
 		{
 			if(!child->NoChildren()) parseXMLElement(child);
-			else printf("Unhandled element '%s'\n",child->Name());
+			else UNHANDLED(Element,"Unhandled element '%s'\n",child->Name());
 		}
 	}
 	return;
@@ -7,9 +7,16 @@
 class ESIXML {
 public:
 	ESIXML(const int verbosity = 0);
+	// Frees everything parsed, including what was added to the devices later
 	virtual ~ESIXML();
-	void parse(const std::string& file);
+	ESIXML(const ESIXML&) = delete;
+	ESIXML& operator=(const ESIXML&) = delete;
+	bool parse(const std::string& file);
+	// Parse an ESI document held in memory, name is only used in messages
+	bool parse(const char* data, size_t len, const std::string& name = "(buffer)");
 	std::list<Device*>& getDevices(void);
+	// Device by index, product code ("#x..." or "0x...") or name, NULL if none
+	Device* findDevice(const std::string& selector);
 	const uint32_t getVendorID(void) const;
 	const char* getVendorName(void) const;
 private:
@@ -36,8 +43,13 @@ private:
 
 	void parseXMLModule(const tinyxml2::XMLElement* xmlmodule);
 
+	bool parseDocument(const std::string& name);
+	void release(void);
+
 	void parseXMLVendor(const tinyxml2::XMLElement* xmlvendor);
 	void parseXMLElement(const tinyxml2::XMLElement* element, void* data = NULL);
+	// Add what was parsed to the run statistics
+	void countStats(const tinyxml2::XMLElement* root);
 };
 
 #endif /* ESIXMLPARSING_H */
\ No newline at end of file
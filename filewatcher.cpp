@@ -0,0 +1,72 @@
+#include "filewatcher.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+FileWatcher::FileWatcher() {
+	m_fd = inotify_init1(IN_CLOEXEC);
+	if(m_fd < 0) perror("inotify_init1() error");
+}
+
+FileWatcher::~FileWatcher() {
+	if(m_fd >= 0) close(m_fd);
+}
+
+bool FileWatcher::add(const std::string& file) {
+	if(m_fd < 0) return false;
+	std::string dir = ".";
+	std::string name = file;
+	size_t slash = file.rfind('/');
+	if(slash != std::string::npos) {
+		dir = slash ? file.substr(0,slash) : "/";
+		name = file.substr(slash + 1);
+	}
+	int wd = inotify_add_watch(m_fd,dir.c_str(),IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE);
+	if(wd < 0) {
+		printf("Could not watch '%s' (%s)\n",dir.c_str(),strerror(errno));
+		return false;
+	}
+	m_watches.push_back({ wd, name, file });
+	return true;
+}
+
+bool FileWatcher::readEvents(std::vector<std::string>& changed) {
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	ssize_t len = read(m_fd,buf,sizeof(buf));
+	if(len < 0) return errno == EINTR || errno == EAGAIN;
+	for(char* p = buf; p < buf + len; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+		const struct inotify_event* event = (const struct inotify_event*)p;
+		if(0 == event->len) continue;
+		for(const Watch& w : m_watches) {
+			if(w.wd == event->wd && w.name == event->name &&
+			std::find(changed.begin(),changed.end(),w.file) == changed.end())
+				changed.push_back(w.file);
+		}
+	}
+	return true;
+}
+
+bool FileWatcher::wait(std::vector<std::string>& changed, const int debouncems) {
+	changed.clear();
+	if(m_fd < 0 || m_watches.empty()) return false;
+	struct pollfd pfd = { m_fd, POLLIN, 0 };
+	// Wait for the first relevant change, then until writes stop coming
+	while(changed.empty()) {
+		if(poll(&pfd,1,-1) < 0) {
+			if(errno == EINTR) continue;
+			return false;
+		}
+		if(!readEvents(changed)) return false;
+	}
+	for(;;) {
+		int n = poll(&pfd,1,debouncems);
+		if(n < 0 && errno != EINTR) return false;
+		if(n <= 0) break;
+		if(!readEvents(changed)) return false;
+	}
+	return true;
+}
@@ -0,0 +1,36 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+#include <string>
+#include <vector>
+
+/**
+ * Waits for files to change (inotify). The directory of each file is
+ * watched rather than the file itself, so editors saving through a
+ * temporary file and rename are noticed as well.
+ */
+class FileWatcher {
+public:
+	FileWatcher();
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// Prints why and returns false if the file can not be watched
+	bool add(const std::string& file);
+	// Blocks until watched files changed and then stayed quiet for
+	// debouncems, the changed files are put in changed. False on error
+	bool wait(std::vector<std::string>& changed, const int debouncems = 50);
+private:
+	struct Watch {
+		int wd;
+		std::string name; // Within the watched directory
+		std::string file; // As given to add()
+	};
+
+	int m_fd;
+	std::vector<Watch> m_watches;
+
+	bool readEvents(std::vector<std::string>& changed);
+};
+
+#endif /* FILEWATCHER_H */
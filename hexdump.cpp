@@ -0,0 +1,80 @@
+#include "hexdump.h"
+
+#include <cstring>
+#include <algorithm>
+
+#define HEXDUMP_BYTES_PER_LINE	(16)
+
+namespace {
+	// Two ASCII hex digits for every byte value
+	struct HexTable {
+		char pair[256][2];
+		constexpr HexTable() : pair() {
+			const char digits[] = "0123456789ABCDEF";
+			for(int i = 0; i < 256; ++i) {
+				pair[i][0] = digits[i >> 4];
+				pair[i][1] = digits[i & 0xF];
+			}
+		}
+	};
+	constexpr HexTable HexPairs;
+};
+
+char* HexDump::hex8(char* p, uint8_t v) {
+	memcpy(p,HexPairs.pair[v],2);
+	return p + 2;
+}
+
+void HexDump::annotate(size_t offset, const std::string& label) {
+	auto pos = std::upper_bound(m_annotations.begin(),m_annotations.end(),offset,
+		[](size_t o, const std::pair<size_t,std::string>& a) { return o < a.first; });
+	m_annotations.insert(pos,std::make_pair(offset,label));
+}
+
+void HexDump::format(std::string& out, const uint8_t* data, size_t len) const {
+	const size_t end = m_base + len;
+	// 4 offset digits are enough for any EEPROM, use 8 for larger buffers
+	const int digits = end > 0x10000 ? 8 : 4;
+	// offset, 2 spaces, 16 * "XX ", 1 extra space in the middle and 1 before |16 chars|
+	const size_t linelen = digits + 2 + HEXDUMP_BYTES_PER_LINE*3 + 2 + HEXDUMP_BYTES_PER_LINE + 2;
+	const size_t lines = (len + HEXDUMP_BYTES_PER_LINE - 1) / HEXDUMP_BYTES_PER_LINE;
+	out.reserve(out.size() + lines * linelen);
+
+	auto note = m_annotations.begin();
+	char line[128];
+	for(size_t i = 0; i < len; i += HEXDUMP_BYTES_PER_LINE) {
+		const size_t n = std::min((size_t)HEXDUMP_BYTES_PER_LINE,len - i);
+		const size_t offset = m_base + i;
+		memset(line,' ',linelen);
+		char* p = line;
+		for(int d = digits - 2; d >= 0; d -= 2) p = hex8(p,(offset >> (d*4)) & 0xFF);
+		p += 2;
+		char* ascii = line + digits + 2 + HEXDUMP_BYTES_PER_LINE*3 + 2;
+		*(ascii++) = '|';
+		for(size_t b = 0; b < n; ++b) {
+			uint8_t v = data[i+b];
+			hex8(p + b*3 + (b >= 8 ? 1 : 0),v);
+			ascii[b] = (v >= 0x20 && v < 0x7F) ? (char)v : '.';
+		}
+		ascii[n] = '|';
+		out.append(line,ascii + n + 1 - line);
+
+		// Labels of everything starting on this line
+		const char* sep = "  ";
+		while(note != m_annotations.end() && note->first < i + HEXDUMP_BYTES_PER_LINE) {
+			if(note->first >= i) {
+				out += sep;
+				out += note->second;
+				sep = ", ";
+			}
+			++note;
+		}
+		out += '\n';
+	}
+}
+
+void HexDump::write(FILE* f, const uint8_t* data, size_t len) const {
+	std::string out;
+	format(out,data,len);
+	fwrite(out.data(),1,out.size(),f);
+}
@@ -0,0 +1,39 @@
+#ifndef HEXDUMP_H
+#define HEXDUMP_H
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Classic 16 bytes per line hex dump with offsets, ASCII column and
+ * optional labels, eg.
+ *
+ *	0080  0A 00 06 00 02 03 67 72  70 08 4D 79 44 65 76 69  |......grp.MyDevi|  STRINGS
+ *
+ * Lines are built with table lookups into one buffer instead of a printf
+ * per byte or word, so dumping a large image costs a single write.
+ */
+class HexDump {
+public:
+	// Offsets printed are relative to base
+	HexDump(size_t base = 0) : m_base(base) {};
+
+	// Label shown behind the line that holds offset (relative to base)
+	void annotate(size_t offset, const std::string& label);
+	void clearAnnotations(void) { m_annotations.clear(); };
+
+	// Appends the dump of data to out
+	void format(std::string& out, const uint8_t* data, size_t len) const;
+	// Formats and writes the dump of data to f with one fwrite
+	void write(FILE* f, const uint8_t* data, size_t len) const;
+
+	// Writes the two upper case hex digits of v to p, returns p+2
+	static char* hex8(char* p, uint8_t v);
+private:
+	size_t m_base;
+	std::vector<std::pair<size_t,std::string>> m_annotations; // Sorted by offset
+};
+
+#endif /* HEXDUMP_H */
@@ -0,0 +1,128 @@
+#include "jsonwriter.h"
+
+void JSONWriter::indent(void) {
+	if(!m_pretty) return;
+	m_out += '\n';
+	m_out.append(m_first.size(),'\t');
+}
+
+void JSONWriter::prefix(const char* key) {
+	if(!m_first.empty()) {
+		if(!m_first.back()) m_out += ',';
+		m_first.back() = false;
+		indent();
+	}
+	if(NULL != key && !m_array.empty() && !m_array.back()) {
+		m_out += '"';
+		escape(m_out,key);
+		m_out += m_pretty ? "\": " : "\":";
+	}
+}
+
+JSONWriter& JSONWriter::beginObject(const char* key) {
+	prefix(key);
+	m_out += '{';
+	m_first.push_back(true);
+	m_array.push_back(false);
+	return *this;
+}
+
+JSONWriter& JSONWriter::endObject(void) {
+	bool empty = m_first.back();
+	m_first.pop_back();
+	m_array.pop_back();
+	if(!empty) indent();
+	m_out += '}';
+	return *this;
+}
+
+JSONWriter& JSONWriter::beginArray(const char* key) {
+	prefix(key);
+	m_out += '[';
+	m_first.push_back(true);
+	m_array.push_back(true);
+	return *this;
+}
+
+JSONWriter& JSONWriter::endArray(void) {
+	bool empty = m_first.back();
+	m_first.pop_back();
+	m_array.pop_back();
+	if(!empty) indent();
+	m_out += ']';
+	return *this;
+}
+
+JSONWriter& JSONWriter::value(const char* key, std::string_view v) {
+	prefix(key);
+	m_out += '"';
+	escape(m_out,v);
+	m_out += '"';
+	return *this;
+}
+
+JSONWriter& JSONWriter::value(const char* key, const char* v) {
+	if(NULL == v) return null(key);
+	return value(key,std::string_view(v));
+}
+
+JSONWriter& JSONWriter::value(const char* key, bool v) {
+	prefix(key);
+	m_out += v ? "true" : "false";
+	return *this;
+}
+
+JSONWriter& JSONWriter::value(const char* key, long long v) {
+	prefix(key);
+	char s[24];
+	snprintf(s,sizeof(s),"%lld",v);
+	m_out += s;
+	return *this;
+}
+
+JSONWriter& JSONWriter::value(const char* key, unsigned long long v) {
+	prefix(key);
+	char s[24];
+	snprintf(s,sizeof(s),"%llu",v);
+	m_out += s;
+	return *this;
+}
+
+JSONWriter& JSONWriter::value(const char* key, double v) {
+	prefix(key);
+	char s[32];
+	snprintf(s,sizeof(s),"%.6g",v);
+	m_out += s;
+	return *this;
+}
+
+JSONWriter& JSONWriter::null(const char* key) {
+	prefix(key);
+	m_out += "null";
+	return *this;
+}
+
+void JSONWriter::write(FILE* f) const {
+	fwrite(m_out.data(),1,m_out.size(),f);
+	fputc('\n',f);
+}
+
+void JSONWriter::escape(std::string& out, std::string_view s) {
+	static const char hex[] = "0123456789abcdef";
+	for(char c : s) {
+		switch(c) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if((unsigned char)c < 0x20) {
+					out += "\\u00";
+					out += hex[(c >> 4) & 0xF];
+					out += hex[c & 0xF];
+				} else out += c;
+			break;
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Minimal streaming JSON writer, appends to a string so a whole document can
+ * be written with a single fwrite. Keys are ignored inside arrays.
+ */
+class JSONWriter {
+public:
+	JSONWriter(bool pretty = true) : m_pretty(pretty) {};
+
+	JSONWriter& beginObject(const char* key = NULL);
+	JSONWriter& endObject(void);
+	JSONWriter& beginArray(const char* key = NULL);
+	JSONWriter& endArray(void);
+
+	JSONWriter& value(const char* key, std::string_view v);
+	JSONWriter& value(const char* key, const char* v);
+	JSONWriter& value(const char* key, const std::string& v) { return value(key,std::string_view(v)); };
+	JSONWriter& value(const char* key, bool v);
+	JSONWriter& value(const char* key, long long v);
+	JSONWriter& value(const char* key, unsigned long long v);
+	JSONWriter& value(const char* key, int v) { return value(key,(long long)v); };
+	JSONWriter& value(const char* key, long v) { return value(key,(long long)v); };
+	JSONWriter& value(const char* key, unsigned int v) { return value(key,(unsigned long long)v); };
+	JSONWriter& value(const char* key, unsigned long v) { return value(key,(unsigned long long)v); };
+	JSONWriter& value(const char* key, double v);
+	JSONWriter& null(const char* key);
+
+	const std::string& str(void) const { return m_out; };
+	void clear(void) { m_out.clear(); m_first.clear(); };
+	// Writes the document (and a newline) to f
+	void write(FILE* f) const;
+
+	static void escape(std::string& out, std::string_view s);
+private:
+	void prefix(const char* key);
+	void indent(void);
+
+	bool m_pretty;
+	std::string m_out;
+	std::vector<bool> m_first; // Per nesting level: no element written yet
+	std::vector<bool> m_array; // Per nesting level: level is an array
+};
+
+#endif /* JSONWRITER_H */
@@ -0,0 +1,89 @@
+#include "libesctool.h"
+#include <iterator>
+#include "esctool.h"
+#include "esixmlparsing.h"
+#include "objectdictionary.h"
+#include "outputsink.h"
+#include "sii.h"
+#include "siireader.h"
+#include "soesconfigwriter.h"
+#include "jsonwriter.h"
+
+const char* ESCTool::version(void) {
+	return APP_VERSION;
+}
+
+bool ESCTool::generate(const char* esi, size_t len, const Options& options, Output& output,
+	const std::string& name)
+{
+	const bool verbose = options.verbosity & 0x1;
+	const bool very_verbose = options.verbosity & 0x2;
+	output.eeprom.clear();
+	output.files.clear();
+	output.error.clear();
+
+	ESIXML esixml(options.verbosity);
+	if(!esixml.parse(esi,len,name)) {
+		output.error = "Could not parse '" + name + "'";
+		return false;
+	}
+	std::list<Device*>& devices = esixml.getDevices();
+	if(options.device >= devices.size()) {
+		output.error = "No device " + std::to_string(options.device) + " in '" + name + "'";
+		return false;
+	}
+	Device* dev = *std::next(devices.begin(),options.device);
+
+	// Names made up for the dictionary, the model points into them until
+	// esixml is gone
+	std::vector<char*> strings;
+	bool ok = true;
+	if(options.writeSSC && dev->mailbox && dev->mailbox->coe_sdoinfo)
+		ObjectDictionary::synthesize(dev,strings,verbose);
+	ObjectDictionary::validateBitsizes(dev,verbose);
+	ObjectDictionary::sortObjects(dev);
+
+	if(options.encodeSII) {
+		if(!SII::encodeEEPROM(esixml.getVendorID(),dev,options.encodePdo,output.eeprom,very_verbose)) {
+			output.error = "SII does not fit the EEPROM";
+			ok = false;
+		} else
+		if(options.verifyRoundtrip &&
+		!SII::verifyRoundtrip(output.eeprom,esixml.getVendorID(),dev,options.encodePdo,very_verbose)) {
+			output.error = "SII roundtrip verification failed";
+			ok = false;
+		}
+		// Never hand out an image that failed
+		if(!ok) output.eeprom.clear();
+	}
+
+	if(ok && options.writeSSC && NULL != dev->profile &&
+	NULL != dev->profile->dictionary)
+	{
+		MemorySink sink;
+		{
+			SOESConfigWriter sscwriter("",options.inputIsLittleEndian,&sink);
+			sscwriter.writeSSCFiles(dev,{ .capitalizeStructMembers = options.capitalizeStructMembers,
+				.appendObjectIndexToStructs = options.appendObjectIndexToStructs });
+		}
+		output.files = sink.files();
+	}
+
+	for(char* s : strings) delete[] s;
+	return ok;
+}
+
+bool ESCTool::decode(const uint8_t* eeprom, size_t len, std::string& json, std::string& error) {
+	SII::Reader reader(SII::ByteSpan(eeprom,len));
+	if(!reader.valid()) {
+		error = "Not a valid SII image";
+		return false;
+	}
+	JSONWriter out;
+	out.beginObject();
+	SII::writeEEPROMJSON(reader,out);
+	out.endObject();
+	json = out.str();
+	error.clear();
+	return true;
+}
@@ -0,0 +1,47 @@
+#ifndef LIBESCTOOL_H
+#define LIBESCTOOL_H
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Bumped whenever Options or Output change incompatibly
+#define ESCTOOL_API_VERSION		1
+
+/**
+ * In-process interface to the ESI parser, SII encoder/decoder, object
+ * dictionary synthesis and the SOES writer, taking and returning buffers
+ * instead of files. For C callers see libesctool_c.h.
+ *
+ * Not thread safe: the profiler and run statistics are process wide. The
+ * parser and encoder still report on stdout as the command line tool does.
+ */
+namespace ESCTool {
+	struct Options {
+		unsigned int device = 0; // Which device of the ESI file
+		bool encodeSII = true;
+		bool encodePdo = false; // Put PDOs in the SII EEPROM
+		bool verifyRoundtrip = false; // Decode the encoded SII again and compare it to the model
+		bool writeSSC = false; // SOES object dictionary and configuration
+		bool capitalizeStructMembers = false;
+		bool appendObjectIndexToStructs = false;
+		bool inputIsLittleEndian = false;
+		int verbosity = 0; // 0x1 verbose, 0x2 very verbose
+	};
+
+	struct Output {
+		std::vector<uint8_t> eeprom; // Empty unless Options::encodeSII and it succeeded
+		std::map<std::string,std::string> files; // Generated SOES files by name
+		std::string error; // Why generate() or decode() returned false
+	};
+
+	const char* version(void);
+	// Encode one device of an ESI document, name is only used in messages
+	bool generate(const char* esi, size_t len, const Options& options, Output& output,
+		const std::string& name = "(buffer)");
+	// Decode a SII image into a JSON document as written by --decode --json
+	bool decode(const uint8_t* eeprom, size_t len, std::string& json, std::string& error);
+};
+
+#endif /* LIBESCTOOL_H */
@@ -0,0 +1,96 @@
+#include "libesctool_c.h"
+#include <cstdlib>
+#include <cstring>
+#include "libesctool.h"
+
+struct esctool_result {
+	bool ok;
+	ESCTool::Output output;
+	// Index into output.files for the accessors
+	std::vector<const std::pair<const std::string,std::string>*> files;
+};
+
+const char* esctool_version(void) {
+	return ESCTool::version();
+}
+
+int esctool_api_version(void) {
+	return ESCTOOL_API_VERSION;
+}
+
+void esctool_default_options(esctool_options* options) {
+	ESCTool::Options o;
+	options->device = o.device;
+	options->encode_sii = o.encodeSII;
+	options->encode_pdo = o.encodePdo;
+	options->verify_roundtrip = o.verifyRoundtrip;
+	options->write_ssc = o.writeSSC;
+	options->capitalize_struct_members = o.capitalizeStructMembers;
+	options->append_object_index_to_structs = o.appendObjectIndexToStructs;
+	options->input_is_little_endian = o.inputIsLittleEndian;
+	options->verbosity = o.verbosity;
+}
+
+esctool_result* esctool_generate(const char* esi, size_t len, const esctool_options* options) {
+	ESCTool::Options o;
+	if(NULL != options) {
+		o.device = options->device;
+		o.encodeSII = options->encode_sii;
+		o.encodePdo = options->encode_pdo;
+		o.verifyRoundtrip = options->verify_roundtrip;
+		o.writeSSC = options->write_ssc;
+		o.capitalizeStructMembers = options->capitalize_struct_members;
+		o.appendObjectIndexToStructs = options->append_object_index_to_structs;
+		o.inputIsLittleEndian = options->input_is_little_endian;
+		o.verbosity = options->verbosity;
+	}
+	esctool_result* result = new esctool_result;
+	result->ok = ESCTool::generate(esi,len,o,result->output);
+	for(const auto& file : result->output.files)
+		result->files.push_back(&file);
+	return result;
+}
+
+int esctool_result_ok(const esctool_result* result) {
+	return result->ok;
+}
+
+const char* esctool_result_error(const esctool_result* result) {
+	return result->output.error.c_str();
+}
+
+const uint8_t* esctool_result_eeprom(const esctool_result* result, size_t* len) {
+	if(NULL != len) *len = result->output.eeprom.size();
+	return result->output.eeprom.data();
+}
+
+size_t esctool_result_file_count(const esctool_result* result) {
+	return result->files.size();
+}
+
+const char* esctool_result_file_name(const esctool_result* result, size_t n) {
+	if(n >= result->files.size()) return NULL;
+	return result->files[n]->first.c_str();
+}
+
+const char* esctool_result_file_data(const esctool_result* result, size_t n, size_t* len) {
+	if(n >= result->files.size()) return NULL;
+	if(NULL != len) *len = result->files[n]->second.size();
+	return result->files[n]->second.c_str();
+}
+
+void esctool_result_free(esctool_result* result) {
+	delete result;
+}
+
+char* esctool_decode(const uint8_t* eeprom, size_t len) {
+	std::string json, error;
+	if(!ESCTool::decode(eeprom,len,json,error)) return NULL;
+	char* out = (char*)malloc(json.size() + 1);
+	if(NULL != out) memcpy(out,json.c_str(),json.size() + 1);
+	return out;
+}
+
+void esctool_free(void* p) {
+	free(p);
+}
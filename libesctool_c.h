@@ -0,0 +1,50 @@
+#ifndef LIBESCTOOL_C_H
+#define LIBESCTOOL_C_H
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * C interface to libesctool, see libesctool.h. Results are owned by the
+ * library until released with esctool_result_free()/esctool_free().
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esctool_options {
+	unsigned int device;
+	int encode_sii;
+	int encode_pdo;
+	int verify_roundtrip;
+	int write_ssc;
+	int capitalize_struct_members;
+	int append_object_index_to_structs;
+	int input_is_little_endian;
+	int verbosity;
+} esctool_options;
+
+typedef struct esctool_result esctool_result;
+
+const char* esctool_version(void);
+int esctool_api_version(void);
+void esctool_default_options(esctool_options* options);
+
+/* Never returns NULL, check esctool_result_ok() */
+esctool_result* esctool_generate(const char* esi, size_t len, const esctool_options* options);
+int esctool_result_ok(const esctool_result* result);
+const char* esctool_result_error(const esctool_result* result);
+const uint8_t* esctool_result_eeprom(const esctool_result* result, size_t* len);
+size_t esctool_result_file_count(const esctool_result* result);
+const char* esctool_result_file_name(const esctool_result* result, size_t n);
+const char* esctool_result_file_data(const esctool_result* result, size_t n, size_t* len);
+void esctool_result_free(esctool_result* result);
+
+/* JSON of a SII image, NULL if invalid. Free with esctool_free() */
+char* esctool_decode(const uint8_t* eeprom, size_t len);
+void esctool_free(void* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBESCTOOL_C_H */
@@ -26,6 +26,8 @@
 #include <cstdint>
 #include <iomanip>
 #include <algorithm>
+#include <memory>
+#include <chrono>
 #include <list>
 #include <vector>
 
@@ -40,15 +42,32 @@
 #include "sii.h"
 #include "soesconfigwriter.h"
 #include "esixmlparsing.h"
+#include "objectdictionary.h"
 #include "utilfunc.h"
+#include "profiler.h"
+#include "allocstats.h"
+#include "runstats.h"
+#include "jsonwriter.h"
+#include "outputsink.h"
+#include "filewatcher.h"
+#include "manifest.h"
+#include "socketserver.h"
+#include "builddeps.h"
+#include "templateengine.h"
+#include "esiwriter.h"
+#include "textemitter.h"
 
 std::vector<char*> m_customStr;
 
 bool writeobjectdict = false;
 bool nosii = false;
 bool encodepdo = false; // Put PDOs in SII EEPROM
+bool verifyroundtrip = false; // Decode the encoded SII in memory and compare before writing
 bool capitalizeStructMembers = false;
 bool indexPostfixStructs = false;
+unsigned int jobs = 0; // Threads for batch modes and generating sources, 0: one per core
+// Output name and template of --template, compiled once before the first run
+std::list<std::pair<std::string,Template>> templates;
 
 // Decide if input from XML should be treated as LE
 bool input_endianness_is_little = false;
@@ -56,23 +75,68 @@ std::string catalogFile("");
 
 void printUsage(const char* name) {
 	printf("Usage: %s [options] --input/-i <input-file>\n",name);
+	printf("\t('-' as input file reads the ESI from stdin)\n");
 	printf("Options:\n");
 	printf("\t --decode : Decode and print a binary SII file\n");
+	printf("\t --decode-multi : Decode a file of concatenated SII images, one per slave position\n");
+	printf("\t --record-size : Size in bytes of each image for --decode-multi (default: 32 bit length prefixed records)\n");
+	printf("\t --diff <a> <b> [<c> ...] : Report field level differences between SII image a and each of the following images\n");
+	printf("\t --decode-dir <dir> : Decode all SII images in dir and print a CSV fleet inventory (JSON with --json)\n");
+	printf("\t --manifest <file> : Run the encode jobs of a JSON manifest, parsing each ESI file once (see manifest.h)\n");
+	printf("\t --serve-socket <path> : Serve encode requests of build workers on a Unix domain socket (see socketserver.h)\n");
+	printf("\t --cache <n> : Number of parsed ESI models --serve-socket keeps (default: 16)\n");
+	printf("\t --jobs/-j <n> : Number of threads for --decode-dir, --manifest, --serve-socket and generating the SOES files (default: one per core)\n");
+	printf("\t --minify <device> : Write an ESI file of only this device (index, name or product code '#x...' or '0x...'), see esiwriter.h\n");
+	printf("\t --minify-keep <parts> : Parts --minify keeps, comma separated: dictionary, modules or all (default: neither)\n");
+	printf("\t --golden <file> : Reference image, --decode-dir reports images deviating from it\n");
+	printf("\t --json : Print decoded SII as JSON (only for --decode)\n");
+	printf("\t --stats=json[:<file>] : Write run statistics as JSON to stderr or file at exit\n");
+	printf("\t --alloc-stats : Print heap allocations per phase (needs a build with -DESCTOOL_ALLOC_STATS=ON)\n");
+	printf("\t --profile[=<file>] : Print time spent per phase and write a Chrome trace (default: esctool_trace.json)\n");
+	printf("\t --verify : Only verify header and ConfigData checksum of binary SII file(s), additional files may follow the options\n");
 	printf("\t --verbose/-v : Flood some more information to stdout when applicable\n");
 	printf("\t --nosii/-n : Don't generate SII EEPROM binary (only for !--decode)\n");
 	printf("\t --dictionary/-d : Generate SSC object dictionary (default if --nosii and !--decode)\n");
 	printf("\t --index-postfix-structs/-ips : Append object index to structs, eg. OUTPUTS becomes OUTPUTS0x7000.\n");
 	printf("\t --capitalize-struct-members/-csm : Make member names in structs all capitalizes eg. OUTPUTS.outputs0 becomes OUTPUTS.OUTPUTS0.\n");
+	printf("\t --template <file> : Also write a source rendered from a template (see templateengine.h), named as the file without '.tpl'\n");
 	printf("\t --encodepdo/-ep : Encode PDOs to SII EEPROM\n");
+	printf("\t --verify-roundtrip : Decode the encoded SII in memory and compare it to the ESI before writing, fail on any mismatch\n");
 	printf("\t --output-directory/-odir : Specify output directory (created if non-existant)\n");
-	printf("\t --output/-o : Specify output SII filename\n");
+	printf("\t --output/-o : Specify output SII filename, '-' writes the SII image to stdout\n");
 	printf("\t --catalog/-c : Specify device catalog file explicitly (default: esctool.json)\n");
+	printf("\t --tar <file> : Write all generated files into one tar archive instead, '-' for stdout (also for --manifest)\n");
+	printf("\t --depfile <file> : Write a Makefile rule of the files read and generated (for make/ninja)\n");
+	printf("\t --output-manifest <file> : Write the files read and generated as JSON\n");
+	printf("\t --watch : Keep running and regenerate the outputs whenever the input (or catalog) file is saved\n");
 	printf("\n");
 }
 
-int encodeSII(const std::string& inputfile, std::string output = "", const std::string& outdir = "") {
+// All of stdin, for the input file "-"
+std::string readStdin(void) {
+	std::string data;
+	char buf[65536];
+	for(size_t n; (n = fread(buf,1,sizeof(buf),stdin)) > 0; ) data.append(buf,n);
+	return data;
+}
+
+// inputfile "-" reads the ESI from stdin. The SII image goes to siisink
+// if given, otherwise like the other outputs to sink or outdir
+int encodeSII(const std::string& inputfile, std::string output = "", const std::string& outdir = "",
+	OutputSink* sink = NULL, OutputSink* siisink = NULL)
+{
+	// Names synthesized for a previous model are no longer referenced
+	for(char* s : m_customStr) delete[] s;
+	m_customStr.clear();
+
 	ESIXML esixml((verbose ? 0x1 : 0x0) + (very_verbose ? 0x2 : 0x0));
-	esixml.parse(inputfile);
+	AllocPhase parsephase("Parse");
+	if(inputfile == "-") {
+		std::string esi = readStdin();
+		esixml.parse(esi.data(),esi.size(),"(stdin)");
+	} else
+		esixml.parse(inputfile);
+	parsephase.end();
 
 	if(!esixml.getDevices().empty()) {
 
@@ -83,377 +147,16 @@ int encodeSII(const std::string& inputfile, std::string output = "", const std::
 		Device* dev = esixml.getDevices().front();
 
 		// Create a boilerplate object dictionary if nothing exists and CoE is enabled
-		if(writeobjectdict && dev->mailbox && dev->mailbox->coe_sdoinfo)
+		if((writeobjectdict || !templates.empty()) && dev->mailbox && dev->mailbox->coe_sdoinfo)
 		{
-			printf("Verifying and/or creating minimal object dictionary...\n");
-
-			if(!dev->profile) dev->profile = new Profile;
-			if(!dev->profile->dictionary) {
-				printf("\033[0;31mWARNING:\033[0m Creating empty dictionary\n");
-				dev->profile->dictionary = new Dictionary;
-			}
-
-			Dictionary* dict = dev->profile->dictionary;
-			auto findDT = [&dict](const char* dtname, uint32_t bitsize) {
-				for(DataType* d : dict->datatypes)
-					if(0 == strcmp(d->name,dtname)) return d;
-				printf("Creating DataType '%s' (%d bits)\n",dtname,bitsize);
-				dict->datatypes.push_back(new DataType {
-					.name = dtname,
-					.bitsize = bitsize
-				});
-				return dict->datatypes.back();
-			};
-
-			DataType* DT_UDINT = findDT(UDINTstr,32);
-			DataType* DT_UINT = findDT(UINTstr,16);
-			DataType* DT_USINT = findDT(USINTstr,8);
-			DataType* DT_DINT = findDT(DINTstr,32);
-			DataType* DT_INT = findDT(INTstr,16);
-			DataType* DT_SINT = findDT(SINTstr,8);
-			DataType* DT_ULINT = findDT(ULINTstr,64);
-			
-			size_t L = 32;
-			char s[L];
-
-			auto createStr = [&s]() {
-				char* newStr = new char[strlen(s)+1];
-				strcpy(newStr,s);
-				m_customStr.push_back(newStr);
-				return newStr;
-			};
-
-			auto hasObject = [&dict](uint16_t index) {
-				for(Object* o : dict->objects) {
-					if(o->index == index) return o;
-				}
-				return (Object*)NULL;
-			};
-
-			if(!hasObject(0x1000)) {
-				if(dev->profile->channelinfo && dev->profile->channelinfo->profileNo) {
-					snprintf(s,L,"%.08u",dev->profile->channelinfo->profileNo);
-				} else {
-					snprintf(s,L,"%s","00001389"); // Hex representation of 5001
-				}
-
-				dict->objects.push_back(new Object {
-					.index = 0x1000,
-					.name = devTypeStr,
-					.datatype = DT_UDINT,
-					.defaultdata = createStr()
-				});
-			}
-
-			if(!hasObject(0x1008)) {
-				snprintf(s,L,"STRING(%lu)",strlen(dev->name));
-
-				dict->objects.push_back(new Object {
-					.index = 0x1008,
-					.name = devNameStr,
-					.type = createStr(),
-					.defaultstring = dev->name
-				});
-			}
-
-			// RX/TXPDO mapping
-			for(auto pdoList : { dev->rxpdo, dev->txpdo }) {
-				int pdoDefNo = 0;
-				for(Pdo* pdo : pdoList) {
-					Object* pdo_obj = new Object;
-					pdo_obj->index = pdo->index;
-					if(pdo->index >= 0x1600 && pdo->index < 0x1A00) {
-						snprintf(s,L,"RXPDO %.02d",pdoDefNo++);
-					} else {
-						snprintf(s,L,"TXPDO %.02d",pdoDefNo++);
-					}
-					pdo_obj->name = createStr();
-					uint32_t rxsize_bytes = 0;
-
-					DataType* dt = NULL;
-					snprintf(s,L,"DT%.04X",pdo->index);
-
-					for(DataType* d : dict->datatypes) {
-						if(0 == strcmp(d->name,s)) {
-							if(verbose) printf("Found datatype '%s' in dictionary!\n",s);
-							dt = d;
-							break;
-						}
-					}
-					if(dt != NULL) continue;
-					printf("Generating datatype '%s'\n",s);
-
-					dt = new DataType;
-					dt->name = createStr();
-					printf("%s\n",dt->name);
-					pdo_obj->datatype = dt;
-
-					if(pdo->entries.size() > 0) {
-						Object* numberOfEntries_obj = new Object;
-						numberOfEntries_obj->name = numberOfEntriesStr;
-						// Create the DataType subitem for the first subindex (USINT)
-						DataType* sdt = new DataType;
-						sdt->name = subIndex000Str;
-						sdt->type = DT_USINT->name;
-						sdt->bitsize = DT_USINT->bitsize;
-						sdt->bitoffset = 0;
-						sdt->subindex = 0;
-						dt->subitems.push_back(sdt);
-						numberOfEntries_obj->index = pdo->index;
-						numberOfEntries_obj->datatype = sdt;
-						numberOfEntries_obj->bitsize = sdt->bitsize;
-						dt->bitsize += numberOfEntries_obj->datatype->bitsize;
-						dt->bitsize += numberOfEntries_obj->datatype->bitsize; // FIXME this is padding (set to 16 instead?)
-
-						snprintf(s,L,"%.02X",(uint32_t)(pdo->entries.size() & 0xFF));
-						char* numberOfEntriesVal = createStr();
-						numberOfEntries_obj->defaultdata = numberOfEntriesVal;
-						pdo_obj->subitems.push_back(numberOfEntries_obj);
-
-						for(PdoEntry* e : pdo->entries) {
-							// Create the DataType subitem for current subindex
-							sdt = new DataType;
-							Object* pdoEntry_obj = new Object;
-							snprintf(s,L,"SubIndex %.03d",e->subindex);
-							char* entryName = createStr();
-							sdt->name = entryName;
-							sdt->subindex = e->subindex;
-							sdt->type = e->datatype;
-							// Set the offset of the "new" datatype subitem
-							sdt->bitoffset = dt->bitsize;
-							sdt->bitsize = e->bitlen;
-							// Increase the bitsize
-							dt->bitsize += e->bitlen;
-							// TODO Flags etc.
-							pdoEntry_obj->index = pdo->index;
-							pdoEntry_obj->name = entryName;
-							pdoEntry_obj->datatype = DT_UDINT;
-
-							snprintf(s,L,"%.04X%.02X%.02X",e->index,e->subindex,e->bitlen);
-							char* defaultData = createStr();
-							pdoEntry_obj->defaultdata = defaultData;
-
-							pdo_obj->subitems.push_back(pdoEntry_obj);
-							dt->subitems.push_back(sdt);
-						}
-					}
-					dict->datatypes.push_back(dt);
-					dict->objects.push_back(pdo_obj);
-				}
-			}
-
-			auto createArrayDT = [&dict,&createStr,L,&s,&DT_USINT](uint16_t index, const int entries, DataType* entryDT) {
-				snprintf(s,L,"DT%.04XARR",index);
-				for(DataType* d : dict->datatypes) {
-					if(0 == strcmp(d->name,s)) {
-						if(verbose) printf("Found datatype '%s' in dictionary!\n",s);
-						return d;
-					}
-				}
-				printf("Generating datatype '%s'\n",s);
-				DataType* dtARR = new DataType;
-				dtARR->name = createStr();
-				dtARR->basetype = entryDT->name;
-				dtARR->bitsize = entries*(entryDT->bitsize);
-				dtARR->arrayinfo = new ArrayInfo;
-				dtARR->arrayinfo->elements = entries;
-				dtARR->arrayinfo->lowerbound = 1;
-				dict->datatypes.push_back(dtARR);
-				DataType* dt = new DataType;
-				snprintf(s,L,"DT%.04X",index);
-				dt->name = createStr();
-				dt->bitsize = dtARR->bitsize+DT_USINT->bitsize+8;
-				dt->subitems.push_back(
-					new DataType {
-						.name = subIndex000Str,
-						.type = DT_USINT->name,
-						.bitsize = DT_USINT->bitsize,
-						.subindex = 0 });
-				dt->subitems.push_back(
-					new DataType {
-						.name = "Elements",
-						.type = dtARR->name,
-						.bitsize = dtARR->bitsize,
-						.bitoffset = DT_USINT->bitsize+8 });
-				dt->arrayinfo = dtARR->arrayinfo;
-				dict->datatypes.push_back(dt);
-				return dt;
-			};
-
-			if(!hasObject(0x1C00)) {
-				// SyncManager types 0x1C00
-				DataType* DT1C00 = createArrayDT(0x1C00,dev->syncmanagers.size(),DT_USINT);
-
-				Object* x1C00 = new Object;
-				x1C00->index = 0x1C00;
-				x1C00->datatype = DT1C00;
-				x1C00->bitsize = DT1C00->bitsize;
-				x1C00->name = devSMTypeStr;
-
-				snprintf(s,L,"%.02lu",dev->syncmanagers.size());
-
-				x1C00->subitems.push_back(new Object {
-						.index = x1C00->index,
-						.name = subIndex000Str,
-						.datatype = DT_USINT,
-						.defaultdata = createStr()});
-
-				uint8_t smno = 0;
-				for(SyncManager* sm : dev->syncmanagers) {
-					Object* sm_obj = new Object;
-					sm_obj->index = x1C00->index;
-					sm_obj->datatype = DT_USINT;
-					snprintf(s,L,"SM%d type",smno);
-					sm_obj->name = createStr();
-
-					if(0 == strcmp(sm->type,"MBoxOut")) {
-						snprintf(s,L,"%.02d",1);
-					} else if(0 == strcmp(sm->type,"MBoxIn")) {
-						snprintf(s,L,"%.02d",2);
-					} else if(0 == strcmp(sm->type,"Outputs")) {
-						snprintf(s,L,"%.02d",3);
-					} else if(0 == strcmp(sm->type,"Inputs")) {
-						snprintf(s,L,"%.02d",4);
-					}
-
-					sm_obj->defaultdata = createStr();
-					sm_obj->bitsize = DT_USINT->bitsize;
-					sm_obj->bitoffset = (smno * DT_USINT->bitsize);
-					++smno;
-					x1C00->subitems.push_back(sm_obj);
-				}
-				dict->objects.push_back(x1C00);
-			}
-
-			// SyncManager mappings 0x1C10-0x1C20
-			// Add PDOs to each sync manager mapping, and create each SM's respective
-			// objects
-			std::vector<std::list<Pdo*> > syncManagerMappings = {{},{},{},{}};
-
-			// TODO: If the device has slots, with predefined modules, with fixed
-			// PDOs, we should go through these and add them
-
-			// Go through the device PDOs
-			for(auto pdoList : { dev->rxpdo, dev->txpdo }) {
-				for(Pdo* pdo : pdoList)
-					syncManagerMappings[pdo->syncmanager].push_back(pdo);
-			}
-
-			uint8_t smno = 0;
-			for(auto pdoList : syncManagerMappings) {
-
-				if(hasObject(0x1C10 + smno)) continue;
-
-				Object* mappingObject = new Object;
-				mappingObject->index = 0x1C10 + smno;
-				DataType* DTmapping = createArrayDT(mappingObject->index,pdoList.size(),DT_UINT);
-				mappingObject->datatype = DTmapping;
-
-				snprintf(s,L,"SM%d mappings",smno);
-				mappingObject->name = createStr();
-				mappingObject->bitsize = 16; // size + padding
-
-				snprintf(s,L,"%.02lu",pdoList.size());
-
-				mappingObject->subitems.push_back(new Object {
-						.index = mappingObject->index,
-						.name = subIndex000Str,
-						.datatype = DT_USINT,
-						.defaultdata = createStr()});
-
-				// The user will have adjust the maxsubindex in the SSC code
-				// to deal with which modules are present and reflect
-				// this properly
-				if(dev->slots && (2 == smno || 3 == smno)) {
-					// TODO: here we should really check through the slots to check for fixed PDOs
-					ObjectFlags* flags = new ObjectFlags;
-					flags->access = new ObjectAccess;
-					snprintf(s,L,"%s","rw");
-					flags->access->access = createStr();
-					snprintf(s,L,"%s","PreOP");
-					flags->access->writerestrictions = createStr();
-					snprintf(s,L,"%s","Mapped object");
-					const char* name = createStr();
-
-					// We're now running with dynamic PDOs so the max subindex should be writeable
-					mappingObject->subitems.front()->flags = flags;
-
-					for(uint8_t j = 0; j < dev->slots->maxslotcount; ++j) {
-						Object* mappedObj = new Object;
-						mappedObj->index = mappingObject->index;
-						mappedObj->datatype = DT_UINT;
-						snprintf(s,L,"%.04X",0x0);
-						mappedObj->defaultdata = createStr();
-						mappedObj->name = name;
-						mappedObj->bitoffset = mappingObject->bitsize;
-						mappingObject->bitsize += DT_UINT->bitsize;
-						mappedObj->bitsize = DT_UINT->bitsize;
-						mappedObj->flags = flags;
-						mappingObject->subitems.push_back(mappedObj);
-					}
-				}
-
-				for(auto pdo : pdoList) {
-					Object* mappedObj = new Object;
-					mappedObj->index = mappingObject->index;
-					mappedObj->datatype = DT_UINT;
-					snprintf(s,L,"%.02X",pdo->index);
-					mappedObj->defaultdata = createStr();
-					mappedObj->name = pdo->name != NULL ? pdo->name : "Mapped object";
-					mappedObj->bitoffset = mappingObject->bitsize;
-					mappingObject->bitsize += DT_UINT->bitsize;
-					mappedObj->bitsize = DT_UINT->bitsize;
-					mappingObject->subitems.push_back(mappedObj);
-				}
-
-				dict->objects.push_back(mappingObject);
-				++smno;
-			}
+			ScopedTimer timer("Synthesize dictionary");
+			AllocPhase phase("Synthesize");
+			ObjectDictionary::synthesize(dev,m_customStr,verbose);
 		}
 
-		auto findDT = [dict=dev->profile->dictionary](const char* dtname) {
-			if(NULL == dtname) return (DataType*)NULL;
-			for(DataType* d : dict->datatypes)
-				if(0 == strcmp(d->name,dtname)) return d;
-			printf("findDT: Could not find datatype for '%s'\n",dtname);
-			return (DataType*)NULL;
-		};
-
-		for(DataType* datatype : dev->profile->dictionary->datatypes) {
-			if(!datatype->subitems.empty() || datatype->arrayinfo) {
-				uint32_t bitsize = 0;
-				if(datatype->arrayinfo && NULL != datatype->basetype) {
-					DataType* basedt = findDT(datatype->basetype);
-					if(NULL != basedt) {
-						bitsize = basedt->bitsize * datatype->arrayinfo->elements;
-					}
-				} else {
-					int siNo = 0;
-					for(DataType* dt : datatype->subitems) {
-						if(siNo == 0) {
-							bitsize += dt->bitsize;
-							bitsize += 8; // Padding/16 bit alignment
-						} else {
-							DataType* basedt = findDT(dt->type);
-							if(basedt && basedt->arrayinfo) {
-								DataType* basedt = findDT(dt->type);
-								if(NULL != basedt) {
-									bitsize += basedt->bitsize;
-								} else
-									printf("\033[0;31mWARNING:\033[0m DataType '%s' Could not find array basetype '%s'\n",datatype->name,dt->type);
-							} else
-								bitsize += dt->bitsize;
-						}
-						++siNo;
-					}
-				}
-				bitsize += bitsize%16; // 16 bit alignment
-				if(datatype->bitsize != bitsize) {
-					printf("\033[0;31mWARNING:\033[0m Bitsize of datatype '%s' seems off (calculated %d vs. parsed %d)\n",datatype->name,bitsize,datatype->bitsize);
-					if(verbose) printDataTypeVerbose(datatype);
-				}
-			}
-		}
+		ScopedTimer bitsizetimer("Validate bitsizes");
+		ObjectDictionary::validateBitsizes(dev,verbose);
+		bitsizetimer.stop();
 
 		if(verbose) {
 			printf("Profile: %s\n",dev->profile ? "yes" : "no");
@@ -473,32 +176,52 @@ int encodeSII(const std::string& inputfile, std::string output = "", const std::
 			printf("Distributed Clock (DC): %s\n",dev->dc ? "yes" : "no");
 		}
 
-		// Sort objects by index...
-		if(NULL != dev->profile && NULL != dev->profile->dictionary) {
-			dev->profile->dictionary->objects.sort([](const Object* objA, const Object* objB) {
-				return objA->index < objB->index;
-			});
-		}
+		ObjectDictionary::sortObjects(dev);
 
 		// Write SII EEPROM file
 		if(!nosii) {
 			if(0 == output.size())
-				output = std::string(basename(inputfile.c_str())) + "_eeprom.bin";
+				output = std::string(inputfile == "-" ? "stdin" : basename(inputfile.c_str())) + "_eeprom.bin";
 
-			SII::encodeEEPROMBinary(esixml.getVendorID(),
+			ScopedTimer timer("Encode SII",output);
+			AllocPhase phase("Encode");
+			if(!SII::encodeEEPROMBinary(esixml.getVendorID(),
 				dev, encodepdo, inputfile, outdir,
-				output, very_verbose);
+				output, very_verbose, siisink ? siisink : sink,
+				verifyroundtrip))
+				return 1;
 		}
 
 		// Write slave stack object dictionary
 		if(writeobjectdict && NULL != dev->profile &&
 		NULL != dev->profile->dictionary)
 		{
-			SOESConfigWriter sscwriter(outdir,input_endianness_is_little);
-			sscwriter.writeSSCFiles(dev,{ .capitalizeStructMembers = capitalizeStructMembers, .appendObjectIndexToStructs = indexPostfixStructs });
+			AllocPhase phase("Generate");
+			SOESConfigWriter sscwriter(outdir,input_endianness_is_little,sink);
+			if(!sscwriter.writeSSCFiles(dev,{ .capitalizeStructMembers = capitalizeStructMembers,
+				.appendObjectIndexToStructs = indexPostfixStructs, .jobs = jobs }))
+				return 1;
 		}
 
-		// TODO: Delete it all...
+		// Sources of --template, after the built-in ones
+		if(!templates.empty()) {
+			AllocPhase phase("Generate");
+			DirectorySink dirsink(outdir);
+			OutputSink& out = sink ? *sink : dirsink;
+			SSCWriter::OutputParams params = { .capitalizeStructMembers = capitalizeStructMembers,
+				.appendObjectIndexToStructs = indexPostfixStructs };
+			// What the SOES writer derives, once for all templates
+			std::unique_ptr<SOESValues> values;
+			for(const auto& t : templates)
+				if(t.second.derived() && !values) values.reset(new SOESValues(dev,input_endianness_is_little,params));
+			for(const auto& t : templates) {
+				ScopedTimer timer("Render template",t.first);
+				TextEmitter text;
+				t.second.render(dev,esixml.getVendorID(),text,values.get(),params);
+				RunStats::instance().addOutput(t.first,(unsigned long)text.size());
+				if(!out.write(t.first,text.str())) return 1;
+			}
+		}
 	} else {
 		printf("No devices could be parsed\n");
 	}
@@ -506,16 +229,103 @@ int encodeSII(const std::string& inputfile, std::string output = "", const std::
 	return 0;
 }
 
+// Writes the selected device as an ESI file of its own, by default named
+// after the input with '_min.xml'
+int minifyESI(const std::string& inputfile, const std::string& selector, unsigned int parts,
+	std::string output, OutputSink& sink)
+{
+	ESIXML esixml((verbose ? 0x1 : 0x0) + (very_verbose ? 0x2 : 0x0));
+	if(inputfile == "-") {
+		std::string esi = readStdin();
+		if(!esixml.parse(esi.data(),esi.size(),"(stdin)")) return 1;
+	} else
+	if(!esixml.parse(inputfile)) return 1;
+
+	Device* dev = esixml.findDevice(selector);
+	if(NULL == dev) {
+		printf("\033[0;31mERROR:\033[0m No device '%s' in '%s'\n",selector.c_str(),inputfile.c_str());
+		return 1;
+	}
+	if(0 == output.size()) {
+		output = inputfile == "-" ? "stdin" : basename(inputfile.c_str());
+		if(output.size() > 4 && 0 == output.compare(output.size() - 4,4,".xml")) output.resize(output.size() - 4);
+		output += "_min.xml";
+	}
+
+	ScopedTimer timer("Minify",output);
+	std::string xml;
+	ESIWriter(parts).write(esixml.getVendorID(),esixml.getVendorName(),dev,xml);
+	RunStats::instance().addOutput(output,(unsigned long)xml.size());
+	if(!sink.write(output,xml)) return 1;
+	printf("Wrote device '%s' to '%s' (%lu bytes)\n",dev->name ? dev->name : "",output.c_str(),xml.size());
+	return 0;
+}
+
+// Encode once, then again whenever the input or catalog file is saved.
+// Outputs whose content did not change are not rewritten.
+int watchSII(const std::string& inputfile, const std::string& output, const std::string& outdir) {
+	FileWatcher watcher;
+	if(!watcher.add(inputfile)) return -EINVAL;
+	if(catalogFile != "" && !watcher.add(catalogFile)) return -EINVAL;
+	DirectorySink dirsink(outdir);
+	ChangedOnlySink sink(dirsink);
+
+	int ret = encodeSII(inputfile,output,outdir,&sink);
+	std::vector<std::string> changed;
+	for(;;) {
+		printf("\033[0;32mWatching '%s' for changes\033[0m (Ctrl+C to stop)\n",inputfile.c_str());
+		fflush(stdout);
+		if(!watcher.wait(changed)) return ret ? ret : -EIO;
+		for(const std::string& f : changed) printf("\n'%s' changed\n",f.c_str());
+		auto start = std::chrono::steady_clock::now();
+		sink.resetCounts();
+		ret = encodeSII(inputfile,output,outdir,&sink);
+		double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now() - start).count();
+		printf("Regenerated in %.1f ms: %u file(s) written, %u unchanged\n",ms,sink.changed(),sink.unchanged());
+	}
+}
+
 int main(int argc, char* argv[])
 {
-	printf("%s v%s\n",APP_NAME,APP_VERSION);
 	// We by default assume we're encoding a XML slave specification
 	bool encode = true;
 	bool decode = false;
+	bool verify = false;
+	bool json = false;
+	bool decodemulti = false;
+	size_t recordsize = 0;
+	std::string diffgolden = "";
+	std::string decodedir = "";
+	std::string golden = "";
+	bool machine = false;
+	std::string tracefile = "";
+	std::string statsfile = "";
+	bool stats = false;
 	bool daemonize = false;
+	bool watch = false;
+	std::string manifest = "";
+	std::string servesocket = "";
+	unsigned int cachesize = 16;
+	std::string tarfile = "";
+	std::string depfile = "";
+	std::string outputmanifest = "";
 	std::string inputfile = "";
+	std::vector<std::string> extrainputs;
 	std::string outputfile = "";
 	std::string outdir = "";
+	std::vector<std::string> templatefiles;
+	std::string minify = "";
+	unsigned int minifyparts = 0;
+
+	// Keep stdout clean for machine readable and binary output
+	FILE* binaryout = NULL;
+	for(int i = 0; i < argc; ++i) {
+		if(0 == strcmp(argv[i],"--json") || 0 == strcmp(argv[i],"--decode-dir")) machine = true;
+		if((0 == strcmp(argv[i],"--tar") || 0 == strcmp(argv[i],"--output") || 0 == strcmp(argv[i],"-o")) &&
+		i + 1 < argc && 0 == strcmp(argv[i+1],"-") && NULL == binaryout)
+			binaryout = claimStdout();
+	}
+	if(!machine) printf("%s v%s\n",APP_NAME,APP_VERSION);
 
 	for(int i = 0; i < argc; ++i) {
 		if(0 == strcmp(argv[i],"--input") ||
@@ -547,6 +357,9 @@ int main(int argc, char* argv[])
 			printf("Encoding PDOs to SII EEPROM binary\n");
 			encodepdo = true;
 		} else
+		if(0 == strcmp(argv[i],"--verify-roundtrip")) {
+			verifyroundtrip = true;
+		} else
 		if(0 == strcmp(argv[i],"--bigendian") ||
 		   0 == strcmp(argv[i],"-be"))
 		{
@@ -617,18 +430,137 @@ int main(int argc, char* argv[])
 			decode = true;
 			encode = false;
 		} else
+		if(0 == strcmp(argv[i],"--decode-multi")) {
+			decodemulti = true;
+			encode = false;
+		} else
+		if(0 == strcmp(argv[i],"--record-size")) {
+			recordsize = hexdecstr2uint32(argv[++i]);
+		} else
+		if(0 == strcmp(argv[i],"--diff")) {
+			diffgolden = argv[++i];
+			encode = false;
+		} else
+		if(0 == strcmp(argv[i],"--decode-dir")) {
+			decodedir = argv[++i];
+			encode = false;
+		} else
+		if(0 == strcmp(argv[i],"--jobs") ||
+		   0 == strcmp(argv[i],"-j"))
+		{
+			jobs = hexdecstr2uint32(argv[++i]);
+		} else
+		if(0 == strcmp(argv[i],"--golden")) {
+			golden = argv[++i];
+		} else
+		if(0 == strcmp(argv[i],"--profile") ||
+		   0 == strncmp(argv[i],"--profile=",10))
+		{
+			tracefile = argv[i][9] == '=' ? &argv[i][10] : "esctool_trace.json";
+			Profiler::instance().enable();
+		} else
+		if(0 == strcmp(argv[i],"--stats=json") ||
+		   0 == strncmp(argv[i],"--stats=json:",13))
+		{
+			stats = true;
+			if(argv[i][12] == ':') statsfile = &argv[i][13];
+		} else
+		if(0 == strcmp(argv[i],"--alloc-stats")) {
+			AllocStats::enable();
+			if(!AllocStats::available()) printf("Allocation statistics need a build with -DESCTOOL_ALLOC_STATS=ON\n");
+		} else
+		if(0 == strcmp(argv[i],"--json")) {
+			json = true;
+		} else
+		if(0 == strcmp(argv[i],"--verify")) {
+			verify = true;
+			encode = false;
+		} else
+		if(0 == strcmp(argv[i],"--manifest")) {
+			manifest = argv[++i];
+			encode = false;
+		} else
+		if(0 == strcmp(argv[i],"--serve-socket")) {
+			servesocket = argv[++i];
+			encode = false;
+		} else
+		if(0 == strcmp(argv[i],"--cache")) {
+			cachesize = hexdecstr2uint32(argv[++i]);
+		} else
+		if(0 == strcmp(argv[i],"--depfile")) {
+			depfile = argv[++i];
+		} else
+		if(0 == strcmp(argv[i],"--output-manifest")) {
+			outputmanifest = argv[++i];
+		} else
+		if(0 == strcmp(argv[i],"--minify")) {
+			minify = argv[++i];
+			encode = false;
+		} else
+		if(0 == strcmp(argv[i],"--minify-keep")) {
+			if(!ESIWriter::parseParts(argv[++i],minifyparts)) {
+				printf("Unknown part in '%s' (dictionary, modules, all)\n",argv[i]);
+				return -EINVAL;
+			}
+		} else
+		if(0 == strcmp(argv[i],"--template")) {
+			templatefiles.push_back(argv[++i]);
+		} else
+		if(0 == strcmp(argv[i],"--tar")) {
+			tarfile = argv[++i];
+		} else
+		if(0 == strcmp(argv[i],"--watch")) {
+			watch = true;
+		} else
 		if(0 == strcmp(argv[i],"--daemonize") ||
 		   0 == strcmp(argv[i],"-D"))
 		{
 			printf("Daemonizing...\n");
 			daemonize = true;
+		} else
+		if(i > 0 && argv[i][0] != '-') {
+			extrainputs.push_back(argv[i]);
 		}
 	}
-	if(encode && nosii && !writeobjectdict) {
+	if(encode && nosii && !writeobjectdict && templatefiles.empty()) {
 		printf("Assuming Object Dictionary should be generated...\n");
 		writeobjectdict = true;
 	}
-	printf("\n");
+	if(!machine) printf("\n");
+
+	// Print the phase summary and write the trace on any return from main
+	struct ProfileReport {
+		const std::string& file;
+		~ProfileReport() {
+			if(!Profiler::instance().enabled()) return;
+			fprintf(stderr,"\n");
+			Profiler::instance().printSummary(stderr);
+			if(Profiler::instance().writeTrace(file)) fprintf(stderr,"Wrote trace to '%s'\n",file.c_str());
+		};
+	} profilereport { tracefile };
+	struct StatsReport {
+		const bool& enabled;
+		const std::string& file;
+		~StatsReport() {
+			if(!enabled) return;
+			JSONWriter json;
+			RunStats::instance().write(json);
+			FILE* f = file.empty() ? stderr : fopen(file.c_str(),"w");
+			if(NULL == f) {
+				fprintf(stderr,"Could not open '%s' for writing the statistics\n",file.c_str());
+				return;
+			}
+			json.write(f);
+			if(f != stderr) fclose(f);
+		};
+	} statsreport { stats, statsfile };
+	struct AllocReport {
+		~AllocReport() {
+			if(!AllocStats::enabled()) return;
+			fprintf(stderr,"\n");
+			AllocStats::printReport(stderr);
+		};
+	} allocreport;
 
 	if(daemonize) {
 		HttpServer server;
@@ -642,6 +574,7 @@ int main(int argc, char* argv[])
 		server.when("/setup")
 			// Handle when data is posted here (POST)
 			->posted([](const HttpRequest& req) {
+				ScopedTimer timer("HTTP POST /setup");
 				std::string outfileName("");
 				if(catalogFile != "") outfileName = catalogFile;
 				else {
@@ -657,6 +590,7 @@ int main(int argc, char* argv[])
 			})
 			// Handle when data is requested from here (GET)
 			->requested([](const HttpRequest& req) {
+				ScopedTimer timer("HTTP GET /setup");
 				std::string inFilename("");
 				if(catalogFile != "") inFilename = catalogFile;
 				else {
@@ -677,6 +611,7 @@ int main(int argc, char* argv[])
 		server.whenMatching("/export/[^/]+")
 			// Handle when data is posted here (POST)
 			->posted([](const HttpRequest& req) {
+				ScopedTimer timer("HTTP POST /export",req.getPath());
 				const char* devicename = basename(req.getPath().c_str());
 				if(very_verbose) {
 					printf("XML document:\n");
@@ -736,14 +671,112 @@ int main(int argc, char* argv[])
 		server.startListening(5001);
 		printf("Done...\n");
 	} else {
-		if("" == inputfile) {
+		if(outputfile == "-" && tarfile == "-") {
+			printf("Only one of --output and --tar can go to stdout\n");
+			return -EINVAL;
+		}
+		if(watch && (inputfile == "-" || outputfile == "-")) {
+			printf("--watch needs files, not stdin/stdout\n");
+			return -EINVAL;
+		}
+		std::unique_ptr<TarSink> tar;
+		if("" != tarfile) {
+			if(watch) {
+				printf("--tar can not be combined with --watch\n");
+				return -EINVAL;
+			}
+			tar.reset(tarfile == "-" ? new TarSink(binaryout,"(stdout)") : new TarSink(tarfile));
+			if(!tar->ok()) return -EIO;
+		}
+		if("" != servesocket) {
+			if("" != tracefile || stats)
+				printf("\033[0;31mWARNING:\033[0m --profile and --stats are not recorded with --serve-socket\n");
+			SocketServer server(servesocket,jobs,cachesize,(verbose ? 0x1 : 0x0) + (very_verbose ? 0x2 : 0x0));
+			return server.run() ? 0 : -EIO;
+		}
+		if("" != manifest) {
+			int failed = Manifest::run(manifest,jobs,(verbose ? 0x1 : 0x0) + (very_verbose ? 0x2 : 0x0),tar.get());
+			if(tar && !tar->close()) return -EIO;
+			return failed < 0 ? -EINVAL : (failed ? 1 : 0);
+		}
+		if("" != minify) {
+			if("" == inputfile) {
+				printUsage(argv[0]);
+				return -EINVAL;
+			}
+			StreamSink out(outputfile == "-" ? binaryout : NULL,"(stdout)");
+			DirectorySink dirsink(outdir);
+			OutputSink& sink = outputfile == "-" ? (OutputSink&)out : (tar ? (OutputSink&)*tar : dirsink);
+			int ret = minifyESI(inputfile,minify,minifyparts,outputfile == "-" ? "" : outputfile,sink);
+			if(tar && !tar->close()) return ret ? ret : -EIO;
+			if(outputfile == "-" && !out.close()) return ret ? ret : -EIO;
+			return ret;
+		}
+		if("" != decodedir) {
+			return SII::decodeDirectory(decodedir,jobs,golden,json,verbose) ? -EINVAL : 0;
+		}
+		if("" != diffgolden) {
+			if("" != inputfile) extrainputs.insert(extrainputs.begin(),inputfile);
+			if(extrainputs.empty()) {
+				printUsage(argv[0]);
+				return -EINVAL;
+			}
+			return SII::diffEEPROMBinary(diffgolden,extrainputs,verbose) ? 1 : 0;
+		}
+		if("" == inputfile && !(verify && !extrainputs.empty())) {
 			printUsage(argv[0]);
 			return -EINVAL;
 		}
+		if(verify) {
+			if("" != inputfile) extrainputs.insert(extrainputs.begin(),inputfile);
+			int failed = 0;
+			for(const std::string& f : extrainputs)
+				if(!SII::verifyEEPROMBinary(f,verbose)) ++failed;
+			printf("Verified %zu file(s), %d failed\n",extrainputs.size(),failed);
+			return failed ? -EINVAL : 0;
+		} else
+		if(decodemulti) {
+			return SII::decodeEEPROMStream(inputfile,recordsize,verbose,json) ? -EINVAL : 0;
+		} else
 		if(decode) {
-			SII::decodeEEPROMBinary(inputfile,verbose);
+			SII::decodeEEPROMBinary(inputfile,verbose,json);
 		} else if(encode) {
-			return encodeSII(inputfile,outputfile,outdir);
+			for(const std::string& f : templatefiles) {
+				std::string name = basename(f.c_str());
+				if(name.size() > 4 && 0 == name.compare(name.size() - 4,4,".tpl")) name.resize(name.size() - 4);
+				templates.emplace_back(name,Template());
+				std::string error;
+				if(!templates.back().second.load(f,error)) {
+					printf("\033[0;31mERROR:\033[0m Template %s\n",error.c_str());
+					return -EINVAL;
+				}
+			}
+			if(watch) return watchSII(inputfile,outputfile,outdir);
+			// Names in the archive are without the output directory
+			std::vector<std::string> outputs;
+			std::vector<std::string> inputs;
+			if(inputfile != "-") inputs.push_back(inputfile);
+			inputs.insert(inputs.end(),templatefiles.begin(),templatefiles.end());
+			// The SII image alone on stdout, the rest where it would go otherwise
+			StreamSink siiout(outputfile == "-" ? binaryout : NULL,"(stdout)");
+			OutputSink* siisink = outputfile == "-" ? &siiout : NULL;
+			int ret = 0;
+			if(tar) {
+				ret = encodeSII(inputfile,outputfile,"",tar.get(),siisink);
+				if(!tar->close()) return ret ? ret : -EIO;
+				if(tarfile != "-") outputs.push_back(tarfile);
+			} else {
+				DirectorySink dirsink(outdir);
+				ret = encodeSII(inputfile,outputfile,outdir,&dirsink,siisink);
+				dirsink.printSummary(verbose);
+				for(auto names : { dirsink.written(), dirsink.unchanged() })
+					for(const std::string& name : names) outputs.push_back(outdir + name);
+				std::sort(outputs.begin(),outputs.end());
+			}
+			if(siisink && !siiout.close()) return ret ? ret : -EIO;
+			if(0 == ret && "" != depfile && !BuildDeps::writeDepfile(depfile,outputs,inputs)) return -EIO;
+			if(0 == ret && "" != outputmanifest && !BuildDeps::writeOutputManifest(outputmanifest,outputs,inputs)) return -EIO;
+			return ret;
 		}
 	}
 
@@ -0,0 +1,309 @@
+#include "manifest.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <vector>
+#include <errno.h>
+#include <sys/stat.h>
+#include "esctoolhelpers.h"
+#include "esixmlparsing.h"
+#include "json.h"
+#include "objectdictionary.h"
+#include "outputsink.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "sii.h"
+#include "siireader.h"
+#include "soesconfigwriter.h"
+
+namespace {
+
+using miniJson::Json;
+
+struct Job {
+	// From the manifest
+	std::string input;
+	std::string device; // As written, for messages
+	std::string selector = "0";
+	std::string outdir;
+	std::string output;
+	bool nosii = false;
+	bool dictionary = false;
+	bool encodepdo = false;
+	bool verifyroundtrip = false;
+	bool capitalizeStructMembers = false;
+	bool indexPostfixStructs = false;
+	bool little = false;
+
+	// Filled in while running
+	size_t esi = 0; // Into the parsed files
+	Device* dev = NULL;
+	bool ok = false;
+	std::string error;
+	double ms = 0;
+	size_t written = 0; // Files in the output directory
+	size_t unchanged = 0;
+};
+
+struct ESIFile {
+	std::string file;
+	std::unique_ptr<ESIXML> esixml;
+	bool parsed = false;
+	std::vector<char*> strings; // Synthesized names, freed with the file
+	std::map<Device*,bool> prepared; // Device -> synthesize the dictionary
+	~ESIFile() { for(char* s : strings) delete[] s; };
+};
+
+// Member of an object, NULL if missing. MiniJson throws on a missing key
+// of a const object, the non-const lookup adds it as null instead
+Json* member(Json& object, const char* key) {
+	if(!object.isObject()) return NULL;
+	Json& value = object[key];
+	return value.isNull() ? NULL : &value;
+}
+
+bool readFlags(const Json* flags, Job& job, std::string& error) {
+	if(NULL == flags) return true;
+	if(!flags->isArray()) {
+		error = "\"flags\" is not an array";
+		return false;
+	}
+	for(size_t i = 0; i < flags->size(); ++i) {
+		const Json& f = (*flags)[i];
+		if(!f.isString()) {
+			error = "\"flags\" must hold strings";
+			return false;
+		}
+		const std::string& name = f.toString();
+		const char* flag = name.c_str();
+		if(0 == strcmp(flag,"-ep") || 0 == strcmp(flag,"--encodepdo")) {
+			job.encodepdo = true;
+		} else
+		if(0 == strcmp(flag,"-d") || 0 == strcmp(flag,"--dictionary")) {
+			job.dictionary = true;
+		} else
+		if(0 == strcmp(flag,"-n") || 0 == strcmp(flag,"--nosii")) {
+			job.nosii = true;
+		} else
+		if(0 == strcmp(flag,"-csm") || 0 == strcmp(flag,"--capitalize-struct-members")) {
+			job.capitalizeStructMembers = true;
+		} else
+		if(0 == strcmp(flag,"-ips") || 0 == strcmp(flag,"--index-postfix-structs")) {
+			job.indexPostfixStructs = true;
+		} else
+		if(0 == strcmp(flag,"-le") || 0 == strcmp(flag,"--littleendian")) {
+			job.little = true;
+		} else
+		if(0 == strcmp(flag,"-be") || 0 == strcmp(flag,"--bigendian")) {
+			job.little = false;
+		} else
+		if(0 == strcmp(flag,"--verify-roundtrip")) {
+			job.verifyroundtrip = true;
+		} else
+		{
+			error = std::string("unsupported flag '") + flag + "'";
+			return false;
+		}
+	}
+	// As on the command line
+	if(job.nosii) job.dictionary = true;
+	return true;
+}
+
+bool readJobs(Json& root, std::vector<Job>& jobs, std::string& error) {
+	Json* list = member(root,"jobs");
+	if(NULL == list || !list->isArray()) {
+		error = "no \"jobs\" array";
+		return false;
+	}
+	for(size_t i = 0; i < list->size(); ++i) {
+		Json& entry = (*list)[i];
+		Job job;
+		std::string where = "job " + std::to_string(jobs.size() + 1) + ": ";
+		Json* input = member(entry,"input");
+		if(NULL == input || !input->isString() || input->toString().empty()) {
+			error = where + "no \"input\"";
+			return false;
+		}
+		job.input = input->toString();
+		Json* device = member(entry,"device");
+		job.device = job.selector;
+		if(NULL != device) {
+			if(device->isNumber()) {
+				job.selector = job.device = std::to_string((long long)device->toDouble());
+			} else
+			if(device->isString()) {
+				job.selector = device->toString();
+				job.device = "'" + device->toString() + "'";
+			} else
+			{
+				error = where + "\"device\" must be an index, name or product code";
+				return false;
+			}
+		}
+		Json* outdir = member(entry,"output-directory");
+		if(NULL != outdir && outdir->isString()) job.outdir = outdir->toString();
+		if(!job.outdir.empty() && job.outdir.back() != '/') job.outdir += '/';
+		Json* output = member(entry,"output");
+		if(NULL != output && output->isString()) job.output = output->toString();
+		if(job.output.empty())
+			job.output = std::string(basename(job.input.c_str())) + "_eeprom.bin";
+		if(!readFlags(member(entry,"flags"),job,error)) {
+			error = where + error;
+			return false;
+		}
+		jobs.push_back(job);
+	}
+	return true;
+}
+
+// Like mkdir -p
+bool makeDirectories(const std::string& dir) {
+	for(size_t slash = dir.find('/',1); ; slash = dir.find('/',slash + 1)) {
+		std::string path = dir.substr(0,slash);
+		struct stat st;
+		if(!path.empty() && stat(path.c_str(),&st) != 0 &&
+		mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 && errno != EEXIST)
+			return false;
+		if(slash == std::string::npos) return true;
+	}
+}
+
+void runJob(const std::vector<std::unique_ptr<ESIFile>>& files, Job& job, OutputSink* archive, const bool verbose) {
+	ScopedTimer timer("Manifest job",job.input);
+	ESIXML& esixml = *files[job.esi]->esixml;
+	DirectorySink dir(job.outdir);
+	PrefixSink prefixed(archive ? *archive : dir,job.outdir);
+	OutputSink& out = archive ? (OutputSink&)prefixed : (OutputSink&)dir;
+	if(NULL == archive && !job.outdir.empty() && !makeDirectories(job.outdir)) {
+		job.error = "could not create '" + job.outdir + "' (" + strerror(errno) + ")";
+		return;
+	}
+	if(!job.nosii) {
+		if(!SII::encodeEEPROMBinary(esixml.getVendorID(),job.dev,job.encodepdo,
+			job.input,job.outdir,job.output,verbose,&out,job.verifyroundtrip)) {
+			job.error = std::string(job.verifyroundtrip ? "could not encode, verify" : "could not encode") +
+				" or write '" + job.output + "'";
+			return;
+		}
+	}
+	if(job.dictionary && NULL != job.dev->profile &&
+	NULL != job.dev->profile->dictionary)
+	{
+		// Generate into memory so write failures can be told apart per job
+		MemorySink memory;
+		{
+			SOESConfigWriter sscwriter(job.outdir,job.little,&memory);
+			sscwriter.writeSSCFiles(job.dev,{ .capitalizeStructMembers = job.capitalizeStructMembers,
+				.appendObjectIndexToStructs = job.indexPostfixStructs });
+		}
+		for(const auto& f : memory.files()) {
+			if(!out.write(f.first,f.second)) {
+				job.error = "could not write '" + job.outdir + f.first + "'";
+				return;
+			}
+		}
+	}
+	job.written = dir.written().size();
+	job.unchanged = dir.unchanged().size();
+	job.ok = true;
+}
+
+};
+
+int Manifest::run(const std::string& file, const unsigned int threads, const int verbosity,
+	OutputSink* archive)
+{
+	const bool verbose = verbosity & 0x1;
+	const bool very_verbose = verbosity & 0x2;
+	auto start = std::chrono::steady_clock::now();
+	auto msSince = [](std::chrono::steady_clock::time_point t) {
+		return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now() - t).count();
+	};
+
+	std::vector<Job> jobs;
+	{
+		SII::MappedFile mapped;
+		if(!mapped.open(file)) return -1;
+		SII::ByteSpan span = mapped.span();
+		std::string error;
+		Json root = Json::parse(std::string((const char*)span.data(),span.size()),error);
+		if(!error.empty() || !readJobs(root,jobs,error)) {
+			printf("\033[0;31mERROR:\033[0m Manifest '%s': %s\n",file.c_str(),error.c_str());
+			return -1;
+		}
+	}
+
+	// Parse every distinct ESI file once
+	std::vector<std::unique_ptr<ESIFile>> files;
+	std::map<std::string,size_t> fileIndex;
+	for(Job& job : jobs) {
+		auto found = fileIndex.find(job.input);
+		if(found == fileIndex.end()) {
+			found = fileIndex.emplace(job.input,files.size()).first;
+			files.emplace_back(new ESIFile);
+			files.back()->file = job.input;
+			files.back()->esixml.reset(new ESIXML(verbosity));
+		}
+		job.esi = found->second;
+	}
+	parallelFor(files.size(),threads,[&files](size_t i) {
+		ScopedTimer timer("Manifest parse",files[i]->file);
+		files[i]->parsed = files[i]->esixml->parse(files[i]->file);
+	});
+	double parsems = msSince(start);
+
+	// Prepare each device used once, before the jobs share it read-only
+	for(Job& job : jobs) {
+		ESIFile& esi = *files[job.esi];
+		if(!esi.parsed) {
+			job.error = "could not parse '" + job.input + "'";
+			continue;
+		}
+		job.dev = esi.esixml->findDevice(job.selector);
+		if(NULL == job.dev) {
+			job.error = "no device " + job.device + " in '" + job.input + "'";
+			continue;
+		}
+		if(job.dictionary) esi.prepared[job.dev] = true;
+		else esi.prepared.emplace(job.dev,false);
+	}
+	for(std::unique_ptr<ESIFile>& esi : files) {
+		for(auto& prepared : esi->prepared) {
+			Device* dev = prepared.first;
+			if(prepared.second && dev->mailbox && dev->mailbox->coe_sdoinfo)
+				ObjectDictionary::synthesize(dev,esi->strings,verbose);
+			ObjectDictionary::validateBitsizes(dev,verbose);
+			ObjectDictionary::sortObjects(dev);
+		}
+	}
+
+	parallelFor(jobs.size(),threads,[&files,&jobs,&msSince,archive,very_verbose](size_t i) {
+		Job& job = jobs[i];
+		if(NULL == job.dev) return;
+		auto jobstart = std::chrono::steady_clock::now();
+		runJob(files,job,archive,very_verbose);
+		job.ms = msSince(jobstart);
+	});
+
+	int failed = 0;
+	printf("\nManifest '%s': %zu job(s), %zu ESI file(s) parsed in %.1f ms\n",
+		file.c_str(),jobs.size(),files.size(),parsems);
+	for(size_t i = 0; i < jobs.size(); ++i) {
+		const Job& job = jobs[i];
+		if(job.ok) {
+			printf("\t\033[0;32m[ OK ]\033[0m %zu: '%s' device %s -> '%s' (%.1f ms",
+				i + 1,job.input.c_str(),job.device.c_str(),job.outdir.empty() ? "." : job.outdir.c_str(),job.ms);
+			if(NULL == archive) printf(", %zu written, %zu unchanged",job.written,job.unchanged);
+			printf(")\n");
+		} else {
+			++failed;
+			printf("\t\033[0;31m[FAIL]\033[0m %zu: '%s' device %s: %s\n",
+				i + 1,job.input.c_str(),job.device.c_str(),job.error.c_str());
+		}
+	}
+	printf("%zu job(s) succeeded, %d failed, %.1f ms in total\n",jobs.size() - failed,failed,msSince(start));
+	return failed;
+}
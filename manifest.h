@@ -0,0 +1,30 @@
+#ifndef MANIFEST_H
+#define MANIFEST_H
+#include <string>
+
+class OutputSink;
+
+/**
+ * Batch mode (--manifest): many encode jobs in one process. The manifest
+ * is a JSON document like
+ *
+ *	{ "jobs": [
+ *		{ "input": "dev.xml", "device": 0, "output-directory": "out/dev",
+ *		  "output": "dev.bin", "flags": [ "-ep", "-d", "-csm" ] },
+ *		...
+ *	] }
+ *
+ * where device is an index into the devices of the ESI file, a device name
+ * or a product code ("#x..." or "0x...", default the first device) and
+ * flags are the command line options -ep, -d, -n, -csm, -ips, -le, -be and
+ * --verify-roundtrip. Every distinct ESI file is parsed once, the jobs then
+ * run on a thread pool.
+ */
+namespace Manifest {
+	// Returns the number of failed jobs, or -1 if the manifest is unusable.
+	// With an archive the outputs go there, under the jobs' directories
+	int run(const std::string& file, const unsigned int jobs = 0, const int verbosity = 0,
+		OutputSink* archive = NULL);
+};
+
+#endif /* MANIFEST_H */
@@ -0,0 +1,398 @@
+#include "objectdictionary.h"
+#include <cstring>
+#include "esctoolhelpers.h"
+#include "utilfunc.h"
+#include "runstats.h"
+
+void ObjectDictionary::synthesize(Device* dev, std::vector<char*>& strings, const bool verbose) {
+	size_t objectcount = 0;
+	size_t datatypecount = 0;
+	if(dev->profile && dev->profile->dictionary) {
+		objectcount = dev->profile->dictionary->objects.size();
+		datatypecount = dev->profile->dictionary->datatypes.size();
+	}
+
+	printf("Verifying and/or creating minimal object dictionary...\n");
+
+	if(!dev->profile) dev->profile = new Profile;
+	if(!dev->profile->dictionary) {
+		printf("\033[0;31mWARNING:\033[0m Creating empty dictionary\n");
+		dev->profile->dictionary = new Dictionary;
+	}
+
+	Dictionary* dict = dev->profile->dictionary;
+	auto findDT = [&dict](const char* dtname, uint32_t bitsize) {
+		for(DataType* d : dict->datatypes)
+			if(0 == strcmp(d->name,dtname)) return d;
+		printf("Creating DataType '%s' (%d bits)\n",dtname,bitsize);
+		dict->datatypes.push_back(new DataType {
+			.name = dtname,
+			.bitsize = bitsize
+		});
+		return dict->datatypes.back();
+	};
+
+	DataType* DT_UDINT = findDT(UDINTstr,32);
+	DataType* DT_UINT = findDT(UINTstr,16);
+	DataType* DT_USINT = findDT(USINTstr,8);
+	DataType* DT_DINT = findDT(DINTstr,32);
+	DataType* DT_INT = findDT(INTstr,16);
+	DataType* DT_SINT = findDT(SINTstr,8);
+	DataType* DT_ULINT = findDT(ULINTstr,64);
+	
+	size_t L = 32;
+	char s[L];
+
+	auto createStr = [&s,&strings]() {
+		char* newStr = new char[strlen(s)+1];
+		strcpy(newStr,s);
+		strings.push_back(newStr);
+		return newStr;
+	};
+
+	auto hasObject = [&dict](uint16_t index) {
+		for(Object* o : dict->objects) {
+			if(o->index == index) return o;
+		}
+		return (Object*)NULL;
+	};
+
+	if(!hasObject(0x1000)) {
+		if(dev->profile->channelinfo && dev->profile->channelinfo->profileNo) {
+			snprintf(s,L,"%.08u",dev->profile->channelinfo->profileNo);
+		} else {
+			snprintf(s,L,"%s","00001389"); // Hex representation of 5001
+		}
+
+		dict->objects.push_back(new Object {
+			.index = 0x1000,
+			.name = devTypeStr,
+			.datatype = DT_UDINT,
+			.defaultdata = createStr()
+		});
+	}
+
+	if(!hasObject(0x1008)) {
+		snprintf(s,L,"STRING(%lu)",strlen(dev->name));
+
+		dict->objects.push_back(new Object {
+			.index = 0x1008,
+			.name = devNameStr,
+			.type = createStr(),
+			.defaultstring = dev->name
+		});
+	}
+
+	// RX/TXPDO mapping
+	for(auto pdoList : { dev->rxpdo, dev->txpdo }) {
+		int pdoDefNo = 0;
+		for(Pdo* pdo : pdoList) {
+			Object* pdo_obj = new Object;
+			pdo_obj->index = pdo->index;
+			if(pdo->index >= 0x1600 && pdo->index < 0x1A00) {
+				snprintf(s,L,"RXPDO %.02d",pdoDefNo++);
+			} else {
+				snprintf(s,L,"TXPDO %.02d",pdoDefNo++);
+			}
+			pdo_obj->name = createStr();
+			uint32_t rxsize_bytes = 0;
+
+			DataType* dt = NULL;
+			snprintf(s,L,"DT%.04X",pdo->index);
+
+			for(DataType* d : dict->datatypes) {
+				if(0 == strcmp(d->name,s)) {
+					if(verbose) printf("Found datatype '%s' in dictionary!\n",s);
+					dt = d;
+					break;
+				}
+			}
+			if(dt != NULL) continue;
+			printf("Generating datatype '%s'\n",s);
+
+			dt = new DataType;
+			dt->name = createStr();
+			printf("%s\n",dt->name);
+			pdo_obj->datatype = dt;
+
+			if(pdo->entries.size() > 0) {
+				Object* numberOfEntries_obj = new Object;
+				numberOfEntries_obj->name = numberOfEntriesStr;
+				// Create the DataType subitem for the first subindex (USINT)
+				DataType* sdt = new DataType;
+				sdt->name = subIndex000Str;
+				sdt->type = DT_USINT->name;
+				sdt->bitsize = DT_USINT->bitsize;
+				sdt->bitoffset = 0;
+				sdt->subindex = 0;
+				dt->subitems.push_back(sdt);
+				numberOfEntries_obj->index = pdo->index;
+				numberOfEntries_obj->datatype = sdt;
+				numberOfEntries_obj->bitsize = sdt->bitsize;
+				dt->bitsize += numberOfEntries_obj->datatype->bitsize;
+				dt->bitsize += numberOfEntries_obj->datatype->bitsize; // FIXME this is padding (set to 16 instead?)
+
+				snprintf(s,L,"%.02X",(uint32_t)(pdo->entries.size() & 0xFF));
+				char* numberOfEntriesVal = createStr();
+				numberOfEntries_obj->defaultdata = numberOfEntriesVal;
+				pdo_obj->subitems.push_back(numberOfEntries_obj);
+
+				for(PdoEntry* e : pdo->entries) {
+					// Create the DataType subitem for current subindex
+					sdt = new DataType;
+					Object* pdoEntry_obj = new Object;
+					snprintf(s,L,"SubIndex %.03d",e->subindex);
+					char* entryName = createStr();
+					sdt->name = entryName;
+					sdt->subindex = e->subindex;
+					sdt->type = e->datatype;
+					// Set the offset of the "new" datatype subitem
+					sdt->bitoffset = dt->bitsize;
+					sdt->bitsize = e->bitlen;
+					// Increase the bitsize
+					dt->bitsize += e->bitlen;
+					// TODO Flags etc.
+					pdoEntry_obj->index = pdo->index;
+					pdoEntry_obj->name = entryName;
+					pdoEntry_obj->datatype = DT_UDINT;
+
+					snprintf(s,L,"%.04X%.02X%.02X",e->index,e->subindex,e->bitlen);
+					char* defaultData = createStr();
+					pdoEntry_obj->defaultdata = defaultData;
+
+					pdo_obj->subitems.push_back(pdoEntry_obj);
+					dt->subitems.push_back(sdt);
+				}
+			}
+			dict->datatypes.push_back(dt);
+			dict->objects.push_back(pdo_obj);
+		}
+	}
+
+	auto createArrayDT = [&dict,&createStr,L,&s,&DT_USINT,verbose](uint16_t index, const int entries, DataType* entryDT) {
+		snprintf(s,L,"DT%.04XARR",index);
+		for(DataType* d : dict->datatypes) {
+			if(0 == strcmp(d->name,s)) {
+				if(verbose) printf("Found datatype '%s' in dictionary!\n",s);
+				return d;
+			}
+		}
+		printf("Generating datatype '%s'\n",s);
+		DataType* dtARR = new DataType;
+		dtARR->name = createStr();
+		dtARR->basetype = entryDT->name;
+		dtARR->bitsize = entries*(entryDT->bitsize);
+		dtARR->arrayinfo = new ArrayInfo;
+		dtARR->arrayinfo->elements = entries;
+		dtARR->arrayinfo->lowerbound = 1;
+		dict->datatypes.push_back(dtARR);
+		DataType* dt = new DataType;
+		snprintf(s,L,"DT%.04X",index);
+		dt->name = createStr();
+		dt->bitsize = dtARR->bitsize+DT_USINT->bitsize+8;
+		dt->subitems.push_back(
+			new DataType {
+				.name = subIndex000Str,
+				.type = DT_USINT->name,
+				.bitsize = DT_USINT->bitsize,
+				.subindex = 0 });
+		dt->subitems.push_back(
+			new DataType {
+				.name = "Elements",
+				.type = dtARR->name,
+				.bitsize = dtARR->bitsize,
+				.bitoffset = DT_USINT->bitsize+8 });
+		dt->arrayinfo = dtARR->arrayinfo;
+		dict->datatypes.push_back(dt);
+		return dt;
+	};
+
+	if(!hasObject(0x1C00)) {
+		// SyncManager types 0x1C00
+		DataType* DT1C00 = createArrayDT(0x1C00,dev->syncmanagers.size(),DT_USINT);
+
+		Object* x1C00 = new Object;
+		x1C00->index = 0x1C00;
+		x1C00->datatype = DT1C00;
+		x1C00->bitsize = DT1C00->bitsize;
+		x1C00->name = devSMTypeStr;
+
+		snprintf(s,L,"%.02lu",dev->syncmanagers.size());
+
+		x1C00->subitems.push_back(new Object {
+				.index = x1C00->index,
+				.name = subIndex000Str,
+				.datatype = DT_USINT,
+				.defaultdata = createStr()});
+
+		uint8_t smno = 0;
+		for(SyncManager* sm : dev->syncmanagers) {
+			Object* sm_obj = new Object;
+			sm_obj->index = x1C00->index;
+			sm_obj->datatype = DT_USINT;
+			snprintf(s,L,"SM%d type",smno);
+			sm_obj->name = createStr();
+
+			if(0 == strcmp(sm->type,"MBoxOut")) {
+				snprintf(s,L,"%.02d",1);
+			} else if(0 == strcmp(sm->type,"MBoxIn")) {
+				snprintf(s,L,"%.02d",2);
+			} else if(0 == strcmp(sm->type,"Outputs")) {
+				snprintf(s,L,"%.02d",3);
+			} else if(0 == strcmp(sm->type,"Inputs")) {
+				snprintf(s,L,"%.02d",4);
+			}
+
+			sm_obj->defaultdata = createStr();
+			sm_obj->bitsize = DT_USINT->bitsize;
+			sm_obj->bitoffset = (smno * DT_USINT->bitsize);
+			++smno;
+			x1C00->subitems.push_back(sm_obj);
+		}
+		dict->objects.push_back(x1C00);
+	}
+
+	// SyncManager mappings 0x1C10-0x1C20
+	// Add PDOs to each sync manager mapping, and create each SM's respective
+	// objects
+	std::vector<std::list<Pdo*> > syncManagerMappings = {{},{},{},{}};
+
+	// TODO: If the device has slots, with predefined modules, with fixed
+	// PDOs, we should go through these and add them
+
+	// Go through the device PDOs
+	for(auto pdoList : { dev->rxpdo, dev->txpdo }) {
+		for(Pdo* pdo : pdoList)
+			syncManagerMappings[pdo->syncmanager].push_back(pdo);
+	}
+
+	uint8_t smno = 0;
+	for(auto pdoList : syncManagerMappings) {
+
+		if(hasObject(0x1C10 + smno)) continue;
+
+		Object* mappingObject = new Object;
+		mappingObject->index = 0x1C10 + smno;
+		DataType* DTmapping = createArrayDT(mappingObject->index,pdoList.size(),DT_UINT);
+		mappingObject->datatype = DTmapping;
+
+		snprintf(s,L,"SM%d mappings",smno);
+		mappingObject->name = createStr();
+		mappingObject->bitsize = 16; // size + padding
+
+		snprintf(s,L,"%.02lu",pdoList.size());
+
+		mappingObject->subitems.push_back(new Object {
+				.index = mappingObject->index,
+				.name = subIndex000Str,
+				.datatype = DT_USINT,
+				.defaultdata = createStr()});
+
+		// The user will have adjust the maxsubindex in the SSC code
+		// to deal with which modules are present and reflect
+		// this properly
+		if(dev->slots && (2 == smno || 3 == smno)) {
+			// TODO: here we should really check through the slots to check for fixed PDOs
+			ObjectFlags* flags = new ObjectFlags;
+			flags->access = new ObjectAccess;
+			snprintf(s,L,"%s","rw");
+			flags->access->access = createStr();
+			snprintf(s,L,"%s","PreOP");
+			flags->access->writerestrictions = createStr();
+			snprintf(s,L,"%s","Mapped object");
+			const char* name = createStr();
+
+			// We're now running with dynamic PDOs so the max subindex should be writeable
+			mappingObject->subitems.front()->flags = flags;
+
+			for(uint8_t j = 0; j < dev->slots->maxslotcount; ++j) {
+				Object* mappedObj = new Object;
+				mappedObj->index = mappingObject->index;
+				mappedObj->datatype = DT_UINT;
+				snprintf(s,L,"%.04X",0x0);
+				mappedObj->defaultdata = createStr();
+				mappedObj->name = name;
+				mappedObj->bitoffset = mappingObject->bitsize;
+				mappingObject->bitsize += DT_UINT->bitsize;
+				mappedObj->bitsize = DT_UINT->bitsize;
+				mappedObj->flags = flags;
+				mappingObject->subitems.push_back(mappedObj);
+			}
+		}
+
+		for(auto pdo : pdoList) {
+			Object* mappedObj = new Object;
+			mappedObj->index = mappingObject->index;
+			mappedObj->datatype = DT_UINT;
+			snprintf(s,L,"%.02X",pdo->index);
+			mappedObj->defaultdata = createStr();
+			mappedObj->name = pdo->name != NULL ? pdo->name : "Mapped object";
+			mappedObj->bitoffset = mappingObject->bitsize;
+			mappingObject->bitsize += DT_UINT->bitsize;
+			mappedObj->bitsize = DT_UINT->bitsize;
+			mappingObject->subitems.push_back(mappedObj);
+		}
+
+		dict->objects.push_back(mappingObject);
+		++smno;
+	}
+
+	RunStats::instance().synthesizedObjects += dict->objects.size() - objectcount;
+	RunStats::instance().synthesizedDatatypes += dict->datatypes.size() - datatypecount;
+}
+
+void ObjectDictionary::validateBitsizes(Device* dev, const bool verbose) {
+	if(NULL == dev->profile || NULL == dev->profile->dictionary) return;
+
+	auto findDT = [dict=dev->profile->dictionary](const char* dtname) {
+		if(NULL == dtname) return (DataType*)NULL;
+		for(DataType* d : dict->datatypes)
+			if(0 == strcmp(d->name,dtname)) return d;
+		printf("findDT: Could not find datatype for '%s'\n",dtname);
+		return (DataType*)NULL;
+	};
+
+	for(DataType* datatype : dev->profile->dictionary->datatypes) {
+		if(!datatype->subitems.empty() || datatype->arrayinfo) {
+			uint32_t bitsize = 0;
+			if(datatype->arrayinfo && NULL != datatype->basetype) {
+				DataType* basedt = findDT(datatype->basetype);
+				if(NULL != basedt) {
+					bitsize = basedt->bitsize * datatype->arrayinfo->elements;
+				}
+			} else {
+				int siNo = 0;
+				for(DataType* dt : datatype->subitems) {
+					if(siNo == 0) {
+						bitsize += dt->bitsize;
+						bitsize += 8; // Padding/16 bit alignment
+					} else {
+						DataType* basedt = findDT(dt->type);
+						if(basedt && basedt->arrayinfo) {
+							DataType* basedt = findDT(dt->type);
+							if(NULL != basedt) {
+								bitsize += basedt->bitsize;
+							} else
+								printf("\033[0;31mWARNING:\033[0m DataType '%s' Could not find array basetype '%s'\n",datatype->name,dt->type);
+						} else
+							bitsize += dt->bitsize;
+					}
+					++siNo;
+				}
+			}
+			bitsize += bitsize%16; // 16 bit alignment
+			if(datatype->bitsize != bitsize) {
+				printf("\033[0;31mWARNING:\033[0m Bitsize of datatype '%s' seems off (calculated %d vs. parsed %d)\n",datatype->name,bitsize,datatype->bitsize);
+				if(verbose) printDataTypeVerbose(datatype);
+			}
+		}
+	}
+}
+
+void ObjectDictionary::sortObjects(Device* dev) {
+	if(NULL != dev->profile && NULL != dev->profile->dictionary) {
+		dev->profile->dictionary->objects.sort([](const Object* objA, const Object* objB) {
+			return objA->index < objB->index;
+		});
+	}
+}
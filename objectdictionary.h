@@ -0,0 +1,18 @@
+#ifndef OBJECTDICTIONARY_H
+#define OBJECTDICTIONARY_H
+#include <vector>
+#include "esctooldefs.h"
+
+/** CoE object dictionary handling between parsing and writing a device */
+namespace ObjectDictionary {
+	// Adds what the SOES writer needs but the ESI did not define: 0x1000,
+	// 0x1008, the PDO mapping objects, 0x1C00 and 0x1C10-0x1C13. Strings
+	// made up for it are allocated with new[] and appended to strings.
+	void synthesize(Device* dev, std::vector<char*>& strings, const bool verbose = false);
+	// Warns about constructed datatypes whose bitsize does not add up
+	void validateBitsizes(Device* dev, const bool verbose = false);
+	// Objects in index order, as the writers expect them
+	void sortObjects(Device* dev);
+};
+
+#endif /* OBJECTDICTIONARY_H */
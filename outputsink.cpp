@@ -0,0 +1,223 @@
+#include "outputsink.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Archive data is written in chunks of about this size
+#define TAR_FLUSH_SIZE		(1024*1024)
+#define TAR_BLOCK_SIZE		512
+
+// Whether file exists with exactly data as content
+static bool sameContent(const std::string& file, const std::string& data) {
+	struct stat st;
+	if(stat(file.c_str(),&st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size != data.size()) return false;
+	FILE* f = fopen(file.c_str(),"rb");
+	if(NULL == f) return false;
+	char buf[65536];
+	size_t offset = 0;
+	bool same = true;
+	while(same) {
+		size_t n = fread(buf,1,sizeof(buf),f);
+		if(0 == n) break;
+		same = offset + n <= data.size() && 0 == memcmp(buf,data.data() + offset,n);
+		offset += n;
+	}
+	fclose(f);
+	return same && offset == data.size();
+}
+
+bool DirectorySink::write(const std::string& name, const std::string& data) {
+	std::string path = m_dir + name;
+	if(sameContent(path,data)) {
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_unchanged.push_back(name);
+		return true;
+	}
+
+	// New files get the usual permissions, replaced files keep theirs
+	static const mode_t umaskbits = []() { mode_t m = umask(0); umask(m); return m; }();
+	mode_t mode = 0666 & ~umaskbits;
+	struct stat st;
+	if(stat(path.c_str(),&st) == 0) mode = st.st_mode & 07777;
+
+	std::string tmp = path + ".XXXXXX";
+	int fd = mkstemp(&tmp[0]);
+	FILE* f = fd < 0 ? NULL : fdopen(fd,"wb");
+	if(NULL == f) {
+		if(fd >= 0) close(fd);
+		printf("Couldn't open '%s' for writing\n",path.c_str());
+		return false;
+	}
+	fchmod(fd,mode);
+	bool ok = fwrite(data.data(),1,data.size(),f) == data.size();
+	if(0 != fclose(f)) ok = false;
+	if(ok && 0 != rename(tmp.c_str(),path.c_str())) ok = false;
+	if(!ok) {
+		unlink(tmp.c_str());
+		printf("Failed writing '%s'\n",path.c_str());
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_written.push_back(name);
+	return true;
+}
+
+std::vector<std::string> DirectorySink::written(void) const {
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_written;
+}
+
+std::vector<std::string> DirectorySink::unchanged(void) const {
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_unchanged;
+}
+
+void DirectorySink::printSummary(const bool verbose) const {
+	std::lock_guard<std::mutex> lock(m_lock);
+	printf("Wrote %lu file(s), %lu unchanged\n",m_written.size(),m_unchanged.size());
+	if(!verbose) return;
+	for(const std::string& name : m_written) printf("\t\033[0;32mwritten\033[0m   %s%s\n",m_dir.c_str(),name.c_str());
+	for(const std::string& name : m_unchanged) printf("\tunchanged %s%s\n",m_dir.c_str(),name.c_str());
+}
+
+bool MemorySink::write(const std::string& name, const std::string& data) {
+	m_files[name] = data;
+	return true;
+}
+
+TarSink::TarSink(const std::string& file) :
+	m_name(file),
+	m_file(fopen(file.c_str(),"wb")),
+	m_failed(false)
+{
+	init();
+}
+
+TarSink::TarSink(FILE* f, const std::string& name) :
+	m_name(name),
+	m_file(f),
+	m_failed(false)
+{
+	init();
+}
+
+void TarSink::init(void) {
+	if(NULL == m_file) {
+		printf("Couldn't open '%s' for writing\n",m_name.c_str());
+		m_failed = true;
+	}
+	// Reproducible archives when the build asks for it
+	const char* epoch = getenv("SOURCE_DATE_EPOCH");
+	m_mtime = NULL != epoch ? (time_t)strtoll(epoch,NULL,10) : time(NULL);
+	m_buf.reserve(TAR_FLUSH_SIZE + TAR_BLOCK_SIZE);
+}
+
+bool TarSink::flush(void) {
+	if(!m_buf.empty() && fwrite(m_buf.data(),1,m_buf.size(),m_file) != m_buf.size()) {
+		if(!m_failed) printf("Failed writing '%s'\n",m_name.c_str());
+		m_failed = true;
+	}
+	m_buf.clear();
+	return !m_failed;
+}
+
+bool TarSink::write(const std::string& name, const std::string& data) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	if(NULL == m_file) return false;
+
+	// ustar header, names longer than 100 characters are split at a '/'
+	// into prefix and name
+	char hdr[TAR_BLOCK_SIZE] = { 0 };
+	std::string path = name;
+	while(!path.empty() && path[0] == '/') path.erase(0,1);
+	std::string prefix;
+	if(path.size() > 100) {
+		size_t slash = path.find('/',path.size() - 101);
+		if(slash == std::string::npos || slash > 155) {
+			printf("Name '%s' is too long for a tar archive\n",path.c_str());
+			return false;
+		}
+		prefix = path.substr(0,slash);
+		path = path.substr(slash + 1);
+	}
+	memcpy(&hdr[0],path.data(),path.size());
+	snprintf(&hdr[100],8,"%07o",0644);
+	snprintf(&hdr[108],8,"%07o",0);
+	snprintf(&hdr[116],8,"%07o",0);
+	snprintf(&hdr[124],12,"%011llo",(unsigned long long)data.size());
+	snprintf(&hdr[136],12,"%011llo",(unsigned long long)m_mtime);
+	hdr[156] = '0';
+	memcpy(&hdr[257],"ustar",6);
+	memcpy(&hdr[263],"00",2);
+	memcpy(&hdr[345],prefix.data(),prefix.size());
+	memset(&hdr[148],' ',8);
+	unsigned int sum = 0;
+	for(unsigned char c : hdr) sum += c;
+	snprintf(&hdr[148],8,"%06o",sum);
+
+	m_buf.append(hdr,TAR_BLOCK_SIZE);
+	m_buf.append(data);
+	m_buf.append((TAR_BLOCK_SIZE - data.size() % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE,'\0');
+	if(m_buf.size() >= TAR_FLUSH_SIZE) return flush();
+	return !m_failed;
+}
+
+bool TarSink::close(void) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	if(NULL == m_file) return !m_failed;
+	// End of archive
+	m_buf.append(2*TAR_BLOCK_SIZE,'\0');
+	flush();
+	if(0 != fclose(m_file) && !m_failed) {
+		printf("Failed writing '%s'\n",m_name.c_str());
+		m_failed = true;
+	}
+	m_file = NULL;
+	return !m_failed;
+}
+
+bool StreamSink::write(const std::string& name, const std::string& data) {
+	if(NULL == m_file) {
+		printf("Couldn't open '%s' for writing\n",m_name.c_str());
+		m_failed = true;
+		return false;
+	}
+	if(fwrite(data.data(),1,data.size(),m_file) != data.size() || 0 != fflush(m_file)) {
+		printf("Failed writing '%s' to '%s'\n",name.c_str(),m_name.c_str());
+		m_failed = true;
+	}
+	return !m_failed;
+}
+
+bool StreamSink::close(void) {
+	if(NULL != m_file && 0 != fclose(m_file)) {
+		printf("Failed writing '%s'\n",m_name.c_str());
+		m_failed = true;
+	}
+	m_file = NULL;
+	return !m_failed;
+}
+
+bool ChangedOnlySink::write(const std::string& name, const std::string& data) {
+	auto last = m_last.find(name);
+	if(last != m_last.end() && last->second == data) {
+		++m_unchanged;
+		return true;
+	}
+	if(!m_target.write(name,data)) {
+		m_last.erase(name);
+		return false;
+	}
+	m_last[name] = data;
+	++m_changed;
+	return true;
+}
+
+FILE* claimStdout(void) {
+	fflush(stdout);
+	int fd = dup(STDOUT_FILENO);
+	if(fd < 0 || dup2(STDERR_FILENO,STDOUT_FILENO) < 0) return NULL;
+	return fdopen(fd,"wb");
+}
@@ -0,0 +1,141 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Where the generated files end up. Writers produce each file completely
+ * in memory and hand it over in one piece, so a sink never sees a
+ * half-written file.
+ */
+class OutputSink {
+public:
+	virtual ~OutputSink() {};
+	// Store data as file name, prints why and returns false on failure
+	virtual bool write(const std::string& name, const std::string& data) = 0;
+protected:
+	OutputSink() {};
+};
+
+/**
+ * Files in a directory, name is appended to the directory as given. A file
+ * already holding the same content is left alone (keeping its mtime, so
+ * builds depending on it do not rerun), others are replaced atomically
+ * through a temporary file and rename.
+ */
+class DirectorySink : public OutputSink {
+public:
+	DirectorySink(const std::string& dir = "") : m_dir(dir) {};
+	bool write(const std::string& name, const std::string& data) override;
+	// Names as given to write(), in order
+	std::vector<std::string> written(void) const;
+	std::vector<std::string> unchanged(void) const;
+	// "Wrote 2 file(s), 3 unchanged", verbose lists the files
+	void printSummary(const bool verbose = false) const;
+private:
+	std::string m_dir;
+	mutable std::mutex m_lock;
+	std::vector<std::string> m_written;
+	std::vector<std::string> m_unchanged;
+};
+
+/** Keeps the files, for in-process users and benchmarks */
+class MemorySink : public OutputSink {
+public:
+	bool write(const std::string& name, const std::string& data) override;
+	const std::map<std::string,std::string>& files(void) const { return m_files; };
+	void clear(void) { m_files.clear(); };
+private:
+	std::map<std::string,std::string> m_files;
+};
+
+/**
+ * A ustar archive streamed to a file or an already open stream (see
+ * claimStdout()). Files are collected in a large buffer and written
+ * sequentially, so a run with many small outputs costs a few big writes
+ * instead of an open/close per file. Safe to share between threads.
+ */
+class TarSink : public OutputSink {
+public:
+	TarSink(const std::string& file);
+	// Takes over f, name is only used in messages
+	TarSink(FILE* f, const std::string& name);
+	~TarSink() { close(); };
+	TarSink(const TarSink&) = delete;
+	TarSink& operator=(const TarSink&) = delete;
+
+	// False (after printing why) if the archive could not be created or written
+	bool ok(void) const { return !m_failed; };
+	bool write(const std::string& name, const std::string& data) override;
+	// Ends the archive, returns false if any write failed
+	bool close(void);
+private:
+	void init(void);
+	bool flush(void);
+
+	std::string m_name;
+	FILE* m_file;
+	std::string m_buf;
+	std::mutex m_lock;
+	bool m_failed;
+	time_t m_mtime;
+};
+
+/** Writes the data of every file to an open stream, eg. an SII image to stdout */
+class StreamSink : public OutputSink {
+public:
+	// Takes over f, name is only used in messages
+	StreamSink(FILE* f, const std::string& name) : m_file(f), m_name(name), m_failed(false) {};
+	~StreamSink() { close(); };
+	StreamSink(const StreamSink&) = delete;
+	StreamSink& operator=(const StreamSink&) = delete;
+	bool write(const std::string& name, const std::string& data) override;
+	// Returns false if any write failed
+	bool close(void);
+private:
+	FILE* m_file;
+	std::string m_name;
+	bool m_failed;
+};
+
+/** Puts a directory in front of every name, eg. per job in an archive */
+class PrefixSink : public OutputSink {
+public:
+	PrefixSink(OutputSink& target, const std::string& prefix) : m_target(target), m_prefix(prefix) {};
+	bool write(const std::string& name, const std::string& data) override {
+		return m_target.write(m_prefix + name,data);
+	};
+private:
+	OutputSink& m_target;
+	std::string m_prefix;
+};
+
+/**
+ * Passes a file on to another sink only when it differs from what was last
+ * written through this sink under the same name, for regenerating the
+ * same outputs over and over (--watch)
+ */
+class ChangedOnlySink : public OutputSink {
+public:
+	ChangedOnlySink(OutputSink& target) : m_target(target), m_changed(0), m_unchanged(0) {};
+	bool write(const std::string& name, const std::string& data) override;
+	unsigned int changed(void) const { return m_changed; };
+	unsigned int unchanged(void) const { return m_unchanged; };
+	void resetCounts(void) { m_changed = m_unchanged = 0; };
+private:
+	OutputSink& m_target;
+	std::map<std::string,std::string> m_last;
+	unsigned int m_changed;
+	unsigned int m_unchanged;
+};
+
+// Returns a stream on the real stdout for binary output and points stdout
+// at stderr, so no message can end up in the middle of the data. Call it
+// before printing anything
+FILE* claimStdout(void);
+
+#endif /* OUTPUTSINK_H */
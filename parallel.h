@@ -0,0 +1,35 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+/**
+ * Calls fn(i) for every i in [0,count) on up to jobs threads (0: one per
+ * core). Indices are handed out one at a time, so uneven work balances
+ * itself; fn must only touch state belonging to its index.
+ */
+template<typename F>
+void parallelFor(size_t count, unsigned int jobs, F fn)
+{
+	if(0 == jobs) jobs = std::thread::hardware_concurrency();
+	if(0 == jobs) jobs = 1;
+	if(jobs > count) jobs = count;
+
+	std::atomic<size_t> next(0);
+	auto worker = [&next,count,&fn]() {
+		for(size_t i = next++; i < count; i = next++) fn(i);
+	};
+
+	if(jobs <= 1) {
+		worker();
+		return;
+	}
+	std::vector<std::thread> threads;
+	for(unsigned int t = 1; t < jobs; ++t) threads.emplace_back(worker);
+	worker();
+	for(std::thread& t : threads) t.join();
+}
+
+#endif /* PARALLEL_H */
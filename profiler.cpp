@@ -0,0 +1,141 @@
+#include "profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <algorithm>
+#include "jsonwriter.h"
+
+// Small, stable per thread number for the trace lanes (main thread is 0
+// as long as it records first)
+static unsigned int currentLane(void) {
+	static std::atomic<unsigned int> next(0);
+	thread_local unsigned int lane = next++;
+	return lane;
+}
+
+static uint64_t monotonicUs(void) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler& Profiler::instance(void) {
+	static Profiler profiler;
+	return profiler;
+}
+
+void Profiler::enable(const bool on) {
+	if(on && !m_enabled) {
+		m_epoch = monotonicUs();
+		currentLane();
+	}
+	m_enabled = on;
+}
+
+uint64_t Profiler::now(void) const {
+	return monotonicUs() - m_epoch;
+}
+
+void Profiler::record(const char* name, std::string&& detail, uint64_t start, uint64_t end) {
+	unsigned int lane = currentLane();
+	std::lock_guard<std::mutex> guard(m_lock);
+	if(m_events.size() >= MAX_EVENTS) {
+		++m_dropped;
+		return;
+	}
+	m_events.push_back({ name, std::move(detail), start, end, lane });
+}
+
+void Profiler::clear(void) {
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_events.clear();
+	m_events.shrink_to_fit();
+	m_dropped = 0;
+}
+
+void Profiler::printSummary(FILE* f) const {
+	struct Phase {
+		const char* name;
+		unsigned long count = 0;
+		uint64_t total = 0;
+		uint64_t min = UINT64_MAX;
+		uint64_t max = 0;
+	};
+	std::map<std::string,Phase> phases;
+	unsigned long dropped = 0;
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		dropped = m_dropped;
+		for(const Event& e : m_events) {
+			Phase& p = phases[e.name];
+			uint64_t d = e.end - e.start;
+			p.name = e.name;
+			++p.count;
+			p.total += d;
+			p.min = std::min(p.min,d);
+			p.max = std::max(p.max,d);
+		}
+	}
+	std::vector<Phase> sorted;
+	for(const auto& p : phases) sorted.push_back(p.second);
+	std::sort(sorted.begin(),sorted.end(),[](const Phase& a, const Phase& b) { return a.total > b.total; });
+
+	fprintf(f,"%-32s %8s %12s %12s %12s\n","Phase","Count","Total [ms]","Min [ms]","Max [ms]");
+	for(const Phase& p : sorted) {
+		fprintf(f,"%-32s %8lu %12.3f %12.3f %12.3f\n",p.name,p.count,
+			p.total/1000.0,p.min/1000.0,p.max/1000.0);
+	}
+	if(dropped) fprintf(f,"%lu later event(s) not recorded, the limit is %zu\n",dropped,MAX_EVENTS);
+}
+
+bool Profiler::writeTrace(const std::string& file) const {
+	FILE* f = fopen(file.c_str(),"w");
+	if(NULL == f) {
+		printf("Could not open '%s' for writing the trace\n",file.c_str());
+		return false;
+	}
+
+	JSONWriter json(false);
+	json.beginObject();
+	json.beginArray("traceEvents");
+	unsigned int lanes = 0;
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		for(const Event& e : m_events) {
+			json.beginObject();
+			json.value("name",e.name);
+			json.value("cat","esctool");
+			json.value("ph","X");
+			json.value("ts",(unsigned long long)e.start);
+			json.value("dur",(unsigned long long)(e.end - e.start));
+			json.value("pid",1);
+			json.value("tid",e.lane);
+			if(!e.detail.empty()) {
+				json.beginObject("args");
+				json.value("detail",e.detail);
+				json.endObject();
+			}
+			json.endObject();
+			lanes = std::max(lanes,e.lane + 1);
+		}
+	}
+	for(unsigned int lane = 0; lane < lanes; ++lane) {
+		std::string name = lane ? "worker " + std::to_string(lane) : "main";
+		json.beginObject();
+		json.value("name","thread_name");
+		json.value("ph","M");
+		json.value("pid",1);
+		json.value("tid",lane);
+		json.beginObject("args");
+		json.value("name",name);
+		json.endObject();
+		json.endObject();
+	}
+	json.endArray();
+	json.value("displayTimeUnit","ms");
+	json.endObject();
+	json.write(f);
+	bool ok = 0 == ferror(f);
+	fclose(f);
+	return ok;
+}
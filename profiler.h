@@ -0,0 +1,90 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Collects timed phases of a run (only when enabled, otherwise a timer
+ * costs a flag check). Phases can be summarized as a table or written as
+ * a Chrome trace_event file (chrome://tracing, Perfetto), where every
+ * thread that recorded something gets its own lane. At most MAX_EVENTS
+ * are kept, later ones are only counted, so long running modes can not
+ * grow it without bounds.
+ */
+class Profiler {
+public:
+	static Profiler& instance(void);
+
+	void enable(const bool on = true);
+	bool enabled(void) const { return m_enabled; };
+
+	static const size_t MAX_EVENTS = 1 << 18;
+
+	// Microseconds since the profiler was enabled
+	uint64_t now(void) const;
+	void record(const char* name, std::string&& detail, uint64_t start, uint64_t end);
+	// Forget the events recorded so far
+	void clear(void);
+
+	// Total, count, min and max per phase name, longest first
+	void printSummary(FILE* f) const;
+	bool writeTrace(const std::string& file) const;
+private:
+	Profiler() : m_enabled(false), m_epoch(0), m_dropped(0) {};
+
+	struct Event {
+		const char* name;
+		std::string detail;
+		uint64_t start;
+		uint64_t end;
+		unsigned int lane;
+	};
+
+	bool m_enabled;
+	uint64_t m_epoch;
+	mutable std::mutex m_lock;
+	std::vector<Event> m_events;
+	unsigned long m_dropped;
+};
+
+/**
+ * Records the time from construction to stop() or destruction. The detail
+ * is only copied when the profiler is enabled.
+ */
+class ScopedTimer {
+public:
+	ScopedTimer(const char* name, const char* detail = NULL) :
+		m_name(name), m_running(Profiler::instance().enabled())
+	{
+		if(!m_running) return;
+		if(detail) m_detail = detail;
+		m_start = Profiler::instance().now();
+	};
+	ScopedTimer(const char* name, const std::string& detail) :
+		m_name(name), m_running(Profiler::instance().enabled())
+	{
+		if(!m_running) return;
+		m_detail = detail;
+		m_start = Profiler::instance().now();
+	};
+	~ScopedTimer() { stop(); };
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	void stop(void) {
+		if(!m_running) return;
+		m_running = false;
+		Profiler::instance().record(m_name,std::move(m_detail),m_start,Profiler::instance().now());
+	};
+private:
+	const char* m_name;
+	std::string m_detail;
+	bool m_running;
+	uint64_t m_start = 0;
+};
+
+#endif /* PROFILER_H */
@@ -0,0 +1,43 @@
+#include "runstats.h"
+#include "jsonwriter.h"
+
+RunStats& RunStats::instance(void) {
+	static RunStats stats;
+	return stats;
+}
+
+void RunStats::write(JSONWriter& json) const {
+	json.beginObject();
+	json.beginObject("esi");
+	json.value("devices",devices.load());
+	json.value("elements",elements.load());
+	json.value("unhandledelements",unhandledElements.load());
+	json.value("unhandledattributes",unhandledAttributes.load());
+	json.value("objects",objects.load());
+	json.value("datatypes",datatypes.load());
+	json.value("pdos",pdos.load());
+	json.value("pdoentries",pdoEntries.load());
+	json.endObject();
+
+	json.beginObject("synthesized");
+	json.value("objects",synthesizedObjects.load());
+	json.value("datatypes",synthesizedDatatypes.load());
+	json.endObject();
+
+	json.beginObject("sii");
+	json.value("images",siiImages.load());
+	json.value("used",siiBytesUsed.load());
+	json.endObject();
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	json.beginArray("outputs");
+	for(const Output& o : outputs) {
+		json.beginObject();
+		json.value("file",o.file);
+		json.value("bytes",o.bytes);
+		if(o.siiUsed) json.value("siiused",o.siiUsed);
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+}
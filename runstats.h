@@ -0,0 +1,63 @@
+#ifndef RUNSTATS_H
+#define RUNSTATS_H
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class JSONWriter;
+
+/**
+ * Counters of a run, filled in by the ESI parser, the SII encoder and the
+ * SSC writers. Atomic increments, so they are always collected (also from
+ * the --manifest worker threads); --stats only decides whether they are
+ * written out.
+ */
+struct RunStats {
+	struct Output {
+		std::string file;
+		unsigned long bytes;
+		unsigned long siiUsed; // SII images: bytes up to the end marker
+	};
+
+	// ESI parsing
+	std::atomic<unsigned long> devices { 0 };
+	std::atomic<unsigned long> elements { 0 }; // In the document
+	std::atomic<unsigned long> unhandledElements { 0 };
+	std::atomic<unsigned long> unhandledAttributes { 0 };
+	std::atomic<unsigned long> objects { 0 }; // Including subitems
+	std::atomic<unsigned long> datatypes { 0 }; // Including subitems
+	std::atomic<unsigned long> pdos { 0 };
+	std::atomic<unsigned long> pdoEntries { 0 };
+
+	// Added by the dictionary synthesis
+	std::atomic<unsigned long> synthesizedObjects { 0 };
+	std::atomic<unsigned long> synthesizedDatatypes { 0 };
+
+	// SII encoding, summed up over all encoded images. The capacity is
+	// per image, the size of its entry in outputs
+	std::atomic<unsigned long> siiImages { 0 };
+	std::atomic<unsigned long> siiBytesUsed { 0 };
+
+	std::vector<Output> outputs;
+
+	static RunStats& instance(void);
+	void addSII(unsigned long used) {
+		++siiImages;
+		siiBytesUsed += used;
+	};
+	void addOutput(const std::string& file, unsigned long bytes, unsigned long siiused = 0) {
+		if(!m_recordOutputs) return;
+		std::lock_guard<std::mutex> lock(m_lock);
+		outputs.push_back({ file, bytes, siiused });
+	};
+	// Off in modes that never report, so the outputs can not pile up
+	void recordOutputs(const bool on) { m_recordOutputs = on; };
+	void write(JSONWriter& json) const;
+private:
+	mutable std::mutex m_lock;
+	std::atomic<bool> m_recordOutputs { true };
+};
+
+#endif /* RUNSTATS_H */
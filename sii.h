@@ -1,13 +1,61 @@
 #ifndef SII_H
 #define SII_H
+#include <cstdio>
 #include <string>
+#include <vector>
 #include "esctooldefs.h"
 
+class JSONWriter;
+class OutputSink;
+
 namespace SII {
-	void encodeEEPROMBinary(uint32_t vendor_id, Device* dev, bool encodepdo,
+	class Reader;
+	class ByteSpan;
+
+	struct DiffRange {
+		size_t offset;
+		size_t length;
+	};
+
+	// Encode into memory, returns false if the data does not fit the EEPROM.
+	// used gets the bytes up to and including the end marker
+	bool encodeEEPROM(uint32_t vendor_id, Device* dev, bool encodepdo,
+		std::vector<uint8_t>& eeprom, const bool verbose = false, size_t* used = NULL);
+	// Encode and write as output, to outputdir unless a sink is given.
+	// With verify the image is checked by verifyRoundtrip() before writing
+	bool encodeEEPROMBinary(uint32_t vendor_id, Device* dev, bool encodepdo,
 		const std::string& file, const std::string& outputdir,
-		const std::string& output, const bool verbose = false);
-	void decodeEEPROMBinary(const std::string& file, const bool verbose = false);
+		const std::string& output, const bool verbose = false, OutputSink* sink = NULL,
+		const bool verify = false);
+	// Decode an encoded image again and compare against the model
+	bool verifyRoundtrip(const std::vector<uint8_t>& eeprom, uint32_t vendor_id, const Device* dev,
+		bool encodepdo, const bool verbose = false);
+	void decodeEEPROMBinary(const std::string& file, const bool verbose = false, const bool json = false);
+	// Annotated hex dump of the whole image
+	void dumpEEPROM(const Reader& reader, FILE* f);
+	// Human readable print of an image
+	void printEEPROM(const Reader& reader, const bool verbose = false);
+	// Append the decoded image as members of the currently open JSON object
+	void writeEEPROMJSON(const Reader& reader, JSONWriter& json);
+	// Decode a file of concatenated images, either of recordsize bytes each
+	// or (recordsize 0) each prefixed by a 32 bit little endian byte length.
+	// Returns the number of invalid records
+	int decodeEEPROMStream(const std::string& file, const size_t recordsize,
+		const bool verbose = false, const bool json = false);
+	// Decode every image in dir on jobs threads (0: one per core) and print a
+	// fleet inventory as CSV or JSON, with a status entry per image that
+	// could not be read or has an invalid header. Returns the number of
+	// unreadable images and checksum failures
+	int decodeDirectory(const std::string& dir, const unsigned int jobs = 0,
+		const std::string& golden = "", const bool json = false, const bool verbose = false);
+	// Byte ranges where two images differ (vectorized compare)
+	std::vector<DiffRange> diffRanges(const ByteSpan& a, const ByteSpan& b);
+	// Print field level differences between two images, returns their count
+	int diffEEPROM(const ByteSpan& a, const ByteSpan& b, const bool verbose = false);
+	// Compare the image a against each of the others, returns number of differing images
+	int diffEEPROMBinary(const std::string& a, const std::vector<std::string>& others, const bool verbose = false);
+	// Check only the header and ConfigData checksum of a binary SII file
+	bool verifyEEPROMBinary(const std::string& file, const bool verbose = false);
 };
 
 #endif /* SII_H */
\ No newline at end of file
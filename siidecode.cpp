@@ -17,86 +17,163 @@
 #include <list>
 #include <vector>
 #include "esctoolhelpers.h"
+#include "siireader.h"
+#include "hexdump.h"
+#include "jsonwriter.h"
 
-void SII::decodeEEPROMBinary(const std::string& file, const bool verbose) {
+bool SII::verifyEEPROMBinary(const std::string& file, const bool verbose) {
 	int fd = open(file.c_str(), O_RDONLY);
 	if(fd < 0){
-		printf("Could not open '%s'\n",file.c_str());
-		return;
+		printf("%s: \033[0;31mFAIL\033[0m could not open\n",file.c_str());
+		return false;
 	}
-	printf("Decoding SII from '%s'\n",file.c_str());
-	struct stat statbuf;
-	int err = fstat(fd, &statbuf);
-	if(err < 0){
-		printf("Could not stat '%s'\n",file.c_str());
-		return;
+	// Only the header up to the first category is needed, so avoid
+	// mapping (or reading) the rest of the image
+	uint8_t hdr[EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE];
+	ssize_t n = read(fd, hdr, sizeof(hdr));
+	close(fd);
+	if(n != (ssize_t)sizeof(hdr)) {
+		printf("%s: \033[0;31mFAIL\033[0m truncated header (%ld bytes)\n",file.c_str(),(long)n);
+		return false;
+	}
+
+	HeaderView header(ByteSpan(hdr,sizeof(hdr)));
+	if(!header.checksumOK()) {
+		printf("%s: \033[0;31mFAIL\033[0m checksum 0x%.02X, calculated 0x%.02X\n",
+			file.c_str(),header.checksum(),header.calculatedChecksum());
+		return false;
+	}
+
+	// Unusual, but nothing in the spec makes a version 0 image invalid
+	if(0 == header.version()) {
+		printf("%s: \033[0;31mWARNING:\033[0m version is 0\n",file.c_str());
+	}
+
+	if(verbose) {
+		printf("%s: \033[0;32mOK\033[0m vendor 0x%.08X product 0x%.08X revision 0x%.08X\n",
+			file.c_str(),header.vendorId(),header.productCode(),header.revisionNo());
+	} else {
+		printf("%s: \033[0;32mOK\033[0m\n",file.c_str());
+	}
+	return true;
+}
+
+static const char* getFMMUTypeString(const uint8_t config) {
+	switch(config) {
+		case 0x0: return "Not used";
+		case 0x1: return "Used for Outputs";
+		case 0x2: return "Used for Inputs";
+		case 0x3: return "Used for SyncM (Read Mailbox)";
+		case 0xFF: return "Not used";
+	}
+	return "";
+}
+
+static const char* getSyncMTypeString(const uint8_t type) {
+	switch(type) {
+		default:
+		case 0x0: return "Unused/Unknown";
+		case 0x1: return "Mailbox Out";
+		case 0x2: return "Mailbox In";
+		case 0x3: return "Process data outputs";
+		case 0x4: return "Process data inputs";
+	}
+}
+
+static const char* getPhysicalPortString(const uint8_t port) {
+	switch(port) {
+		case 0x0: return "Not in use";
+		case 0x1: return "MII";
+		case 0x2: return "Reserved";
+		case 0x3: return "EBUS";
+		case 0x4: return "Fast Hot Connect";
 	}
+	return "";
+}
 
-	uint8_t *p = (uint8_t*) mmap(NULL, statbuf.st_size,
-		PROT_READ, MAP_PRIVATE, fd, 0);
-	uint8_t *ptr = p;
-	if(ptr == MAP_FAILED){
-		printf("Mapping Failed (%d)\n",errno);
+void SII::dumpEEPROM(const SII::Reader& reader, FILE* f) {
+	HexDump dump;
+	if(reader.valid()) {
+		dump.annotate(0,"ConfigData");
+		dump.annotate(EC_SII_CONFIGDATA_CHECKSUM_OFFSET_BYTE,"Checksum");
+		dump.annotate(EC_SII_EEPROM_VENDOR_OFFSET_BYTE,"Vendor");
+		dump.annotate(EC_SII_EEPROM_VENDOR_OFFSET_BYTE+4,"Product");
+		dump.annotate(EC_SII_EEPROM_VENDOR_OFFSET_BYTE+8,"Revision");
+		dump.annotate(EC_SII_EEPROM_VENDOR_OFFSET_BYTE+12,"Serial");
+		dump.annotate(EC_SII_EEPROM_MAILBOX_OUT_OFFSET_BYTE,"Mailbox Out");
+		dump.annotate(EC_SII_EEPROM_MAILBOX_IN_OFFSET_BYTE,"Mailbox In");
+		dump.annotate(EC_SII_EEPROM_MAILBOX_PROTO_OFFSET_BYTE,"Mailbox Protocol");
+		dump.annotate(EC_SII_EEPROM_SIZE_OFFSET_BYTE,"Size");
+		dump.annotate(EC_SII_EEPROM_VERSION_OFFSET_BYTE,"Version");
+	}
+	size_t end = EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE;
+	for(const Category& cat : reader) {
+		dump.annotate(cat.offset,std::string(getCategoryString(cat.type)) +
+			" (" + std::to_string(cat.sizeW) + " words)");
+		end = cat.offset + 4 + cat.payload.size();
+	}
+	if(0xFFFF == reader.image().u16(end)) dump.annotate(end,"End");
+	dump.write(f,reader.image().data(),reader.image().size());
+}
+
+void SII::printEEPROM(const SII::Reader& reader, const bool verbose) {
+	HeaderView hdr = reader.header();
+	if(!hdr.valid()) {
+		printf("Image is too small to hold a SII header (%zu bytes)\n",reader.image().size());
 		return;
 	}
 
+	ByteSpan configdata = hdr.configData();
 	printf("ConfigData: '\033[0;32m");
 	for(uint8_t i = 0; i < EC_SII_CONFIGDATA_SIZEB; ++i) {
-		printf("0x%.02X",*(ptr++));
+		printf("0x%.02X",configdata.u8(i));
 		if(i < EC_SII_CONFIGDATA_SIZEB-1) printf(" ");
-		// TODO verify checksum
 	}
 	printf("\033[0m' \033[0;36m[Esi:DeviceType:Eeprom:ConfigData]\033[0m\n");
-	printf("Vendor: \033[0;32m0x%.08X \033[0;36m[Esi:EtherCATInfo:Vendor]\033[0m\n",*(uint32_t*)ptr);
-	ptr += 4;
-	printf("Product: \033[0;32m0x%.08X \033[0;36m[Esi:DeviceType:Type:ProductCode]\033[0m\n",*(uint32_t*)ptr);
-	ptr += 4;
-	printf("Revision: \033[0;32m0x%.08X \033[0;36m[Esi:DeviceType:Type:RevisionNo]\033[0m\n",*(uint32_t*)ptr);
-	ptr += 4;
-
-	// TODO eepromsize and version
-	ptr = p + EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE-4;
-	printf("Size: \033[0;32m0x%.02X \033[0;36m[Esi:DeviceType:Eeprom:ByteSize]\033[0m\n",*(uint16_t*)ptr);
-	ptr += 2;
-	printf("Version: \033[0;32m0x%.02X\033[0m\n",*(uint16_t*)ptr);
-
-	ptr = p + EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE; // Categories
+	if(hdr.checksumOK()) {
+		printf("Checksum: \033[0;32m0x%.02X (OK)\033[0m\n",hdr.checksum());
+	} else {
+		printf("Checksum: \033[0;31m0x%.02X (MISMATCH, calculated 0x%.02X)\033[0m\n",
+			hdr.checksum(),hdr.calculatedChecksum());
+	}
+	printf("Vendor: \033[0;32m0x%.08X \033[0;36m[Esi:EtherCATInfo:Vendor]\033[0m\n",hdr.vendorId());
+	printf("Product: \033[0;32m0x%.08X \033[0;36m[Esi:DeviceType:Type:ProductCode]\033[0m\n",hdr.productCode());
+	printf("Revision: \033[0;32m0x%.08X \033[0;36m[Esi:DeviceType:Type:RevisionNo]\033[0m\n",hdr.revisionNo());
+	printf("Size: \033[0;32m0x%.02X \033[0;36m[Esi:DeviceType:Eeprom:ByteSize]\033[0m\n",hdr.eepromSize());
+	printf("Version: \033[0;32m0x%.02X\033[0m\n",hdr.version());
 
+	StringsView strings = reader.strings();
 	int categoryNo = 1;
-	uint16_t* category = (uint16_t*)ptr;
-	uint8_t* nextCategoryPtr = ptr;
-	std::vector<uint8_t*> stringPointers;
-
-	while(*category != 0 && *category != 0xFFFF) {
-		uint16_t categorySizeW = *(uint16_t*)(ptr+2);
+	for(const Category& cat : reader) {
 		printf("--------------------------\n");
 		printf("Category %d: \033[0;31m%s\033[0m (%d) - %d words\n\n",categoryNo,
-			getCategoryString(*category),*category,categorySizeW);
-		nextCategoryPtr += (categorySizeW*2)+4; // +4 = header and category size
-		ptr += 4;
-		switch(*category) {
+			getCategoryString(cat.type),cat.type,cat.sizeW);
+		bool decoded = true;
+		if(cat.truncated) {
+			printf("\033[0;31mWARNING:\033[0m Category extends past end of image, only %zu bytes present\n",
+				cat.payload.size());
+		}
+		switch(cat.type) {
 			case EEPROMCategorySTRINGS: {
-				uint8_t stringcnt = *ptr++;
-				printf("%d strings present\n",stringcnt);
-				for(uint8_t s = 1; s <= stringcnt; ++s) {
-					stringPointers.push_back(p);
-					uint8_t stringlen = *ptr++;
-					printf("\033[0;33mString %d\033[0m: '\033[0;32m",s);
-					for(uint8_t i = 0; i < stringlen; ++i) {
-						printf("%c",(const char)(*ptr++));
-					}
-					printf("\033[0m' (length: %d)\n",stringlen);
+				StringsView sv = cat.strings();
+				printf("%d strings present\n",sv.count());
+				for(uint8_t s = 1; s <= sv.count() && s != 0; ++s) {
+					std::string_view str = sv.string(s);
+					printf("\033[0;33mString %d\033[0m: '\033[0;32m%.*s\033[0m' (length: %zu)\n",
+						s,(int)str.size(),str.data(),str.size());
 				}
 			}
 			break;
 			case EEPROMCategoryGeneral: {
-				printf("Group Index: \033[0;32m%d \033[0;36m[Esi:DeviceType:GroupType]\033[0m\n",*ptr++);
-				printf("Image Index: \033[0;32m%d \033[0;36m[Esi:DeviceType:ImageData16x14]\033[0m\n",*ptr++);
-				printf("Device Order: \033[0;32m%d \033[0;36m[Esi:DeviceType:Type]\033[0m\n",*ptr++);
-				printf("Name Index: \033[0;32m%d \033[0;36m[Esi:DeviceType:Name]\033[0m\n",*ptr++); // TODO print string
-				ptr++; // Reserved
+				GeneralView g = cat.general();
+				std::string_view name = strings.string(g.nameIdx());
+				printf("Group Index: \033[0;32m%d \033[0;36m[Esi:DeviceType:GroupType]\033[0m\n",g.groupIdx());
+				printf("Image Index: \033[0;32m%d \033[0;36m[Esi:DeviceType:ImageData16x14]\033[0m\n",g.imgIdx());
+				printf("Device Order: \033[0;32m%d \033[0;36m[Esi:DeviceType:Type]\033[0m\n",g.orderIdx());
+				printf("Name Index: \033[0;32m%d ('%.*s') \033[0;36m[Esi:DeviceType:Name]\033[0m\n",
+					g.nameIdx(),(int)name.size(),name.data());
 				printf("\n");
-				uint8_t coe = *ptr++;
+				uint8_t coe = g.coeDetails();
 				if(coe & 0x1) {
 					printf("CoE supported \033[0;36m[Esi:DeviceType:Mailbox:CoE]\033[0m\n");
 					if(coe & 0x2)	printf("- Enable SDO Info \033[0;36m[Esi:DeviceType:Mailbox:CoE:SDOInfo]\033[0m\n");
@@ -105,18 +182,13 @@ void SII::decodeEEPROMBinary(const std::string& file, const bool verbose) {
 					if(coe & 0x10)	printf("- Enable PDO Upload \033[0;36m[Esi:DeviceType:Mailbox:CoE:PdoUload]\033[0m\n");
 					if(coe & 0x20)	printf("- Enable SDO Complete Access \033[0;36m[Esi:DeviceType:Mailbox:CoE:CompleteAccess]\033[0m\n");
 				}
-				uint8_t foe = *ptr++;
-				if(foe & 0x1) {
+				if(g.foeDetails() & 0x1) {
 					printf("FoE supported \033[0;36m[Esi:DeviceType:Mailbox:FoE]\033[0m\n");
 				}
-				uint8_t eoe = *ptr++;
-				if(eoe & 0x1) {
+				if(g.eoeDetails() & 0x1) {
 					printf("EoE supported \033[0;36m[Esi:DeviceType:Mailbox:EoE]\033[0m\n");
 				}
-				ptr++; // Reserved (SoEChannels)
-				ptr++; // Reserved (DS402Channels)
-				ptr++; // Reserved (SysmanClass)
-				uint8_t flags = *ptr++;
+				uint8_t flags = g.flags();
 				if(flags) {
 					printf("Flags:\n");
 					if(flags & 0x1) printf("- Enable SafeOp \033[0;36m[Esi:Info:StateMachine:Behavior:StartToSafeopNoSync]\033[0m\n");
@@ -125,133 +197,77 @@ void SII::decodeEEPROMBinary(const std::string& file, const bool verbose) {
 					if(flags & 0x8) printf("- ID selector mirrored in AL Status Code \033[0;36m[ESI:Info:IdentificationReg134]\033[0m\n");
 					if(flags & 0x10) printf("- ID selector value mirrored in specific physical memory as denoted by the parameter \"Physical Memory Address\" \033[0;36m[Esi:Info:IdentificationAdo]\033[0m\n");
 				}
-				uint16_t ebuscurrent = *ptr++;
-				ebuscurrent += (*ptr++) << 8;
 				printf("\n");
-				printf("Ebus current: \033[0;32m%d mA\033[0m \033[0;36m[Esi:Info:Electrical:EBusCurrent]\033[0m\n",ebuscurrent);
-				printf("Group index (compatibility duplicate): \033[0;32m0x%.02X\033[0m\n",*ptr++);
-				ptr++; // Reserved
+				printf("Ebus current: \033[0;32m%d mA\033[0m \033[0;36m[Esi:Info:Electrical:EBusCurrent]\033[0m\n",g.ebusCurrent());
+				printf("Group index (compatibility duplicate): \033[0;32m0x%.02X\033[0m\n",g.groupIdxDup());
 				printf("\n");
-				uint16_t physicalport = *ptr++;
-				physicalport += (*ptr++) << 8;
+				uint16_t physicalport = g.physicalPort();
 				printf("Physical port configuration: \033[0;36m[Esi:Device@PhysicsType]\033[0m\n");
 				for(int port : {0, 1, 2, 3}) {
-					printf("\033[0;33mPort %d\033[0m: \033[0;32m",port);
-					switch((physicalport >> (port*4)) & 0xF) {
-						case 0x0:
-							printf("Not in use");
-						break;
-						case 0x1:
-							printf("MII");
-						break;
-						case 0x2:
-							printf("Reserved");
-						break;
-						case 0x3:
-							printf("EBUS");
-						break;
-						case 0x4:
-							printf("Fast Hot Connect");
-						break;
-					}
-					printf("\033[0m\n");
+					printf("\033[0;33mPort %d\033[0m: \033[0;32m%s\033[0m\n",port,
+						getPhysicalPortString((physicalport >> (port*4)) & 0xF));
 				}
 			}
 			break;
 			case EEPROMCategoryFMMU: {
-				uint16_t fmmucnt = categorySizeW*2;
-				printf("%d FMMUs described \033[0;36m[Esi:DeviceType:Fmmu]\033[0m\n\n",fmmucnt);
-				for(uint16_t fmmu = 0; fmmu < fmmucnt; ++fmmu) {
-					uint8_t fmmuconfig = *(ptr++);
-					printf("\033[0;33mFMMU%d\033[0m: \033[0;32m",fmmu);
-					switch(fmmuconfig) {
-						case 0x0: printf("Not used"); break;
-						case 0x1: printf("Used for Outputs"); break;
-						case 0x2: printf("Used for Inputs"); break;
-						case 0x3: printf("Used for SyncM (Read Mailbox)"); break;
-						case 0xFF: printf("Not used"); break;
-					}
-					printf("\033[0m\n");
+				FMMUView fv = cat.fmmu();
+				printf("%zu FMMUs described \033[0;36m[Esi:DeviceType:Fmmu]\033[0m\n\n",fv.count());
+				for(size_t fmmu = 0; fmmu < fv.count(); ++fmmu) {
+					printf("\033[0;33mFMMU%zu\033[0m: \033[0;32m%s\033[0m\n",fmmu,getFMMUTypeString(fv.config(fmmu)));
 				}
 			}
 			break;
 			case EEPROMCategorySyncM: {
-				uint16_t smcnt = (categorySizeW*2)/8;
-				printf("%d SyncManagers described\n\n",smcnt);
-				for(uint16_t sm; sm < smcnt; ++sm) {
-					printf("\033[0;33mSyncManager %d\033[0m:\n",sm);
-					printf("Physical Start Address: \033[0;32m0x%.04X \033[0;36m[Esi:DeviceType:Sm:StartAddress]\033[0m\n",*(uint16_t*)(ptr));
-					ptr += 2;
-					printf("Length: \033[0;32m0x%.04X \033[0;36m[Esi:DeviceType:Sm:DefaultSize]\033[0m\n",*(uint16_t*)(ptr));
-					ptr += 2;
-					printf("Control Register: \033[0;32m0x%.02X \033[0;36m[Esi:DeviceType:Sm:ControlByte]\033[0m\n",*(ptr++));
-					printf("Status Register: \033[0;32m0x%.02X \033[0;36m[dont care]\033[0m\n",*(ptr++));
-					uint8_t enable = *(ptr++);
+				SyncMView smv = cat.syncm();
+				size_t smcnt = smv.count();
+				printf("%zu SyncManagers described\n\n",smcnt);
+				for(size_t sm = 0; sm < smcnt; ++sm) {
+					SyncMEntryView e = smv.sm(sm);
+					printf("\033[0;33mSyncManager %zu\033[0m:\n",sm);
+					printf("Physical Start Address: \033[0;32m0x%.04X \033[0;36m[Esi:DeviceType:Sm:StartAddress]\033[0m\n",e.startAddress());
+					printf("Length: \033[0;32m0x%.04X \033[0;36m[Esi:DeviceType:Sm:DefaultSize]\033[0m\n",e.length());
+					printf("Control Register: \033[0;32m0x%.02X \033[0;36m[Esi:DeviceType:Sm:ControlByte]\033[0m\n",e.control());
+					printf("Status Register: \033[0;32m0x%.02X \033[0;36m[dont care]\033[0m\n",e.status());
+					uint8_t enable = e.enable();
 					printf("Enable state: \033[0;36m[Esi:DeviceType:Sm:Enable]\033[0m\n");
 					if(0x0 == enable) printf("- isn't enabled\n");
 					if(enable & 0x1) printf("- is enabled\n");
 					if(enable & 0x2) printf("- has fixed content\n");
 					if(enable & 0x4) printf("- is virtual\n");
 					if(enable & 0x8) printf("- is only enabled in Operation state\n");
-					uint8_t type = *(ptr++);
-					printf("Type: \033[0;32m");
-					switch(type) {
-						default:
-						case 0x0:
-							printf("Unused/Unknown");
-						break;
-						case 0x1:
-							printf("Mailbox Out");
-						break;
-						case 0x2:
-							printf("Mailbox In");
-						break;
-						case 0x3:
-							printf("Process data outputs");
-						break;
-						case 0x4:
-							printf("Process data inputs");
-						break;
-					}
-					printf(" \033[0;36m[Esi:DeviceType:Sm]\033[0m\n");
+					printf("Type: \033[0;32m%s \033[0;36m[Esi:DeviceType:Sm]\033[0m\n",getSyncMTypeString(e.type()));
 					if(sm < smcnt-1)printf("\n");
 				}
 			}
 			break;
 			case EEPROMCategoryDC: {
-				uint16_t dccnt = (categorySizeW*2)/24;
-				printf("%d clock cycles described\n\n",dccnt);
-				for(uint16_t dc = 0; dc < dccnt; ++dc) {
-					printf("\033[0;33mDC %d\033[0m:\n",dc);
-					printf("CycleTime0: \033[0;32m%u \033[0;36m[Esi:Dc:OpMode:CycleTimeSync0]\033[0m\n",*(uint32_t*)ptr);
-					ptr += 4;
-					printf("ShiftTime0: \033[0;32m%u \033[0;36m[Esi:Dc:OpMode:ShiftTimeSync0]\033[0m\n",*(uint32_t*)ptr);
-					ptr += 4;
-					printf("ShiftTime1: \033[0;32m%u \033[0;36m[Esi:Dc:OpMode:ShiftTimeSync1]\033[0m\n",*(uint32_t*)ptr);
-					ptr += 4;
-					printf("CycleTimeSync1@Factor: \033[0;32m%d \033[0;36m[Esi:Dc:OpMode:CycleTimeSync1@Factor]\033[0m\n",*(int16_t*)ptr);
-					ptr += 2;
-					printf("AssignActivate: \033[0;32m0x%.04X \033[0;36m[Esi:Dc:OpMode:AssignActivate]\033[0m\n",*(uint16_t*)ptr);
-					ptr += 2;
-					printf("CycleTimeSync0@Factor: \033[0;32m%d \033[0;36m[Esi:Dc:OpMode:CycleTimeSync0@Factor]\033[0m\n",*(int16_t*)ptr);
-					ptr += 2;
-					printf("Name index: \033[0;32m%d \033[0;36m[Esi:Dc:OpMode:Name]\033[0m\n",*(ptr++));
-					printf("Description index: \033[0;32m%d \033[0;36m[Esi:Dc:OpMode:Desc]\033[0m\n",*(ptr++));
-					ptr += 4; // Reserved
+				DCView dcv = cat.dc();
+				size_t dccnt = dcv.count();
+				printf("%zu clock cycles described\n\n",dccnt);
+				for(size_t dc = 0; dc < dccnt; ++dc) {
+					DCOpmodeView op = dcv.opmode(dc);
+					printf("\033[0;33mDC %zu\033[0m:\n",dc);
+					printf("CycleTime0: \033[0;32m%u \033[0;36m[Esi:Dc:OpMode:CycleTimeSync0]\033[0m\n",op.cycleTime0());
+					printf("ShiftTime0: \033[0;32m%u \033[0;36m[Esi:Dc:OpMode:ShiftTimeSync0]\033[0m\n",op.shiftTime0());
+					printf("ShiftTime1: \033[0;32m%u \033[0;36m[Esi:Dc:OpMode:ShiftTimeSync1]\033[0m\n",op.shiftTime1());
+					printf("CycleTimeSync1@Factor: \033[0;32m%d \033[0;36m[Esi:Dc:OpMode:CycleTimeSync1@Factor]\033[0m\n",op.sync1CycleFactor());
+					printf("AssignActivate: \033[0;32m0x%.04X \033[0;36m[Esi:Dc:OpMode:AssignActivate]\033[0m\n",op.assignActivate());
+					printf("CycleTimeSync0@Factor: \033[0;32m%d \033[0;36m[Esi:Dc:OpMode:CycleTimeSync0@Factor]\033[0m\n",op.sync0CycleFactor());
+					printf("Name index: \033[0;32m%d \033[0;36m[Esi:Dc:OpMode:Name]\033[0m\n",op.nameIdx());
+					printf("Description index: \033[0;32m%d \033[0;36m[Esi:Dc:OpMode:Desc]\033[0m\n",op.descIdx());
 					if(dc < dccnt-1)printf("\n");
 				}
 			}
 			break;
 			case EEPROMCategoryTXPDO:
 			case EEPROMCategoryRXPDO: {
-				printf("Index: \033[0;32m0x%.04X\033[0m\n",*(uint16_t*)ptr);
-				ptr += 2;
-				uint8_t entries = *(ptr++);
-				printf("%d entries\n",entries);
-				printf("Related to SyncManager #\033[0;32m%d\033[0m\n",*(ptr++));
-				printf("Related to DC #\033[0;32m%d\033[0m\n",*(ptr++));
-				printf("Name index: \033[0;32m%d\033[0m\n",*(ptr++));
-				uint16_t flags = *(uint16_t*)ptr;
+				PdoView pdo = cat.pdo();
+				printf("Index: \033[0;32m0x%.04X\033[0m\n",pdo.index());
+				printf("%d entries\n",pdo.entryCount());
+				printf("Related to SyncManager #\033[0;32m%d\033[0m\n",pdo.syncManager());
+				printf("Related to DC #\033[0;32m%d\033[0m\n",pdo.dc());
+				printf("Name index: \033[0;32m%d\033[0m\n",pdo.nameIdx());
+				uint16_t flags = pdo.flags();
 				if(flags) {
 					printf("Flags:\n");
 					if(flags & 0x0001) printf("- PdoMandatory \033[0;36m[Esi:RTxPdo@Mandatory]\033[0m\n");
@@ -270,34 +286,200 @@ void SII::decodeEEPROMBinary(const std::string& file, const bool verbose) {
 					if(flags & 0x4000) printf("- Reserved (PdoDisAutoExclude)\n");
 					if(flags & 0x8000) printf("- Reserved (PdoWritable)\n");
 				}
-				ptr += 2;
 				printf("\n");
+				if(pdo.entries() < pdo.entryCount()) {
+					printf("\033[0;31mWARNING:\033[0m Only %zu of %d entries fit in the category\n",
+						pdo.entries(),pdo.entryCount());
+				}
 				if(verbose) {
-					for(uint8_t entry = 0; entry < entries; ++entry) {
-						printf("Index: \033[0;32m0x%.04X \033[0;36m[Esi:PdoType:EntryType@Index]\033[0m\n",*(uint16_t*)ptr);
-						ptr += 2;
-						printf("SubIndex: \033[0;32m0x%.02X \033[0;36m[Esi:PdoType:EntryType@Subindex]\033[0m\n",*(ptr)++);
-						printf("Name Index: \033[0;32m0x%.02X \033[0;36m[Esi:PdoType:EntryType@Name]\033[0m\n",*(ptr)++);
-						printf("Data Type (CoE index): \033[0;32m0x%.02X \033[0;36m[Esi:PdoType:EntryType@DataType]\033[0m\n",*(ptr)++);
-						printf("BitLen: \033[0;32m0x%.02X \033[0;36m[Esi:PdoType:EntryType@DataType]\033[0m\n",*(ptr)++);
-						ptr += 2; // Reserved Flags
-						//ptr += 8; // 8 bytes per entry
-						if(entry < entries-1) printf("\n");
+					for(size_t entry = 0; entry < pdo.entries(); ++entry) {
+						PdoEntryView e = pdo.entry(entry);
+						printf("Index: \033[0;32m0x%.04X \033[0;36m[Esi:PdoType:EntryType@Index]\033[0m\n",e.index());
+						printf("SubIndex: \033[0;32m0x%.02X \033[0;36m[Esi:PdoType:EntryType@Subindex]\033[0m\n",e.subindex());
+						printf("Name Index: \033[0;32m0x%.02X \033[0;36m[Esi:PdoType:EntryType@Name]\033[0m\n",e.nameIdx());
+						printf("Data Type (CoE index): \033[0;32m0x%.02X \033[0;36m[Esi:PdoType:EntryType@DataType]\033[0m\n",e.dataType());
+						printf("BitLen: \033[0;32m0x%.02X \033[0;36m[Esi:PdoType:EntryType@DataType]\033[0m\n",e.bitLen());
+						if(entry < pdo.entries()-1) printf("\n");
 					}
 				}
 			}
 			break;
+			default:
+				// No decoder for this one, show what is in it
+				HexDump(cat.offset + 4).write(stdout,cat.payload.data(),cat.payload.size());
+				decoded = false;
+			break;
+		}
+		if(verbose && decoded && !cat.payload.empty()) {
+			printf("\nRaw payload:\n");
+			HexDump(cat.offset + 4).write(stdout,cat.payload.data(),cat.payload.size());
 		}
-		ptr = nextCategoryPtr;
-		category = (uint16_t*)ptr;
 		++categoryNo;
 	}
 	printf("--------------------------\n");
+}
 
-	close(fd);
+void SII::writeEEPROMJSON(const SII::Reader& reader, JSONWriter& json) {
+	HeaderView hdr = reader.header();
+	json.value("size",reader.image().size());
+	json.value("valid",hdr.valid());
+	if(!hdr.valid()) return;
+
+	json.beginObject("header");
+	std::string configdata;
+	static const char hex[] = "0123456789ABCDEF";
+	for(uint8_t i = 0; i < EC_SII_CONFIGDATA_SIZEB; ++i) {
+		configdata += hex[hdr.configData().u8(i) >> 4];
+		configdata += hex[hdr.configData().u8(i) & 0xF];
+	}
+	json.value("configdata",configdata);
+	json.beginObject("checksum")
+		.value("stored",(unsigned int)hdr.checksum())
+		.value("calculated",(unsigned int)hdr.calculatedChecksum())
+		.value("ok",hdr.checksumOK())
+		.endObject();
+	json.value("vendor",hdr.vendorId());
+	json.value("product",hdr.productCode());
+	json.value("revision",hdr.revisionNo());
+	json.value("serial",hdr.serialNo());
+	json.beginObject("mailbox")
+		.value("outoffset",(unsigned int)hdr.mailboxOutOffset())
+		.value("outsize",(unsigned int)hdr.mailboxOutSize())
+		.value("inoffset",(unsigned int)hdr.mailboxInOffset())
+		.value("insize",(unsigned int)hdr.mailboxInSize())
+		.value("protocol",(unsigned int)hdr.mailboxProtocol())
+		.endObject();
+	json.value("eepromsize",(unsigned int)hdr.eepromSize());
+	json.value("version",(unsigned int)hdr.version());
+	json.endObject();
+
+	StringsView strings = reader.strings();
+	json.beginArray("categories");
+	for(const Category& cat : reader) {
+		json.beginObject();
+		json.value("type",(unsigned int)cat.type);
+		json.value("name",getCategoryString(cat.type));
+		json.value("offset",cat.offset);
+		json.value("words",(unsigned int)cat.sizeW);
+		if(cat.truncated) json.value("truncated",true);
+		switch(cat.type) {
+			case EEPROMCategorySTRINGS: {
+				StringsView sv = cat.strings();
+				json.beginArray("strings");
+				for(uint8_t s = 1; s <= sv.count() && s != 0; ++s) json.value(NULL,sv.string(s));
+				json.endArray();
+			}
+			break;
+			case EEPROMCategoryGeneral: {
+				GeneralView g = cat.general();
+				json.beginObject("general")
+					.value("groupidx",(unsigned int)g.groupIdx())
+					.value("imgidx",(unsigned int)g.imgIdx())
+					.value("orderidx",(unsigned int)g.orderIdx())
+					.value("nameidx",(unsigned int)g.nameIdx())
+					.value("name",strings.string(g.nameIdx()))
+					.value("coedetails",(unsigned int)g.coeDetails())
+					.value("foedetails",(unsigned int)g.foeDetails())
+					.value("eoedetails",(unsigned int)g.eoeDetails())
+					.value("soechannels",(unsigned int)g.soeChannels())
+					.value("ds402channels",(unsigned int)g.ds402Channels())
+					.value("sysmanclass",(unsigned int)g.sysmanClass())
+					.value("flags",(unsigned int)g.flags())
+					.value("ebuscurrent",(int)g.ebusCurrent())
+					.value("physicalport",(unsigned int)g.physicalPort())
+					.value("physicalmemaddr",(unsigned int)g.physicalMemAddr())
+					.endObject();
+			}
+			break;
+			case EEPROMCategoryFMMU: {
+				FMMUView fv = cat.fmmu();
+				json.beginArray("fmmu");
+				for(size_t fmmu = 0; fmmu < fv.count(); ++fmmu) json.value(NULL,(unsigned int)fv.config(fmmu));
+				json.endArray();
+			}
+			break;
+			case EEPROMCategorySyncM: {
+				SyncMView smv = cat.syncm();
+				json.beginArray("syncmanagers");
+				for(size_t sm = 0; sm < smv.count(); ++sm) {
+					SyncMEntryView e = smv.sm(sm);
+					json.beginObject()
+						.value("startaddress",(unsigned int)e.startAddress())
+						.value("length",(unsigned int)e.length())
+						.value("control",(unsigned int)e.control())
+						.value("status",(unsigned int)e.status())
+						.value("enable",(unsigned int)e.enable())
+						.value("type",(unsigned int)e.type())
+						.endObject();
+				}
+				json.endArray();
+			}
+			break;
+			case EEPROMCategoryDC: {
+				DCView dcv = cat.dc();
+				json.beginArray("opmodes");
+				for(size_t dc = 0; dc < dcv.count(); ++dc) {
+					DCOpmodeView op = dcv.opmode(dc);
+					json.beginObject()
+						.value("cycletime0",op.cycleTime0())
+						.value("shifttime0",op.shiftTime0())
+						.value("shifttime1",op.shiftTime1())
+						.value("sync1factor",(int)op.sync1CycleFactor())
+						.value("assignactivate",(unsigned int)op.assignActivate())
+						.value("sync0factor",(int)op.sync0CycleFactor())
+						.value("nameidx",(unsigned int)op.nameIdx())
+						.value("descidx",(unsigned int)op.descIdx())
+						.endObject();
+				}
+				json.endArray();
+			}
+			break;
+			case EEPROMCategoryTXPDO:
+			case EEPROMCategoryRXPDO: {
+				PdoView pdo = cat.pdo();
+				json.beginObject("pdo")
+					.value("index",(unsigned int)pdo.index())
+					.value("syncmanager",(unsigned int)pdo.syncManager())
+					.value("dc",(unsigned int)pdo.dc())
+					.value("nameidx",(unsigned int)pdo.nameIdx())
+					.value("flags",(unsigned int)pdo.flags())
+					.value("entrycount",(unsigned int)pdo.entryCount());
+				json.beginArray("entries");
+				for(size_t entry = 0; entry < pdo.entries(); ++entry) {
+					PdoEntryView e = pdo.entry(entry);
+					json.beginObject()
+						.value("index",(unsigned int)e.index())
+						.value("subindex",(unsigned int)e.subindex())
+						.value("nameidx",(unsigned int)e.nameIdx())
+						.value("datatype",(unsigned int)e.dataType())
+						.value("bitlen",(unsigned int)e.bitLen())
+						.value("flags",(unsigned int)e.flags())
+						.endObject();
+				}
+				json.endArray();
+				json.endObject();
+			}
+			break;
+		}
+		json.endObject();
+	}
+	json.endArray();
+}
 
-	err = munmap((void*)p, statbuf.st_size);
+void SII::decodeEEPROMBinary(const std::string& file, const bool verbose, const bool json) {
+	MappedFile mapped;
+	if(!mapped.open(file)) return;
+	Reader reader(mapped.span());
 
-	if(err != 0) printf("UnMapping Failed (%d)\n",errno);
-	return;
-}
\ No newline at end of file
+	if(json) {
+		JSONWriter out;
+		out.beginObject();
+		out.value("file",file);
+		writeEEPROMJSON(reader,out);
+		out.endObject();
+		out.write(stdout);
+	} else {
+		printf("Decoding SII from '%s'\n",file.c_str());
+		printEEPROM(reader,verbose);
+	}
+}
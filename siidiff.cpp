@@ -0,0 +1,313 @@
+#include "sii.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "esctoolhelpers.h"
+#include "siireader.h"
+
+/**
+ * Find the byte ranges where a and b differ. Equal 16 byte blocks are
+ * skipped with one SSE2 compare each (8 byte words without SSE2), only
+ * blocks that differ are narrowed down byte by byte. Bytes present in only
+ * one of the images count as different.
+ */
+std::vector<SII::DiffRange> SII::diffRanges(const ByteSpan& a, const ByteSpan& b) {
+	std::vector<DiffRange> ranges;
+	const size_t common = std::min(a.size(),b.size());
+	const uint8_t* pa = a.data();
+	const uint8_t* pb = b.data();
+
+	auto add = [&ranges](size_t offset, size_t len) {
+		if(!ranges.empty() && ranges.back().offset + ranges.back().length == offset) {
+			ranges.back().length += len;
+		} else {
+			ranges.push_back({offset,len});
+		}
+	};
+
+	size_t i = 0;
+#if defined(__SSE2__)
+	for(; i + 16 <= common; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i*)(pa + i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(pb + i));
+		if(0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi8(va,vb))) continue;
+		for(size_t j = i; j < i + 16; ++j) if(pa[j] != pb[j]) add(j,1);
+	}
+#else
+	for(; i + 8 <= common; i += 8) {
+		uint64_t wa, wb;
+		memcpy(&wa,pa + i,8);
+		memcpy(&wb,pb + i,8);
+		if(wa == wb) continue;
+		for(size_t j = i; j < i + 8; ++j) if(pa[j] != pb[j]) add(j,1);
+	}
+#endif
+	for(; i < common; ++i) if(pa[i] != pb[i]) add(i,1);
+	if(a.size() != b.size()) add(common,std::max(a.size(),b.size()) - common);
+	return ranges;
+}
+
+// Describes where in the image a byte offset belongs
+static std::string describeOffset(const SII::Reader& reader, size_t offset) {
+	char s[96];
+	if(offset < EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE) {
+		const char* field = "Header";
+		if(offset < EC_SII_CONFIGDATA_CHECKSUM_OFFSET_BYTE) field = "ConfigData";
+		else if(offset < EC_SII_EEPROM_VENDOR_OFFSET_BYTE) field = "ConfigData checksum";
+		else if(offset < EC_SII_EEPROM_VENDOR_OFFSET_BYTE+4) field = "Vendor";
+		else if(offset < EC_SII_EEPROM_VENDOR_OFFSET_BYTE+8) field = "Product";
+		else if(offset < EC_SII_EEPROM_VENDOR_OFFSET_BYTE+12) field = "Revision";
+		else if(offset < EC_SII_EEPROM_VENDOR_OFFSET_BYTE+16) field = "Serial";
+		else if(offset >= EC_SII_EEPROM_MAILBOX_OUT_OFFSET_BYTE && offset < EC_SII_EEPROM_MAILBOX_IN_OFFSET_BYTE) field = "Mailbox Out";
+		else if(offset >= EC_SII_EEPROM_MAILBOX_IN_OFFSET_BYTE && offset < EC_SII_EEPROM_MAILBOX_PROTO_OFFSET_BYTE) field = "Mailbox In";
+		else if(offset >= EC_SII_EEPROM_MAILBOX_PROTO_OFFSET_BYTE && offset < EC_SII_EEPROM_MAILBOX_PROTO_OFFSET_BYTE+2) field = "Mailbox Protocol";
+		else if(offset >= EC_SII_EEPROM_SIZE_OFFSET_BYTE && offset < EC_SII_EEPROM_VERSION_OFFSET_BYTE) field = "Size";
+		else if(offset >= EC_SII_EEPROM_VERSION_OFFSET_BYTE) field = "Version";
+		snprintf(s,sizeof(s),"%s",field);
+		return s;
+	}
+	int categoryNo = 1;
+	for(const SII::Category& cat : reader) {
+		if(offset >= cat.offset && offset < cat.offset + 4 + cat.payload.size()) {
+			snprintf(s,sizeof(s),"Category %d %s +0x%zX",categoryNo,
+				getCategoryString(cat.type),offset - cat.offset);
+			return s;
+		}
+		++categoryNo;
+	}
+	return "after categories";
+}
+
+// True if one of the (sorted, disjoint) ranges overlaps [offset,offset+length)
+static bool touches(const std::vector<SII::DiffRange>& ranges, size_t offset, size_t length) {
+	auto it = std::lower_bound(ranges.begin(),ranges.end(),offset,
+		[](const SII::DiffRange& r, size_t o) { return r.offset + r.length <= o; });
+	return it != ranges.end() && it->offset < offset + length;
+}
+
+// Prints a single field difference, returns 1 if the values differ
+static int diffField(const char* where, const char* field, uint32_t a, uint32_t b) {
+	if(a == b) return 0;
+	printf("%s: %s \033[0;31m0x%X\033[0m -> \033[0;32m0x%X\033[0m\n",where,field,a,b);
+	return 1;
+}
+
+static int diffStrings(const char* where, std::string_view a, std::string_view b) {
+	if(a == b) return 0;
+	printf("%s: \033[0;31m'%.*s'\033[0m -> \033[0;32m'%.*s'\033[0m\n",where,
+		(int)a.size(),a.data(),(int)b.size(),b.data());
+	return 1;
+}
+
+/**
+ * Field level compare of two categories of the same type. The categories
+ * are matched up in order of appearance per type.
+ */
+static int diffCategory(const char* where, const SII::Category& a, const SII::Category& b) {
+	if(a.payload.size() == b.payload.size() &&
+		0 == memcmp(a.payload.data(),b.payload.data(),a.payload.size())) return 0;
+	int diffs = 0;
+	char w[128];
+	switch(a.type) {
+		case EEPROMCategorySTRINGS: {
+			SII::StringsView sa = a.strings(), sb = b.strings();
+			diffs += diffField(where,"count",sa.count(),sb.count());
+			for(uint16_t s = 1; s <= std::max(sa.count(),sb.count()); ++s) {
+				snprintf(w,sizeof(w),"%s String %d",where,s);
+				diffs += diffStrings(w,sa.string(s),sb.string(s));
+			}
+		}
+		break;
+		case EEPROMCategoryGeneral: {
+			SII::GeneralView ga = a.general(), gb = b.general();
+			diffs += diffField(where,"GroupIdx",ga.groupIdx(),gb.groupIdx());
+			diffs += diffField(where,"ImgIdx",ga.imgIdx(),gb.imgIdx());
+			diffs += diffField(where,"OrderIdx",ga.orderIdx(),gb.orderIdx());
+			diffs += diffField(where,"NameIdx",ga.nameIdx(),gb.nameIdx());
+			diffs += diffField(where,"CoEDetails",ga.coeDetails(),gb.coeDetails());
+			diffs += diffField(where,"FoEDetails",ga.foeDetails(),gb.foeDetails());
+			diffs += diffField(where,"EoEDetails",ga.eoeDetails(),gb.eoeDetails());
+			diffs += diffField(where,"Flags",ga.flags(),gb.flags());
+			diffs += diffField(where,"EbusCurrent",(uint16_t)ga.ebusCurrent(),(uint16_t)gb.ebusCurrent());
+			diffs += diffField(where,"PhysicalPort",ga.physicalPort(),gb.physicalPort());
+			diffs += diffField(where,"PhysicalMemAddr",ga.physicalMemAddr(),gb.physicalMemAddr());
+		}
+		break;
+		case EEPROMCategoryFMMU: {
+			SII::FMMUView fa = a.fmmu(), fb = b.fmmu();
+			diffs += diffField(where,"count",fa.count(),fb.count());
+			for(size_t f = 0; f < std::min(fa.count(),fb.count()); ++f) {
+				snprintf(w,sizeof(w),"%s FMMU%zu",where,f);
+				diffs += diffField(w,"Usage",fa.config(f),fb.config(f));
+			}
+		}
+		break;
+		case EEPROMCategorySyncM: {
+			SII::SyncMView sa = a.syncm(), sb = b.syncm();
+			diffs += diffField(where,"count",sa.count(),sb.count());
+			for(size_t n = 0; n < std::min(sa.count(),sb.count()); ++n) {
+				SII::SyncMEntryView ea = sa.sm(n), eb = sb.sm(n);
+				snprintf(w,sizeof(w),"%s SM%zu",where,n);
+				diffs += diffField(w,"StartAddress",ea.startAddress(),eb.startAddress());
+				diffs += diffField(w,"Length",ea.length(),eb.length());
+				diffs += diffField(w,"Control",ea.control(),eb.control());
+				diffs += diffField(w,"Enable",ea.enable(),eb.enable());
+				diffs += diffField(w,"Type",ea.type(),eb.type());
+			}
+		}
+		break;
+		case EEPROMCategoryTXPDO:
+		case EEPROMCategoryRXPDO: {
+			SII::PdoView pa = a.pdo(), pb = b.pdo();
+			diffs += diffField(where,"Index",pa.index(),pb.index());
+			diffs += diffField(where,"Entries",pa.entryCount(),pb.entryCount());
+			diffs += diffField(where,"SyncManager",pa.syncManager(),pb.syncManager());
+			diffs += diffField(where,"DC",pa.dc(),pb.dc());
+			diffs += diffField(where,"NameIdx",pa.nameIdx(),pb.nameIdx());
+			diffs += diffField(where,"Flags",pa.flags(),pb.flags());
+			for(size_t n = 0; n < std::min(pa.entries(),pb.entries()); ++n) {
+				SII::PdoEntryView ea = pa.entry(n), eb = pb.entry(n);
+				snprintf(w,sizeof(w),"%s 0x%.04X Entry %zu",where,pa.index(),n);
+				diffs += diffField(w,"Index",ea.index(),eb.index());
+				diffs += diffField(w,"SubIndex",ea.subindex(),eb.subindex());
+				diffs += diffField(w,"NameIdx",ea.nameIdx(),eb.nameIdx());
+				diffs += diffField(w,"DataType",ea.dataType(),eb.dataType());
+				diffs += diffField(w,"BitLen",ea.bitLen(),eb.bitLen());
+			}
+		}
+		break;
+		case EEPROMCategoryDC: {
+			SII::DCView da = a.dc(), db = b.dc();
+			diffs += diffField(where,"count",da.count(),db.count());
+			for(size_t n = 0; n < std::min(da.count(),db.count()); ++n) {
+				SII::DCOpmodeView oa = da.opmode(n), ob = db.opmode(n);
+				snprintf(w,sizeof(w),"%s Opmode %zu",where,n);
+				diffs += diffField(w,"CycleTime0",oa.cycleTime0(),ob.cycleTime0());
+				diffs += diffField(w,"ShiftTime0",oa.shiftTime0(),ob.shiftTime0());
+				diffs += diffField(w,"ShiftTime1",oa.shiftTime1(),ob.shiftTime1());
+				diffs += diffField(w,"Sync1Factor",(uint16_t)oa.sync1CycleFactor(),(uint16_t)ob.sync1CycleFactor());
+				diffs += diffField(w,"AssignActivate",oa.assignActivate(),ob.assignActivate());
+				diffs += diffField(w,"Sync0Factor",(uint16_t)oa.sync0CycleFactor(),(uint16_t)ob.sync0CycleFactor());
+				diffs += diffField(w,"NameIdx",oa.nameIdx(),ob.nameIdx());
+				diffs += diffField(w,"DescIdx",oa.descIdx(),ob.descIdx());
+			}
+		}
+		break;
+		default:
+			printf("%s: raw contents differ\n",where);
+			++diffs;
+		break;
+	}
+	// Differences not covered by any decoded field (reserved bytes, padding)
+	if(0 == diffs) {
+		printf("%s: reserved/padding bytes differ\n",where);
+		++diffs;
+	}
+	return diffs;
+}
+
+int SII::diffEEPROM(const ByteSpan& a, const ByteSpan& b, const bool verbose) {
+	std::vector<DiffRange> ranges = diffRanges(a,b);
+	if(ranges.empty()) return 0;
+
+	Reader ra(a), rb(b);
+	if(verbose) {
+		for(const DiffRange& r : ranges) {
+			printf("0x%.04zX-0x%.04zX (%zu bytes) in %s\n",r.offset,r.offset+r.length-1,r.length,
+				describeOffset(ra,r.offset).c_str());
+		}
+	}
+
+	int diffs = 0;
+	// Only the header and the categories a range touches are decoded
+	if(ranges.front().offset < EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE) {
+		HeaderView ha = ra.header(), hb = rb.header();
+		diffs += diffField("Header","ConfigData checksum",ha.checksum(),hb.checksum());
+		for(uint8_t i = 0; i < EC_SII_CONFIGDATA_CHECKSUM_OFFSET_BYTE; i += 2) {
+			char f[32];
+			snprintf(f,sizeof(f),"ConfigData word %d",i/2);
+			diffs += diffField("Header",f,ha.configData().u16(i),hb.configData().u16(i));
+		}
+		diffs += diffField("Header","Vendor",ha.vendorId(),hb.vendorId());
+		diffs += diffField("Header","Product",ha.productCode(),hb.productCode());
+		diffs += diffField("Header","Revision",ha.revisionNo(),hb.revisionNo());
+		diffs += diffField("Header","Serial",ha.serialNo(),hb.serialNo());
+		diffs += diffField("Header","Mailbox Out offset",ha.mailboxOutOffset(),hb.mailboxOutOffset());
+		diffs += diffField("Header","Mailbox Out size",ha.mailboxOutSize(),hb.mailboxOutSize());
+		diffs += diffField("Header","Mailbox In offset",ha.mailboxInOffset(),hb.mailboxInOffset());
+		diffs += diffField("Header","Mailbox In size",ha.mailboxInSize(),hb.mailboxInSize());
+		diffs += diffField("Header","Mailbox Protocol",ha.mailboxProtocol(),hb.mailboxProtocol());
+		diffs += diffField("Header","Size",ha.eepromSize(),hb.eepromSize());
+		diffs += diffField("Header","Version",ha.version(),hb.version());
+	}
+
+	if(ranges.back().offset + ranges.back().length > EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE) {
+		// Pair up categories by type and order of appearance
+		std::vector<Category> ca, cb;
+		for(const Category& c : ra) ca.push_back(c);
+		for(const Category& c : rb) cb.push_back(c);
+		std::vector<bool> matched(cb.size(),false);
+		int categoryNo = 1;
+		for(const Category& c : ca) {
+			char where[64];
+			snprintf(where,sizeof(where),"Category %d %s",categoryNo++,getCategoryString(c.type));
+			bool found = false;
+			for(size_t j = 0; j < cb.size(); ++j) {
+				if(matched[j] || cb[j].type != c.type) continue;
+				matched[j] = true;
+				found = true;
+				// Untouched and at the same place in both images means equal
+				if(c.offset != cb[j].offset || c.payload.size() != cb[j].payload.size() ||
+					touches(ranges,c.offset,4 + c.payload.size()))
+				{
+					diffs += diffCategory(where,c,cb[j]);
+				}
+				break;
+			}
+			if(!found) {
+				printf("%s: \033[0;31monly in first image\033[0m\n",where);
+				++diffs;
+			}
+		}
+		for(size_t j = 0; j < cb.size(); ++j) {
+			if(matched[j]) continue;
+			printf("Category %s: \033[0;32monly in second image\033[0m\n",getCategoryString(cb[j].type));
+			++diffs;
+		}
+	}
+
+	// Differences past the category list (unused EEPROM space)
+	if(0 == diffs) {
+		printf("%zu differing range(s) outside the decoded data\n",ranges.size());
+		diffs = ranges.size();
+	}
+	return diffs;
+}
+
+int SII::diffEEPROMBinary(const std::string& a, const std::vector<std::string>& others, const bool verbose) {
+	MappedFile golden;
+	if(!golden.open(a)) return -1;
+	int differing = 0;
+	for(const std::string& b : others) {
+		MappedFile other;
+		if(!other.open(b)) {
+			++differing;
+			continue;
+		}
+		printf("--- %s\n+++ %s\n",a.c_str(),b.c_str());
+		int diffs = diffEEPROM(golden.span(),other.span(),verbose);
+		if(diffs) {
+			printf("%d difference(s)\n",diffs);
+			++differing;
+		} else {
+			printf("Identical\n");
+		}
+	}
+	return differing;
+}
@@ -0,0 +1,301 @@
+#include "sii.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "siireader.h"
+#include "jsonwriter.h"
+#include "esctoolhelpers.h"
+#include "parallel.h"
+#include "profiler.h"
+
+/** What one image in the fleet decodes to, filled in by a worker thread */
+struct FleetImage {
+	std::string file;
+	const char* error = NULL; // Could not be read at all
+	bool valid = false;
+	bool checksumOK = false;
+	bool deviates = false; // Differs from the golden image
+	size_t size = 0;
+	uint32_t vendor = 0;
+	uint32_t product = 0;
+	uint32_t revision = 0;
+	std::string name;
+	std::vector<uint16_t> unknown; // Categories this tool does not know
+};
+
+/** Aggregate per (vendor, product, revision) */
+struct FleetGroup {
+	std::string name;
+	unsigned int count = 0;
+	unsigned int checksumFailures = 0;
+	unsigned int deviations = 0;
+	std::map<uint16_t,unsigned int> unknown;
+};
+
+// Reads the whole file into buf, which is reused between images of a thread
+static const char* readImage(const std::string& file, std::vector<uint8_t>& buf)
+{
+	int fd = open(file.c_str(), O_RDONLY);
+	if(fd < 0) return "could not open";
+	struct stat st;
+	if(fstat(fd,&st) < 0) {
+		close(fd);
+		return "could not stat";
+	}
+	buf.resize(st.st_size);
+	size_t got = 0;
+	while(got < buf.size()) {
+		ssize_t r = read(fd,buf.data()+got,buf.size()-got);
+		if(r <= 0) break;
+		got += r;
+	}
+	close(fd);
+	if(got != buf.size()) return "short read";
+	return NULL;
+}
+
+static void decodeFleetImage(FleetImage& img, const SII::ByteSpan& golden, std::vector<uint8_t>& buf)
+{
+	img.error = readImage(img.file,buf);
+	if(NULL != img.error) return;
+
+	SII::ByteSpan span(buf.data(),buf.size());
+	SII::Reader reader(span);
+	SII::HeaderView hdr = reader.header();
+	img.size = span.size();
+	img.valid = hdr.valid();
+	if(!img.valid) return;
+
+	img.checksumOK = hdr.checksumOK();
+	img.vendor = hdr.vendorId();
+	img.product = hdr.productCode();
+	img.revision = hdr.revisionNo();
+	if(!golden.empty())
+		img.deviates = golden.size() != span.size() || 0 != memcmp(golden.data(),span.data(),span.size());
+
+	SII::StringsView strings;
+	uint8_t nameIdx = 0;
+	for(const SII::Category& cat : reader) {
+		if(EEPROMCategorySTRINGS == cat.type && 0 == strings.count()) {
+			strings = cat.strings();
+		} else
+		if(EEPROMCategoryGeneral == cat.type) {
+			nameIdx = cat.general().nameIdx();
+		} else
+		if(!isKnownCategory(cat.type)) {
+			img.unknown.push_back(cat.type);
+		}
+	}
+	img.name = std::string(strings.string(nameIdx));
+}
+
+// Images in dir, sorted so the report does not depend on directory order
+static bool listImages(const std::string& dir, std::vector<std::string>& files)
+{
+	DIR* d = opendir(dir.c_str());
+	if(NULL == d) {
+		fprintf(stderr,"Could not open directory '%s'\n",dir.c_str());
+		return false;
+	}
+	std::string prefix = dir;
+	if(prefix.back() != '/') prefix += '/';
+	struct dirent* e;
+	while(NULL != (e = readdir(d))) {
+		if('.' == e->d_name[0]) continue;
+		std::string path = prefix + e->d_name;
+		struct stat st;
+		if(0 == stat(path.c_str(),&st) && S_ISREG(st.st_mode)) files.push_back(path);
+	}
+	closedir(d);
+	std::sort(files.begin(),files.end());
+	return true;
+}
+
+// Quoted for CSV, doubling any quotes in it
+static std::string csvQuote(const std::string& s)
+{
+	std::string quoted = "\"";
+	for(char c : s) {
+		if('"' == c) quoted += '"';
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+
+// Status of an image that did not make it into a group
+static const char* fleetError(const FleetImage& img)
+{
+	return img.error ? img.error : "invalid header";
+}
+
+// A row per group with status ok, then a row per image that could not be
+// read or has an invalid header, with the file as name and the reason as
+// status
+static void writeFleetCSV(const std::vector<FleetImage>& images,
+	const std::map<std::tuple<uint32_t,uint32_t,uint32_t>,FleetGroup>& groups)
+{
+	printf("vendor,product,revision,name,count,checksum_failures,golden_deviations,unknown_categories,status\n");
+	for(const auto& g : groups) {
+		printf("0x%.08X,0x%.08X,0x%.08X,%s,%u,%u,%u,",std::get<0>(g.first),std::get<1>(g.first),
+			std::get<2>(g.first),csvQuote(g.second.name).c_str(),g.second.count,g.second.checksumFailures,
+			g.second.deviations);
+		bool first = true;
+		for(const auto& u : g.second.unknown) {
+			printf("%s0x%.04X:%u",first ? "" : ";",u.first,u.second);
+			first = false;
+		}
+		printf(",ok\n");
+	}
+	for(const FleetImage& img : images) {
+		if(NULL == img.error && img.valid) continue;
+		printf(",,,%s,1,0,0,,%s\n",csvQuote(img.file).c_str(),fleetError(img));
+	}
+}
+
+static void writeFleetJSON(const std::string& dir, const std::string& golden,
+	const std::vector<FleetImage>& images,
+	const std::map<std::tuple<uint32_t,uint32_t,uint32_t>,FleetGroup>& groups,
+	const std::map<uint16_t,unsigned int>& unknown)
+{
+	char hex[16];
+	JSONWriter json;
+	json.beginObject();
+	json.value("directory",dir);
+	if(!golden.empty()) json.value("golden",golden);
+	json.value("images",images.size());
+
+	json.beginArray("inventory");
+	for(const auto& g : groups) {
+		json.beginObject();
+		snprintf(hex,sizeof(hex),"0x%.08X",std::get<0>(g.first));
+		json.value("vendor",hex);
+		snprintf(hex,sizeof(hex),"0x%.08X",std::get<1>(g.first));
+		json.value("product",hex);
+		snprintf(hex,sizeof(hex),"0x%.08X",std::get<2>(g.first));
+		json.value("revision",hex);
+		json.value("name",g.second.name);
+		json.value("count",g.second.count);
+		json.value("checksumfailures",g.second.checksumFailures);
+		if(!golden.empty()) json.value("goldendeviations",g.second.deviations);
+		json.value("status","ok");
+		json.endObject();
+	}
+	// Images without a header to group them by, one entry each
+	for(const FleetImage& img : images) {
+		if(NULL == img.error && img.valid) continue;
+		json.beginObject();
+		json.value("file",img.file);
+		json.value("count",1u);
+		json.value("status",fleetError(img));
+		json.endObject();
+	}
+	json.endArray();
+
+	json.beginArray("unknowncategories");
+	for(const auto& u : unknown) {
+		json.beginObject();
+		snprintf(hex,sizeof(hex),"0x%.04X",u.first);
+		json.value("type",hex);
+		json.value("images",u.second);
+		json.endObject();
+	}
+	json.endArray();
+
+	// Only the images that need attention, the rest is in the inventory
+	json.beginArray("issues");
+	for(const FleetImage& img : images) {
+		if(NULL == img.error && img.valid && img.checksumOK && !img.deviates && img.unknown.empty())
+			continue;
+		json.beginObject();
+		json.value("file",img.file);
+		if(NULL != img.error) {
+			json.value("error",img.error);
+		} else if(!img.valid) {
+			json.value("error","invalid header");
+			json.value("size",img.size);
+		} else {
+			json.value("checksum",img.checksumOK);
+			if(!golden.empty()) json.value("deviates",img.deviates);
+			if(!img.unknown.empty()) {
+				json.beginArray("unknowncategories");
+				for(uint16_t t : img.unknown) {
+					snprintf(hex,sizeof(hex),"0x%.04X",t);
+					json.value(NULL,hex);
+				}
+				json.endArray();
+			}
+		}
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	json.write(stdout);
+}
+
+int SII::decodeDirectory(const std::string& dir, const unsigned int jobs,
+	const std::string& golden, const bool json, const bool verbose)
+{
+	std::vector<std::string> files;
+	if(!listImages(dir,files)) return -1;
+
+	MappedFile goldenfile;
+	if(!golden.empty() && !goldenfile.open(golden)) return -1;
+	const ByteSpan goldenspan = goldenfile.span();
+
+	std::vector<FleetImage> images(files.size());
+	for(size_t i = 0; i < files.size(); ++i) images[i].file = files[i];
+
+	parallelFor(images.size(),jobs,[&images,&goldenspan](size_t i) {
+		ScopedTimer timer("Decode image",images[i].file);
+		thread_local std::vector<uint8_t> buf;
+		decodeFleetImage(images[i],goldenspan,buf);
+	});
+
+	// Aggregation is cheap, do it in order so the report is deterministic
+	std::map<std::tuple<uint32_t,uint32_t,uint32_t>,FleetGroup> groups;
+	std::map<uint16_t,unsigned int> unknown;
+	int failed = 0;
+	for(const FleetImage& img : images) {
+		if(NULL != img.error || !img.valid) {
+			if(verbose) fprintf(stderr,"%s: %s\n",img.file.c_str(),fleetError(img));
+			++failed;
+			continue;
+		}
+		FleetGroup& g = groups[std::make_tuple(img.vendor,img.product,img.revision)];
+		if(g.name.empty()) g.name = img.name;
+		++g.count;
+		if(!img.checksumOK) {
+			++g.checksumFailures;
+			++failed;
+			if(verbose) fprintf(stderr,"%s: checksum mismatch\n",img.file.c_str());
+		}
+		if(img.deviates) {
+			++g.deviations;
+			if(verbose) fprintf(stderr,"%s: differs from golden image\n",img.file.c_str());
+		}
+		for(size_t u = 0; u < img.unknown.size(); ++u) {
+			// Count each type once per image
+			if(std::find(img.unknown.begin(),img.unknown.begin()+u,img.unknown[u]) != img.unknown.begin()+u)
+				continue;
+			++g.unknown[img.unknown[u]];
+			++unknown[img.unknown[u]];
+		}
+	}
+
+	if(json) {
+		writeFleetJSON(dir,golden,images,groups,unknown);
+	} else {
+		writeFleetCSV(images,groups);
+	}
+	if(verbose) fprintf(stderr,"Decoded %zu image(s), %d failed\n",images.size(),failed);
+	return failed;
+}
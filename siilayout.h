@@ -0,0 +1,222 @@
+#ifndef SIILAYOUT_H
+#define SIILAYOUT_H
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * Compile time description of the fixed size SII category records. Each
+ * record is a plain struct plus a Layout listing where every member lives
+ * in the little endian EEPROM image. The encoder stores and the reader
+ * loads through the same Layout, so the two can not disagree on offsets.
+ */
+namespace SII {
+
+template<typename T>
+inline T byteSwap(T v) {
+	if constexpr(sizeof(T) == 1) return v;
+	else if constexpr(sizeof(T) == 2) return (T)__builtin_bswap16((uint16_t)v);
+	else return (T)__builtin_bswap32((uint32_t)v);
+}
+
+template<typename T>
+inline void storeLE(uint8_t* p, T v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = byteSwap(v);
+#endif
+	memcpy(p,&v,sizeof(T));
+}
+
+template<typename T>
+inline T loadLE(const uint8_t* p) {
+	T v;
+	memcpy(&v,p,sizeof(T));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = byteSwap(v);
+#endif
+	return v;
+}
+
+/** Member of record R stored at Offset bytes into the record */
+template<auto Member, size_t Offset> struct Field;
+
+template<typename R, typename T, T R::*Member, size_t Offset>
+struct Field<Member,Offset> {
+	static constexpr size_t offset = Offset;
+	static constexpr size_t size = sizeof(T);
+
+	static void store(const R& r, uint8_t* p) { storeLE<T>(p + Offset,r.*Member); };
+	static void load(R& r, const uint8_t* p) { r.*Member = loadLE<T>(p + Offset); };
+};
+
+/**
+ * Record R of Size bytes made of Fields, which have to be listed in
+ * ascending and non-overlapping order. Bytes not covered by a field are
+ * reserved and left untouched by store().
+ */
+template<typename R, size_t Size, typename... Fields>
+struct Layout {
+	typedef R Record;
+	static constexpr size_t SIZE = Size;
+
+	static void store(const R& r, uint8_t* p) { (Fields::store(r,p), ...); };
+	static void load(R& r, const uint8_t* p) { (Fields::load(r,p), ...); };
+	// Load from a possibly short buffer, missing bytes read as 0
+	static R load(const uint8_t* p, size_t len) {
+		R r;
+		if(len >= Size) {
+			load(r,p);
+		} else {
+			uint8_t buf[Size] = {};
+			if(len) memcpy(buf,p,len);
+			load(r,buf);
+		}
+		return r;
+	};
+private:
+	static constexpr bool ordered(void) {
+		const size_t offsets[] = { Fields::offset... };
+		const size_t sizes[] = { Fields::size... };
+		for(size_t i = 0; i < sizeof...(Fields); ++i) {
+			if(offsets[i] + sizes[i] > Size) return false;
+			if(i > 0 && offsets[i-1] + sizes[i-1] > offsets[i]) return false;
+		}
+		return true;
+	};
+	static_assert(ordered(),"SII record fields overlap or exceed the record size");
+};
+
+// Category header, in front of every category payload
+struct CategoryHeaderRecord {
+	uint16_t type = 0;
+	uint16_t sizeW = 0; // Payload size in words
+};
+typedef Layout<CategoryHeaderRecord,4,
+	Field<&CategoryHeaderRecord::type,0>,
+	Field<&CategoryHeaderRecord::sizeW,2>> CategoryHeaderLayout;
+
+// General category (ETG2000 Table 7)
+struct GeneralRecord {
+	uint8_t groupIdx = 0;
+	uint8_t imgIdx = 0;
+	uint8_t orderIdx = 0;
+	uint8_t nameIdx = 0;
+	uint8_t coeDetails = 0;
+	uint8_t foeDetails = 0;
+	uint8_t eoeDetails = 0;
+	uint8_t soeChannels = 0;
+	uint8_t ds402Channels = 0;
+	uint8_t sysmanClass = 0;
+	uint8_t flags = 0;
+	int16_t ebusCurrent = 0;
+	uint8_t groupIdxDup = 0;
+	uint16_t physicalPort = 0;
+	uint16_t physicalMemAddr = 0;
+};
+typedef Layout<GeneralRecord,32,
+	Field<&GeneralRecord::groupIdx,0>,
+	Field<&GeneralRecord::imgIdx,1>,
+	Field<&GeneralRecord::orderIdx,2>,
+	Field<&GeneralRecord::nameIdx,3>,
+	// 4: reserved
+	Field<&GeneralRecord::coeDetails,5>,
+	Field<&GeneralRecord::foeDetails,6>,
+	Field<&GeneralRecord::eoeDetails,7>,
+	Field<&GeneralRecord::soeChannels,8>,
+	Field<&GeneralRecord::ds402Channels,9>,
+	Field<&GeneralRecord::sysmanClass,10>,
+	Field<&GeneralRecord::flags,11>,
+	Field<&GeneralRecord::ebusCurrent,12>,
+	Field<&GeneralRecord::groupIdxDup,14>,
+	// 15: reserved
+	Field<&GeneralRecord::physicalPort,16>,
+	Field<&GeneralRecord::physicalMemAddr,18>
+	// 20-31: reserved
+	> GeneralLayout;
+
+// One byte per FMMU in the FMMU category
+struct FMMURecord {
+	uint8_t usage = 0;
+};
+typedef Layout<FMMURecord,1,
+	Field<&FMMURecord::usage,0>> FMMULayout;
+
+// One SyncManager of the SyncM category
+struct SyncMRecord {
+	uint16_t startAddress = 0;
+	uint16_t length = 0;
+	uint8_t control = 0;
+	uint8_t status = 0;
+	uint8_t enable = 0;
+	uint8_t type = 0;
+};
+typedef Layout<SyncMRecord,8,
+	Field<&SyncMRecord::startAddress,0>,
+	Field<&SyncMRecord::length,2>,
+	Field<&SyncMRecord::control,4>,
+	Field<&SyncMRecord::status,5>,
+	Field<&SyncMRecord::enable,6>,
+	Field<&SyncMRecord::type,7>> SyncMLayout;
+
+// TXPDO/RXPDO category header, followed by entryCount PdoEntryRecords
+struct PdoRecord {
+	uint16_t index = 0;
+	uint8_t entryCount = 0;
+	uint8_t syncManager = 0;
+	uint8_t dc = 0;
+	uint8_t nameIdx = 0;
+	uint16_t flags = 0;
+};
+typedef Layout<PdoRecord,8,
+	Field<&PdoRecord::index,0>,
+	Field<&PdoRecord::entryCount,2>,
+	Field<&PdoRecord::syncManager,3>,
+	Field<&PdoRecord::dc,4>,
+	Field<&PdoRecord::nameIdx,5>,
+	Field<&PdoRecord::flags,6>> PdoLayout;
+
+struct PdoEntryRecord {
+	uint16_t index = 0;
+	uint8_t subindex = 0;
+	uint8_t nameIdx = 0;
+	uint8_t dataType = 0;
+	uint8_t bitLen = 0;
+	uint16_t flags = 0;
+};
+typedef Layout<PdoEntryRecord,8,
+	Field<&PdoEntryRecord::index,0>,
+	Field<&PdoEntryRecord::subindex,2>,
+	Field<&PdoEntryRecord::nameIdx,3>,
+	Field<&PdoEntryRecord::dataType,4>,
+	Field<&PdoEntryRecord::bitLen,5>,
+	Field<&PdoEntryRecord::flags,6>> PdoEntryLayout;
+
+// One opmode of the DC category
+struct DCOpmodeRecord {
+	uint32_t cycleTime0 = 0;
+	uint32_t shiftTime0 = 0;
+	uint32_t shiftTime1 = 0;
+	int16_t sync1CycleFactor = 0;
+	uint16_t assignActivate = 0;
+	int16_t sync0CycleFactor = 0;
+	uint8_t nameIdx = 0;
+	uint8_t descIdx = 0;
+};
+typedef Layout<DCOpmodeRecord,24,
+	Field<&DCOpmodeRecord::cycleTime0,0>,
+	Field<&DCOpmodeRecord::shiftTime0,4>,
+	Field<&DCOpmodeRecord::shiftTime1,8>,
+	Field<&DCOpmodeRecord::sync1CycleFactor,12>,
+	Field<&DCOpmodeRecord::assignActivate,14>,
+	Field<&DCOpmodeRecord::sync0CycleFactor,16>,
+	Field<&DCOpmodeRecord::nameIdx,18>,
+	Field<&DCOpmodeRecord::descIdx,19>
+	// 20-23: reserved
+	> DCOpmodeLayout;
+
+// Category payloads are whole words, odd byte counts get one padding byte
+constexpr uint16_t categoryWords(size_t bytes) { return (uint16_t)((bytes + 1) / 2); }
+
+};
+
+#endif /* SIILAYOUT_H */
@@ -0,0 +1,98 @@
+#include "sii.h"
+
+#include <cstdio>
+#include <string>
+#include "siireader.h"
+#include "jsonwriter.h"
+
+// Length prefix of each record when no fixed record size is given
+#define EC_SII_RECORD_LENGTH_PREFIX_SIZEB	(4)
+
+int SII::decodeEEPROMStream(const std::string& file, const size_t recordsize,
+	const bool verbose, const bool json)
+{
+	MappedFile mapped;
+	// The records are only walked once, front to back
+	if(!mapped.open(file,true)) return -1;
+	ByteSpan data = mapped.span();
+
+	if(!json) {
+		printf("Decoding %s SII records from '%s' (%zu bytes)\n",
+			recordsize ? "fixed size" : "length prefixed",file.c_str(),data.size());
+	} else {
+		printf("[");
+	}
+
+	int position = 0;
+	int failed = 0;
+	size_t offset = 0;
+	while(offset < data.size()) {
+		ByteSpan record;
+		size_t expected = recordsize;
+		if(recordsize) {
+			record = data.sub(offset,recordsize);
+			offset += recordsize;
+		} else {
+			if(!data.has(offset,EC_SII_RECORD_LENGTH_PREFIX_SIZEB)) {
+				// Keep stdout parseable in JSON mode
+				fprintf(json ? stderr : stdout,"Trailing %zu bytes at offset %zu is not a record\n",
+					data.size()-offset,offset);
+				++failed;
+				break;
+			}
+			expected = data.u32(offset);
+			offset += EC_SII_RECORD_LENGTH_PREFIX_SIZEB;
+			record = data.sub(offset,expected);
+			offset += expected;
+		}
+		// Cut short by the end of the file, what is there is still shown
+		bool complete = record.size() == expected;
+		if(!complete) {
+			fprintf(json ? stderr : stdout,"Record %d at offset %zu is malformed, only %zu of %zu bytes present\n",
+				position,(size_t)(record.data() - data.data()),record.size(),expected);
+		}
+
+		Reader reader(record);
+		HeaderView hdr = reader.header();
+		bool ok = complete && hdr.valid() && hdr.checksumOK();
+		if(!ok) ++failed;
+
+		if(json) {
+			JSONWriter out;
+			out.beginObject();
+			out.value("position",position);
+			out.value("offset",(unsigned long)(record.data() - data.data()));
+			if(!complete) out.value("truncated",true);
+			writeEEPROMJSON(reader,out);
+			out.endObject();
+			if(position > 0) printf(",");
+			printf("\n");
+			fwrite(out.str().data(),1,out.str().size(),stdout);
+		} else if(verbose) {
+			printf("==========================\n");
+			printf("Slave position %d (offset %zu, %zu bytes)\n",position,
+				(size_t)(record.data() - data.data()),record.size());
+			printEEPROM(reader,verbose);
+		} else if(complete && hdr.valid()) {
+			std::string_view name;
+			Category general;
+			if(reader.find(EEPROMCategoryGeneral,general))
+				name = reader.strings().string(general.general().nameIdx());
+			printf("%4d: vendor 0x%.08X product 0x%.08X revision 0x%.08X checksum %s '%.*s'\n",
+				position,hdr.vendorId(),hdr.productCode(),hdr.revisionNo(),
+				hdr.checksumOK() ? "\033[0;32mOK\033[0m" : "\033[0;31mMISMATCH\033[0m",
+				(int)name.size(),name.data());
+		} else {
+			printf("%4d: \033[0;31m%s\033[0m record (%zu bytes)\n",position,
+				complete ? "invalid" : "malformed",record.size());
+		}
+		++position;
+	}
+
+	if(json) {
+		printf("\n]\n");
+	} else {
+		printf("Decoded %d record(s), %d failed\n",position,failed);
+	}
+	return failed;
+}
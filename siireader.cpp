@@ -0,0 +1,129 @@
+#include "siireader.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+
+#include "esctoolhelpers.h"
+
+static const size_t EC_SII_CATEGORY_END = (size_t)-1;
+
+SII::MappedFile::~MappedFile() { close(); };
+
+bool SII::MappedFile::open(const std::string& file, const bool sequential) {
+	close();
+	int fd = ::open(file.c_str(), O_RDONLY);
+	if(fd < 0){
+		printf("Could not open '%s'\n",file.c_str());
+		return false;
+	}
+	struct stat statbuf;
+	if(fstat(fd, &statbuf) < 0){
+		printf("Could not stat '%s'\n",file.c_str());
+		::close(fd);
+		return false;
+	}
+	if(0 == statbuf.st_size) {
+		// Nothing to map, an empty span is still valid
+		::close(fd);
+		return true;
+	}
+
+	void* p = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(p == MAP_FAILED){
+		printf("Mapping Failed (%d)\n",errno);
+		return false;
+	}
+	if(sequential) madvise(p, statbuf.st_size, MADV_SEQUENTIAL);
+	m_data = (uint8_t*)p;
+	m_size = statbuf.st_size;
+	return true;
+}
+
+void SII::MappedFile::close(void) {
+	if(NULL != m_data) {
+		if(0 != munmap((void*)m_data, m_size)) printf("UnMapping Failed (%d)\n",errno);
+	}
+	m_data = NULL;
+	m_size = 0;
+}
+
+uint8_t SII::HeaderView::calculatedChecksum(void) const {
+	if(!m.has(0,EC_SII_CONFIGDATA_CHECKSUM_OFFSET_BYTE)) return 0;
+	return crc8(m.data(),EC_SII_CONFIGDATA_CHECKSUM_OFFSET_BYTE);
+}
+
+std::string_view SII::StringsView::string(uint8_t index) const {
+	if(0 == index || index > count()) return std::string_view();
+	size_t offset = 1;
+	for(uint8_t s = 1; s < index; ++s) offset += 1 + m.u8(offset);
+	ByteSpan str = m.sub(offset + 1,m.u8(offset));
+	return std::string_view((const char*)str.data(),str.size());
+}
+
+size_t SII::PdoView::entries(void) const {
+	size_t present = m.size() > HEADER_SIZE ? (m.size() - HEADER_SIZE) / PdoEntryView::SIZE : 0;
+	return std::min((size_t)entryCount(),present);
+}
+
+SII::Reader::Iterator::Iterator(const ByteSpan* image, size_t offset) :
+	m_image(image), m_offset(offset)
+{
+	load();
+}
+
+void SII::Reader::Iterator::load(void) {
+	if(EC_SII_CATEGORY_END == m_offset) return;
+	if(!m_image->has(m_offset,CategoryHeaderLayout::SIZE)) {
+		m_offset = EC_SII_CATEGORY_END;
+		return;
+	}
+	CategoryHeaderRecord hdr;
+	CategoryHeaderLayout::load(hdr,m_image->data() + m_offset);
+	m_cat.type = hdr.type;
+	if(EEPROMCategoryNOP == m_cat.type || 0xFFFF == m_cat.type) {
+		m_offset = EC_SII_CATEGORY_END;
+		return;
+	}
+	m_cat.sizeW = hdr.sizeW;
+	m_cat.offset = m_offset;
+	m_cat.truncated = !m_image->has(m_offset+CategoryHeaderLayout::SIZE,m_cat.sizeW*2);
+	m_cat.payload = m_image->sub(m_offset+CategoryHeaderLayout::SIZE,m_cat.sizeW*2);
+}
+
+SII::Reader::Iterator& SII::Reader::Iterator::operator++(void) {
+	if(EC_SII_CATEGORY_END == m_offset) return *this;
+	if(m_cat.truncated) m_offset = EC_SII_CATEGORY_END;
+	else m_offset += CategoryHeaderLayout::SIZE + m_cat.sizeW*2;
+	load();
+	return *this;
+}
+
+SII::Reader::Iterator SII::Reader::begin(void) const {
+	return Iterator(&m_image,valid() ? EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE : EC_SII_CATEGORY_END);
+}
+
+SII::Reader::Iterator SII::Reader::end(void) const {
+	return Iterator(&m_image,EC_SII_CATEGORY_END);
+}
+
+bool SII::Reader::find(uint16_t type, Category& cat) const {
+	for(const Category& c : *this) {
+		if(c.type == type) {
+			cat = c;
+			return true;
+		}
+	}
+	return false;
+}
+
+SII::StringsView SII::Reader::strings(void) const {
+	Category cat;
+	if(find(EEPROMCategorySTRINGS,cat)) return cat.strings();
+	return StringsView();
+}
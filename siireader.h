@@ -0,0 +1,300 @@
+#ifndef SIIREADER_H
+#define SIIREADER_H
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "esidefs.h"
+#include "siilayout.h"
+
+namespace SII {
+
+/**
+ * Non-owning, bounds checked view of a range of bytes. All multi byte
+ * reads are little endian (as stored in the EEPROM) and reads outside the
+ * range return 0, so a corrupted image can never make a view read past
+ * the end of the underlying buffer.
+ */
+class ByteSpan {
+public:
+	ByteSpan(const uint8_t* data = NULL, size_t size = 0) :
+		m_data(data), m_size(data ? size : 0) {};
+
+	const uint8_t* data(void) const { return m_data; };
+	size_t size(void) const { return m_size; };
+	bool empty(void) const { return 0 == m_size; };
+	bool has(size_t offset, size_t len) const {
+		return offset <= m_size && len <= m_size - offset;
+	};
+
+	uint8_t u8(size_t offset) const {
+		return has(offset,1) ? m_data[offset] : 0;
+	};
+	uint16_t u16(size_t offset) const {
+		return has(offset,2) ? (uint16_t)(m_data[offset] | (m_data[offset+1] << 8)) : 0;
+	};
+	uint32_t u32(size_t offset) const {
+		return has(offset,4) ? ((uint32_t)m_data[offset] |
+			((uint32_t)m_data[offset+1] << 8) |
+			((uint32_t)m_data[offset+2] << 16) |
+			((uint32_t)m_data[offset+3] << 24)) : 0;
+	};
+	int16_t i16(size_t offset) const { return (int16_t)u16(offset); };
+
+	// Sub range, clamped to the bounds of this span
+	ByteSpan sub(size_t offset, size_t len) const {
+		if(offset > m_size) return ByteSpan();
+		if(len > m_size - offset) len = m_size - offset;
+		return ByteSpan(m_data + offset, len);
+	};
+private:
+	const uint8_t* m_data;
+	size_t m_size;
+};
+
+/** Read-only memory mapping of a file, unmapped on destruction */
+class MappedFile {
+public:
+	MappedFile() : m_data(NULL), m_size(0) {};
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Returns false (and prints why) if the file could not be mapped
+	bool open(const std::string& file, const bool sequential = false);
+	void close(void);
+	ByteSpan span(void) const { return ByteSpan(m_data,m_size); };
+private:
+	uint8_t* m_data;
+	size_t m_size;
+};
+
+/** Fixed area in front of the categories (ETG2010 Table 2) */
+class HeaderView {
+public:
+	HeaderView(ByteSpan s = ByteSpan()) : m(s) {};
+	bool valid(void) const { return m.has(0,EC_SII_EEPROM_FIRST_CAT_HDR_OFFSET_BYTE); };
+	ByteSpan configData(void) const { return m.sub(0,EC_SII_CONFIGDATA_SIZEB); };
+	uint8_t checksum(void) const { return m.u8(EC_SII_CONFIGDATA_CHECKSUM_OFFSET_BYTE); };
+	uint8_t calculatedChecksum(void) const;
+	bool checksumOK(void) const { return valid() && checksum() == calculatedChecksum(); };
+	uint32_t vendorId(void) const { return m.u32(EC_SII_EEPROM_VENDOR_OFFSET_BYTE); };
+	uint32_t productCode(void) const { return m.u32(EC_SII_EEPROM_VENDOR_OFFSET_BYTE+4); };
+	uint32_t revisionNo(void) const { return m.u32(EC_SII_EEPROM_VENDOR_OFFSET_BYTE+8); };
+	uint32_t serialNo(void) const { return m.u32(EC_SII_EEPROM_VENDOR_OFFSET_BYTE+12); };
+	uint16_t mailboxOutOffset(void) const { return m.u16(EC_SII_EEPROM_MAILBOX_OUT_OFFSET_BYTE); };
+	uint16_t mailboxOutSize(void) const { return m.u16(EC_SII_EEPROM_MAILBOX_OUT_OFFSET_BYTE+2); };
+	uint16_t mailboxInOffset(void) const { return m.u16(EC_SII_EEPROM_MAILBOX_IN_OFFSET_BYTE); };
+	uint16_t mailboxInSize(void) const { return m.u16(EC_SII_EEPROM_MAILBOX_IN_OFFSET_BYTE+2); };
+	uint16_t mailboxProtocol(void) const { return m.u16(EC_SII_EEPROM_MAILBOX_PROTO_OFFSET_BYTE); };
+	uint16_t eepromSize(void) const { return m.u16(EC_SII_EEPROM_SIZE_OFFSET_BYTE); };
+	uint16_t version(void) const { return m.u16(EC_SII_EEPROM_VERSION_OFFSET_BYTE); };
+private:
+	ByteSpan m;
+};
+
+/** STRINGS category (ETG2000 Table 6), strings are indexed from 1 */
+class StringsView {
+public:
+	StringsView(ByteSpan s = ByteSpan()) : m(s) {};
+	uint8_t count(void) const { return m.u8(0); };
+	// Empty view if index is 0 or out of range
+	std::string_view string(uint8_t index) const;
+private:
+	ByteSpan m;
+};
+
+/*
+ * The record views below (General, SyncM entry, PDO, PDO entry and DC
+ * opmode) copy their record out of the span through its Layout when they
+ * are constructed, the accessors then read that copy. The records are at
+ * most 32 bytes and each field is decoded once, however often it is read.
+ */
+
+/** General category (ETG2000 Table 7) */
+class GeneralView {
+public:
+	GeneralView(ByteSpan s = ByteSpan()) : r(GeneralLayout::load(s.data(),s.size())) {};
+	const GeneralRecord& record(void) const { return r; };
+	uint8_t groupIdx(void) const { return r.groupIdx; };
+	uint8_t imgIdx(void) const { return r.imgIdx; };
+	uint8_t orderIdx(void) const { return r.orderIdx; };
+	uint8_t nameIdx(void) const { return r.nameIdx; };
+	uint8_t coeDetails(void) const { return r.coeDetails; };
+	uint8_t foeDetails(void) const { return r.foeDetails; };
+	uint8_t eoeDetails(void) const { return r.eoeDetails; };
+	uint8_t soeChannels(void) const { return r.soeChannels; };
+	uint8_t ds402Channels(void) const { return r.ds402Channels; };
+	uint8_t sysmanClass(void) const { return r.sysmanClass; };
+	uint8_t flags(void) const { return r.flags; };
+	int16_t ebusCurrent(void) const { return r.ebusCurrent; };
+	uint8_t groupIdxDup(void) const { return r.groupIdxDup; };
+	uint16_t physicalPort(void) const { return r.physicalPort; };
+	uint16_t physicalMemAddr(void) const { return r.physicalMemAddr; };
+private:
+	GeneralRecord r;
+};
+
+/** FMMU category, one configuration byte per FMMU */
+class FMMUView {
+public:
+	FMMUView(ByteSpan s = ByteSpan()) : m(s) {};
+	size_t count(void) const { return m.size() / FMMULayout::SIZE; };
+	uint8_t config(size_t fmmu) const {
+		ByteSpan e = m.sub(fmmu * FMMULayout::SIZE,FMMULayout::SIZE);
+		return FMMULayout::load(e.data(),e.size()).usage;
+	};
+private:
+	ByteSpan m;
+};
+
+/** Single SyncManager element of the SyncM category */
+class SyncMEntryView {
+public:
+	static const size_t SIZE = SyncMLayout::SIZE;
+	SyncMEntryView(ByteSpan s = ByteSpan()) : r(SyncMLayout::load(s.data(),s.size())) {};
+	const SyncMRecord& record(void) const { return r; };
+	uint16_t startAddress(void) const { return r.startAddress; };
+	uint16_t length(void) const { return r.length; };
+	uint8_t control(void) const { return r.control; };
+	uint8_t status(void) const { return r.status; };
+	uint8_t enable(void) const { return r.enable; };
+	uint8_t type(void) const { return r.type; };
+private:
+	SyncMRecord r;
+};
+
+class SyncMView {
+public:
+	SyncMView(ByteSpan s = ByteSpan()) : m(s) {};
+	size_t count(void) const { return m.size() / SyncMEntryView::SIZE; };
+	SyncMEntryView sm(size_t n) const {
+		return SyncMEntryView(m.sub(n * SyncMEntryView::SIZE,SyncMEntryView::SIZE));
+	};
+private:
+	ByteSpan m;
+};
+
+/** Single entry of a TXPDO/RXPDO category */
+class PdoEntryView {
+public:
+	static const size_t SIZE = PdoEntryLayout::SIZE;
+	PdoEntryView(ByteSpan s = ByteSpan()) : r(PdoEntryLayout::load(s.data(),s.size())) {};
+	const PdoEntryRecord& record(void) const { return r; };
+	uint16_t index(void) const { return r.index; };
+	uint8_t subindex(void) const { return r.subindex; };
+	uint8_t nameIdx(void) const { return r.nameIdx; };
+	uint8_t dataType(void) const { return r.dataType; };
+	uint8_t bitLen(void) const { return r.bitLen; };
+	uint16_t flags(void) const { return r.flags; };
+private:
+	PdoEntryRecord r;
+};
+
+/** TXPDO/RXPDO category (one PDO per category), keeps the span for the entries */
+class PdoView {
+public:
+	static const size_t HEADER_SIZE = PdoLayout::SIZE;
+	PdoView(ByteSpan s = ByteSpan()) : m(s), r(PdoLayout::load(s.data(),s.size())) {};
+	const PdoRecord& record(void) const { return r; };
+	uint16_t index(void) const { return r.index; };
+	uint8_t entryCount(void) const { return r.entryCount; };
+	uint8_t syncManager(void) const { return r.syncManager; };
+	uint8_t dc(void) const { return r.dc; };
+	uint8_t nameIdx(void) const { return r.nameIdx; };
+	uint16_t flags(void) const { return r.flags; };
+	// Number of entries actually present (never more than the category holds)
+	size_t entries(void) const;
+	PdoEntryView entry(size_t n) const {
+		return PdoEntryView(m.sub(HEADER_SIZE + n * PdoEntryView::SIZE,PdoEntryView::SIZE));
+	};
+private:
+	ByteSpan m;
+	PdoRecord r;
+};
+
+/** Single opmode of the DC category */
+class DCOpmodeView {
+public:
+	static const size_t SIZE = DCOpmodeLayout::SIZE;
+	DCOpmodeView(ByteSpan s = ByteSpan()) : r(DCOpmodeLayout::load(s.data(),s.size())) {};
+	const DCOpmodeRecord& record(void) const { return r; };
+	uint32_t cycleTime0(void) const { return r.cycleTime0; };
+	uint32_t shiftTime0(void) const { return r.shiftTime0; };
+	uint32_t shiftTime1(void) const { return r.shiftTime1; };
+	int16_t sync1CycleFactor(void) const { return r.sync1CycleFactor; };
+	uint16_t assignActivate(void) const { return r.assignActivate; };
+	int16_t sync0CycleFactor(void) const { return r.sync0CycleFactor; };
+	uint8_t nameIdx(void) const { return r.nameIdx; };
+	uint8_t descIdx(void) const { return r.descIdx; };
+private:
+	DCOpmodeRecord r;
+};
+
+class DCView {
+public:
+	DCView(ByteSpan s = ByteSpan()) : m(s) {};
+	size_t count(void) const { return m.size() / DCOpmodeView::SIZE; };
+	DCOpmodeView opmode(size_t n) const {
+		return DCOpmodeView(m.sub(n * DCOpmodeView::SIZE,DCOpmodeView::SIZE));
+	};
+private:
+	ByteSpan m;
+};
+
+/** A category as found in the image, payload excludes the 4 byte header */
+struct Category {
+	uint16_t type = EEPROMCategoryNOP;
+	uint16_t sizeW = 0;
+	size_t offset = 0; // Byte offset of the category header in the image
+	bool truncated = false; // Declared size extends past the end of the image
+	ByteSpan payload;
+
+	StringsView strings(void) const { return StringsView(payload); };
+	GeneralView general(void) const { return GeneralView(payload); };
+	FMMUView fmmu(void) const { return FMMUView(payload); };
+	SyncMView syncm(void) const { return SyncMView(payload); };
+	PdoView pdo(void) const { return PdoView(payload); };
+	DCView dc(void) const { return DCView(payload); };
+};
+
+/**
+ * Walks the categories of a SII image without copying anything, eg.
+ *
+ *	SII::Reader reader(span);
+ *	for(const SII::Category& cat : reader) { ... }
+ */
+class Reader {
+public:
+	class Iterator {
+	public:
+		Iterator(const ByteSpan* image, size_t offset);
+		const Category& operator*(void) const { return m_cat; };
+		const Category* operator->(void) const { return &m_cat; };
+		Iterator& operator++(void);
+		bool operator!=(const Iterator& o) const { return m_offset != o.m_offset; };
+	private:
+		void load(void);
+		const ByteSpan* m_image;
+		size_t m_offset;
+		Category m_cat;
+	};
+
+	Reader(ByteSpan image = ByteSpan()) : m_image(image) {};
+	const ByteSpan& image(void) const { return m_image; };
+	HeaderView header(void) const { return HeaderView(m_image); };
+	bool valid(void) const { return header().valid(); };
+	Iterator begin(void) const;
+	Iterator end(void) const;
+
+	// First category of the given type, false if not present
+	bool find(uint16_t type, Category& cat) const;
+	// Strings of the (first) STRINGS category, empty view if none
+	StringsView strings(void) const;
+private:
+	ByteSpan m_image;
+};
+
+};
+
+#endif /* SIIREADER_H */
@@ -0,0 +1,238 @@
+#include "sii.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "siireader.h"
+#include "esctoolhelpers.h"
+
+/** Collects the mismatches between the decoded image and the Device model */
+class RoundtripCheck {
+public:
+	RoundtripCheck(const bool verbose) : m_verbose(verbose), m_failed(0) {};
+
+	void field(const char* where, uint32_t expected, uint32_t actual) {
+		if(expected != actual) {
+			printf("\033[0;31mMISMATCH\033[0m %s: expected 0x%X, decoded 0x%X\n",where,expected,actual);
+			++m_failed;
+		} else if(m_verbose) {
+			printf("%s: 0x%X\n",where,actual);
+		}
+	};
+	void string(const char* where, const char* expected, std::string_view actual) {
+		if(NULL == expected) expected = "";
+		if(actual != expected) {
+			printf("\033[0;31mMISMATCH\033[0m %s: expected '%s', decoded '%.*s'\n",where,expected,
+				(int)actual.size(),actual.data());
+			++m_failed;
+		} else if(m_verbose) {
+			printf("%s: '%s'\n",where,expected);
+		}
+	};
+	void fail(const char* what) {
+		printf("\033[0;31mMISMATCH\033[0m %s\n",what);
+		++m_failed;
+	};
+	int failed(void) const { return m_failed; };
+private:
+	bool m_verbose;
+	int m_failed;
+};
+
+// Next category of the given type, starting after the one at offset (0 for the first)
+static bool nextCategory(const SII::Reader& reader, uint16_t type, size_t after, SII::Category& cat)
+{
+	for(const SII::Category& c : reader) {
+		if(c.type == type && c.offset > after) {
+			cat = c;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void verifyPdos(const SII::Reader& reader, uint16_t type, const std::list<Pdo*>& pdos,
+	RoundtripCheck& check)
+{
+	const char* name = getCategoryString(type);
+	char where[64];
+	size_t after = 0;
+	size_t n = 0;
+	for(Pdo* pdo : pdos) {
+		SII::Category cat;
+		if(!nextCategory(reader,type,after,cat)) {
+			snprintf(where,sizeof(where),"%s %zu missing",name,n);
+			check.fail(where);
+			return;
+		}
+		after = cat.offset;
+
+		SII::PdoView view = cat.pdo();
+		snprintf(where,sizeof(where),"%s %zu index",name,n);
+		check.field(where,pdo->index & 0xFFFF,view.index());
+		snprintf(where,sizeof(where),"%s %zu syncmanager",name,n);
+		check.field(where,pdo->syncmanager & 0xFF,view.syncManager());
+		snprintf(where,sizeof(where),"%s %zu flags",name,n);
+		check.field(where,getPdoFlags(pdo),view.flags());
+		snprintf(where,sizeof(where),"%s %zu entries",name,n);
+		check.field(where,pdo->entries.size(),view.entries());
+
+		size_t e = 0;
+		for(PdoEntry* entry : pdo->entries) {
+			if(e >= view.entries()) break;
+			SII::PdoEntryView ev = view.entry(e);
+			snprintf(where,sizeof(where),"%s %zu entry %zu index",name,n,e);
+			check.field(where,entry->index & 0xFFFF,ev.index());
+			snprintf(where,sizeof(where),"%s %zu entry %zu subindex",name,n,e);
+			check.field(where,entry->subindex & 0xFF,ev.subindex());
+			snprintf(where,sizeof(where),"%s %zu entry %zu datatype",name,n,e);
+			check.field(where,getCoEDataType(entry->datatype),ev.dataType());
+			snprintf(where,sizeof(where),"%s %zu entry %zu bitlen",name,n,e);
+			check.field(where,entry->bitlen & 0xFF,ev.bitLen());
+			++e;
+		}
+		++n;
+	}
+	SII::Category extra;
+	if(nextCategory(reader,type,after,extra)) {
+		snprintf(where,sizeof(where),"unexpected %s at offset 0x%zX",name,extra.offset);
+		check.fail(where);
+	}
+}
+
+bool SII::verifyRoundtrip(const std::vector<uint8_t>& eeprom, uint32_t vendor_id, const Device* dev,
+	const bool encodepdo, const bool verbose)
+{
+	Reader reader(ByteSpan(eeprom.data(),eeprom.size()));
+	HeaderView hdr = reader.header();
+	RoundtripCheck check(verbose);
+	char where[64];
+
+	// Header
+	ByteSpan configdata = hdr.configData();
+	for(uint8_t i = 0; i < EC_SII_CONFIGDATA_SIZEB; ++i) {
+		if(configdata.u8(i) != dev->configdata[i]) {
+			snprintf(where,sizeof(where),"ConfigData byte %u",i);
+			check.field(where,dev->configdata[i],configdata.u8(i));
+		}
+	}
+	check.field("ConfigData checksum",hdr.calculatedChecksum(),hdr.checksum());
+	check.field("Vendor ID",vendor_id,hdr.vendorId());
+	check.field("Product code",dev->product_code,hdr.productCode());
+	check.field("Revision",dev->revision_no,hdr.revisionNo());
+	for(SyncManager* sm : dev->syncmanagers) {
+		if(0 == strcmp(sm->type,"MBoxOut")) {
+			check.field("Mailbox out offset",sm->startaddress,hdr.mailboxOutOffset());
+			check.field("Mailbox out size",sm->defaultsize,hdr.mailboxOutSize());
+		} else
+		if(0 == strcmp(sm->type,"MBoxIn")) {
+			check.field("Mailbox in offset",sm->startaddress,hdr.mailboxInOffset());
+			check.field("Mailbox in size",sm->defaultsize,hdr.mailboxInSize());
+		}
+	}
+	check.field("Mailbox protocol",getMailboxProtocols(dev->mailbox),hdr.mailboxProtocol());
+	check.field("Version",EC_SII_VERSION,hdr.version());
+
+	// STRINGS and General
+	StringsView strings = reader.strings();
+	Category general;
+	if(!reader.find(EEPROMCategoryGeneral,general)) {
+		check.fail("General category missing");
+	} else {
+		GeneralView gen = general.general();
+		check.string("Group",dev->group ? dev->group->type : "(empty-group-name)",
+			strings.string(gen.groupIdx()));
+		check.string("Name",dev->name ? dev->name : "(empty-device-name)",
+			strings.string(gen.nameIdx()));
+
+		check.field("CoE details",getCoEDetails(dev->mailbox),gen.coeDetails());
+		check.field("FoE details",dev->mailbox && dev->mailbox->foe ? 0x1 : 0x0,gen.foeDetails());
+		check.field("EoE details",dev->mailbox && dev->mailbox->eoe ? 0x1 : 0x0,gen.eoeDetails());
+		check.field("Flags",getGeneralFlags(dev->mailbox),gen.flags());
+		check.field("Physical port",getPhysicalPortConfig(dev->physics),gen.physicalPort());
+	}
+
+	// FMMU
+	Category cat;
+	if(!dev->fmmus.empty()) {
+		if(!reader.find(EEPROMCategoryFMMU,cat)) {
+			check.fail("FMMU category missing");
+		} else {
+			FMMUView fmmu = cat.fmmu();
+			size_t n = 0;
+			for(FMMU* f : dev->fmmus) {
+				snprintf(where,sizeof(where),"FMMU %zu",n);
+				check.field(where,getFMMUType(f->type),fmmu.config(n));
+				++n;
+			}
+		}
+	}
+
+	// SyncM
+	if(!dev->syncmanagers.empty()) {
+		if(!reader.find(EEPROMCategorySyncM,cat)) {
+			check.fail("SyncM category missing");
+		} else {
+			SyncMView syncm = cat.syncm();
+			check.field("SyncM count",dev->syncmanagers.size(),syncm.count());
+			size_t n = 0;
+			for(SyncManager* sm : dev->syncmanagers) {
+				if(n >= syncm.count()) break;
+				SyncMEntryView v = syncm.sm(n);
+				snprintf(where,sizeof(where),"SM%zu start address",n);
+				check.field(where,sm->startaddress,v.startAddress());
+				snprintf(where,sizeof(where),"SM%zu length",n);
+				check.field(where,sm->defaultsize,v.length());
+				snprintf(where,sizeof(where),"SM%zu control",n);
+				check.field(where,sm->controlbyte,v.control());
+				snprintf(where,sizeof(where),"SM%zu enable",n);
+				check.field(where,sm->enable ? 0x1 : 0x0,v.enable());
+				snprintf(where,sizeof(where),"SM%zu type",n);
+				check.field(where,getSyncManagerType(sm->type),v.type());
+				++n;
+			}
+		}
+	}
+
+	// PDOs
+	if(encodepdo) {
+		verifyPdos(reader,EEPROMCategoryTXPDO,dev->txpdo,check);
+		verifyPdos(reader,EEPROMCategoryRXPDO,dev->rxpdo,check);
+	}
+
+	// DC
+	if(dev->dc) {
+		if(!reader.find(EEPROMCategoryDC,cat)) {
+			check.fail("DC category missing");
+		} else {
+			DCView dc = cat.dc();
+			check.field("DC opmodes",dev->dc->opmodes.size(),dc.count());
+			size_t n = 0;
+			for(DcOpmode* op : dev->dc->opmodes) {
+				if(n >= dc.count()) break;
+				DCOpmodeView v = dc.opmode(n);
+				snprintf(where,sizeof(where),"DC opmode %zu cycle time 0",n);
+				check.field(where,op->cycletimesync0,v.cycleTime0());
+				snprintf(where,sizeof(where),"DC opmode %zu shift time 0",n);
+				check.field(where,op->shifttimesync0,v.shiftTime0());
+				snprintf(where,sizeof(where),"DC opmode %zu shift time 1",n);
+				check.field(where,op->shifttimesync1,v.shiftTime1());
+				snprintf(where,sizeof(where),"DC opmode %zu sync1 factor",n);
+				check.field(where,(uint16_t)op->cycletimesync1factor,(uint16_t)v.sync1CycleFactor());
+				snprintf(where,sizeof(where),"DC opmode %zu assign activate",n);
+				check.field(where,op->assignactivate,v.assignActivate());
+				snprintf(where,sizeof(where),"DC opmode %zu sync0 factor",n);
+				check.field(where,(uint16_t)op->cycletimesync0factor,(uint16_t)v.sync0CycleFactor());
+				++n;
+			}
+		}
+	}
+
+	if(check.failed()) {
+		printf("Round-trip verification \033[0;31mFAILED\033[0m (%d mismatches)\n",check.failed());
+		return false;
+	}
+	printf("Round-trip verification \033[0;32mOK\033[0m\n");
+	return true;
+}
@@ -0,0 +1,403 @@
+#include "socketserver.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <iterator>
+#include <thread>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "esctoolhelpers.h"
+#include "esixmlparsing.h"
+#include "objectdictionary.h"
+#include "outputsink.h"
+#include "profiler.h"
+#include "runstats.h"
+#include "sii.h"
+#include "soesconfigwriter.h"
+
+// Larger requests are refused rather than allocated
+#define SOCKETSERVER_MAX_REQUEST	(256*1024*1024)
+#define SOCKETSERVER_VERSION		1
+
+struct SocketServer::Model {
+	std::unique_ptr<ESIXML> esixml;
+	std::vector<char*> strings; // Synthesized names, freed with the model
+	std::string contents; // ESI sent as bytes, to rule out hash collisions
+	~Model() { for(char* s : strings) delete[] s; };
+};
+
+struct SocketServer::Request {
+	uint8_t source = 0;
+	uint16_t flags = 0;
+	uint8_t selector = 0;
+	uint32_t device = 0;
+	std::string esi; // Path or contents
+	std::string name;
+	std::string output;
+};
+
+namespace {
+
+bool readFull(int fd, void* buf, size_t len) {
+	uint8_t* p = (uint8_t*)buf;
+	while(len > 0) {
+		ssize_t n = read(fd,p,len);
+		if(n < 0 && errno == EINTR) continue;
+		if(n <= 0) return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+bool writeFull(int fd, const void* buf, size_t len) {
+	const uint8_t* p = (const uint8_t*)buf;
+	while(len > 0) {
+		ssize_t n = send(fd,p,len,MSG_NOSIGNAL);
+		if(n < 0 && errno == EINTR) continue;
+		if(n <= 0) return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+/** Bounds checked reading of a request body */
+class RequestReader {
+public:
+	RequestReader(const std::vector<uint8_t>& data) : m_data(data), m_pos(0) {};
+	bool u8(uint8_t& v) {
+		if(m_pos + 1 > m_data.size()) return false;
+		v = m_data[m_pos++];
+		return true;
+	};
+	bool u16(uint16_t& v) {
+		if(m_pos + 2 > m_data.size()) return false;
+		v = m_data[m_pos] | (m_data[m_pos + 1] << 8);
+		m_pos += 2;
+		return true;
+	};
+	bool u32(uint32_t& v) {
+		if(m_pos + 4 > m_data.size()) return false;
+		v = m_data[m_pos] | (m_data[m_pos + 1] << 8) | (m_data[m_pos + 2] << 16) |
+			((uint32_t)m_data[m_pos + 3] << 24);
+		m_pos += 4;
+		return true;
+	};
+	bool str(std::string& s) {
+		uint32_t len;
+		if(!u32(len) || len > m_data.size() - m_pos) return false;
+		s.assign((const char*)m_data.data() + m_pos,len);
+		m_pos += len;
+		return true;
+	};
+	bool done(void) const { return m_pos == m_data.size(); };
+private:
+	const std::vector<uint8_t>& m_data;
+	size_t m_pos;
+};
+
+void putU32(std::string& out, uint32_t v) {
+	for(int i = 0; i < 4; ++i) out += (char)((v >> (8*i)) & 0xFF);
+}
+
+void putStr(std::string& out, const std::string& s) {
+	putU32(out,s.size());
+	out += s;
+}
+
+// FNV-1a, to recognize ESI contents sent again
+uint64_t hash(const std::string& data) {
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for(unsigned char c : data) {
+		h ^= c;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+std::string failed(const std::string& error) {
+	std::string response(1,'\x01');
+	putStr(response,error);
+	return response;
+}
+
+};
+
+SocketServer::SocketServer(const std::string& path, const unsigned int workers,
+	const size_t cachesize, const int verbosity)
+	: m_path(path), m_workers(workers), m_cachesize(cachesize ? cachesize : 1),
+	m_verbosity(verbosity), m_fd(-1)
+{
+	if(0 == m_workers) m_workers = std::thread::hardware_concurrency();
+	if(0 == m_workers) m_workers = 1;
+}
+
+SocketServer::~SocketServer() {
+	if(m_fd >= 0) {
+		close(m_fd);
+		unlink(m_path.c_str());
+	}
+}
+
+bool SocketServer::run(void) {
+	// Serves until stopped, so nothing would ever report what the requests record
+	Profiler::instance().enable(false);
+	RunStats::instance().recordOutputs(false);
+
+	struct sockaddr_un addr;
+	memset(&addr,0,sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(m_path.empty() || m_path.size() >= sizeof(addr.sun_path)) {
+		printf("\033[0;31mERROR:\033[0m Socket path '%s' is empty or too long\n",m_path.c_str());
+		return false;
+	}
+	strcpy(addr.sun_path,m_path.c_str());
+
+	// A socket left behind by an earlier server is replaced, anything else is not
+	struct stat st;
+	if(lstat(m_path.c_str(),&st) == 0) {
+		if(!S_ISSOCK(st.st_mode)) {
+			printf("\033[0;31mERROR:\033[0m '%s' exists and is not a socket\n",m_path.c_str());
+			return false;
+		}
+		int probe = socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC,0);
+		bool live = probe >= 0 && connect(probe,(struct sockaddr*)&addr,sizeof(addr)) == 0;
+		if(probe >= 0) close(probe);
+		if(live) {
+			printf("\033[0;31mERROR:\033[0m Another server is already listening on '%s'\n",m_path.c_str());
+			return false;
+		}
+		unlink(m_path.c_str());
+	}
+
+	m_fd = socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC,0);
+	if(m_fd < 0 || bind(m_fd,(struct sockaddr*)&addr,sizeof(addr)) != 0 || listen(m_fd,SOMAXCONN) != 0) {
+		printf("\033[0;31mERROR:\033[0m Could not listen on '%s' (%s)\n",m_path.c_str(),strerror(errno));
+		if(m_fd >= 0) close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+
+	printf("Serving on '%s' with %u worker(s), caching up to %zu model(s)\n",
+		m_path.c_str(),m_workers,m_cachesize);
+	fflush(stdout);
+
+	std::vector<std::thread> threads;
+	for(unsigned int t = 0; t < m_workers; ++t) threads.emplace_back(&SocketServer::worker,this);
+	for(;;) {
+		int client = accept4(m_fd,NULL,NULL,SOCK_CLOEXEC);
+		if(client < 0) {
+			if(errno == EINTR || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE) continue;
+			printf("\033[0;31mERROR:\033[0m accept on '%s' failed (%s)\n",m_path.c_str(),strerror(errno));
+			break;
+		}
+		std::lock_guard<std::mutex> guard(m_queuelock);
+		m_queue.push_back(client);
+		m_queuecond.notify_one();
+	}
+	// Let the workers finish what they have, then stop them
+	{
+		std::lock_guard<std::mutex> guard(m_queuelock);
+		m_queue.push_back(-1);
+		m_queuecond.notify_all();
+	}
+	for(std::thread& t : threads) t.join();
+	return true;
+}
+
+void SocketServer::worker(void) {
+	for(;;) {
+		int fd;
+		{
+			std::unique_lock<std::mutex> guard(m_queuelock);
+			m_queuecond.wait(guard,[this]() { return !m_queue.empty(); });
+			fd = m_queue.front();
+			if(fd < 0) return; // Left in the queue for the other workers
+			m_queue.pop_front();
+		}
+		serve(fd);
+		close(fd);
+	}
+}
+
+void SocketServer::serve(int fd) {
+	std::vector<uint8_t> request;
+	std::string response;
+	for(;;) {
+		uint8_t header[4];
+		if(!readFull(fd,header,sizeof(header))) return; // Closed by the client
+		uint32_t len = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+		if(len > SOCKETSERVER_MAX_REQUEST) {
+			response = failed("request too large");
+		} else {
+			request.resize(len);
+			if(!readFull(fd,request.data(),len)) return;
+			handle(request,response);
+		}
+		std::string frame;
+		putU32(frame,response.size());
+		if(!writeFull(fd,frame.data(),frame.size()) || !writeFull(fd,response.data(),response.size()))
+			return;
+		if(len > SOCKETSERVER_MAX_REQUEST) return; // The rest of it can not be skipped sensibly
+	}
+}
+
+std::shared_ptr<SocketServer::Model> SocketServer::model(const Request& req, std::string& error) {
+	std::string key;
+	if(req.source == 0) {
+		struct stat st;
+		if(stat(req.esi.c_str(),&st) != 0) {
+			error = "could not open '" + req.esi + "' (" + strerror(errno) + ")";
+			return NULL;
+		}
+		key = "p:" + req.esi + ":" + std::to_string(st.st_size) + ":" +
+			std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec) + ":" +
+			std::to_string(st.st_ino);
+	} else {
+		char h[17];
+		snprintf(h,sizeof(h),"%016llx",(unsigned long long)hash(req.esi));
+		key = std::string("b:") + h + ":" + std::to_string(req.esi.size());
+	}
+	// Synthesizing changes the devices, so those models are kept apart
+	const bool dictionary = req.flags & FlagDictionary;
+	if(dictionary) key += ":d";
+
+	{
+		std::lock_guard<std::mutex> guard(m_cachelock);
+		auto found = m_cache.find(key);
+		if(found != m_cache.end() && found->second->second->contents == (req.source == 0 ? "" : req.esi)) {
+			m_lru.splice(m_lru.begin(),m_lru,found->second);
+			return found->second->second;
+		}
+	}
+
+	// Parsed outside the cache lock, a model parsed twice at the same time
+	// is harmless and only the first one is kept
+	std::shared_ptr<Model> model(new Model);
+	model->esixml.reset(new ESIXML(m_verbosity));
+	bool parsed = req.source == 0 ? model->esixml->parse(req.esi) :
+		model->esixml->parse(req.esi.data(),req.esi.size(),"(request)");
+	if(!parsed) {
+		error = "could not parse '" + (req.source == 0 ? req.esi : std::string("(request)")) + "'";
+		return NULL;
+	}
+	// All devices are prepared before the model is shared, from then on
+	// it is only read
+	for(Device* dev : model->esixml->getDevices()) {
+		if(dictionary && dev->mailbox && dev->mailbox->coe_sdoinfo)
+			ObjectDictionary::synthesize(dev,model->strings,m_verbosity & 0x1);
+		ObjectDictionary::validateBitsizes(dev,m_verbosity & 0x1);
+		ObjectDictionary::sortObjects(dev);
+	}
+
+	if(req.source != 0) model->contents = req.esi;
+
+	std::lock_guard<std::mutex> guard(m_cachelock);
+	auto found = m_cache.find(key);
+	if(found != m_cache.end()) {
+		if(found->second->second->contents != model->contents) return model; // Collision, not cached
+		m_lru.splice(m_lru.begin(),m_lru,found->second);
+		return found->second->second;
+	}
+	m_lru.emplace_front(key,model);
+	m_cache[key] = m_lru.begin();
+	while(m_lru.size() > m_cachesize) {
+		// Requests still using an evicted model keep it alive
+		m_cache.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+	return model;
+}
+
+bool SocketServer::handle(const std::vector<uint8_t>& data, std::string& response) {
+	const bool verbose = m_verbosity & 0x1;
+	const bool very_verbose = m_verbosity & 0x2;
+	auto start = std::chrono::steady_clock::now();
+
+	Request req;
+	RequestReader reader(data);
+	uint8_t version;
+	if(!reader.u8(version) || version != SOCKETSERVER_VERSION) {
+		response = failed("unsupported protocol version");
+		return false;
+	}
+	if(!reader.u8(req.source) || !reader.u16(req.flags) || !reader.u8(req.selector) ||
+	!reader.u32(req.device) || !reader.str(req.esi) || !reader.str(req.name) ||
+	!reader.str(req.output) || !reader.done() || req.source > 1 || req.selector > 2) {
+		response = failed("malformed request");
+		return false;
+	}
+	// As on the command line
+	if(req.flags & FlagNoSII) req.flags |= FlagDictionary;
+
+	std::string error;
+	std::shared_ptr<Model> model = this->model(req,error);
+	if(!model) {
+		response = failed(error);
+		return false;
+	}
+
+	ESIXML& esixml = *model->esixml;
+	std::list<Device*>& devices = esixml.getDevices();
+	Device* dev = NULL;
+	if(req.selector == 0) {
+		if(req.device < devices.size()) dev = *std::next(devices.begin(),req.device);
+	} else {
+		for(Device* d : devices) {
+			if(req.selector == 1 ? d->product_code == req.device :
+				(NULL != d->name && req.name == d->name)) {
+				dev = d;
+				break;
+			}
+		}
+	}
+	if(NULL == dev) {
+		response = failed("no such device in the ESI");
+		return false;
+	}
+
+	const bool encodepdo = req.flags & FlagEncodePdo;
+	std::vector<std::pair<std::string,std::string>> files;
+	if(!(req.flags & FlagNoSII)) {
+		std::vector<uint8_t> eeprom;
+		if(!SII::encodeEEPROM(esixml.getVendorID(),dev,encodepdo,eeprom,very_verbose)) {
+			response = failed("SII does not fit the EEPROM");
+			return false;
+		}
+		if((req.flags & FlagVerifyRoundtrip) &&
+		!SII::verifyRoundtrip(eeprom,esixml.getVendorID(),dev,encodepdo,very_verbose)) {
+			response = failed("SII roundtrip verification failed");
+			return false;
+		}
+		std::string name = req.output;
+		if(name.empty())
+			name = req.source == 0 ? std::string(basename(req.esi.c_str())) + "_eeprom.bin" : "esi_eeprom.bin";
+		files.emplace_back(name,std::string(eeprom.begin(),eeprom.end()));
+	}
+	if((req.flags & FlagDictionary) && NULL != dev->profile && NULL != dev->profile->dictionary) {
+		MemorySink memory;
+		{
+			SOESConfigWriter sscwriter("",req.flags & FlagLittleEndian,&memory);
+			sscwriter.writeSSCFiles(dev,{ .capitalizeStructMembers = (bool)(req.flags & FlagCapitalizeStructMembers),
+				.appendObjectIndexToStructs = (bool)(req.flags & FlagIndexPostfixStructs) });
+		}
+		for(const auto& f : memory.files()) files.emplace_back(f.first,f.second);
+	}
+
+	response.assign(1,'\x00');
+	putU32(response,files.size());
+	for(const auto& f : files) {
+		putStr(response,f.first);
+		putStr(response,f.second);
+	}
+	if(verbose) {
+		printf("Served '%s' in %.2f ms, %zu file(s)\n",req.source == 0 ? req.esi.c_str() : "(request)",
+			std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now() - start).count(),
+			files.size());
+	}
+	return true;
+}
@@ -0,0 +1,86 @@
+#ifndef SOCKETSERVER_H
+#define SOCKETSERVER_H
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Local compile server (--serve-socket) for build workers: a pool of
+ * workers on a Unix domain socket, answering encode requests from an LRU
+ * cache of parsed and prepared models, with all outputs in memory.
+ *
+ * A connection carries any number of requests, one after the other. All
+ * integers are little endian, strings are a u32 length and the bytes.
+ *
+ * Request:  u32 length of the rest
+ *           u8  version (1)
+ *           u8  source: 0 ESI path, 1 ESI bytes
+ *           u16 flags, see Flag
+ *           u8  device selector: 0 index, 1 product code, 2 name
+ *           u32 device index or product code (ignored for names)
+ *           str path or ESI bytes
+ *           str device name (empty unless selected by name)
+ *           str SII file name (empty: as the command line would name it)
+ * Response: u32 length of the rest
+ *           u8  status: 0 ok, 1 failed
+ *           failed: str message
+ *           ok:     u32 file count, then per file str name and str data
+ *
+ * Paths are cached by name, size, mtime and inode, so a changed file is
+ * parsed again. ESI bytes are cached by a hash of their content.
+ * Profiling and the list of outputs in the run statistics are off while
+ * serving, nothing would report them.
+ */
+class SocketServer {
+public:
+	enum Flag {
+		FlagEncodePdo = 0x1,
+		FlagDictionary = 0x2,
+		FlagNoSII = 0x4,
+		FlagCapitalizeStructMembers = 0x8,
+		FlagIndexPostfixStructs = 0x10,
+		FlagLittleEndian = 0x20,
+		FlagVerifyRoundtrip = 0x40,
+	};
+
+	// workers 0: one per core
+	SocketServer(const std::string& path, const unsigned int workers = 0,
+		const size_t cachesize = 16, const int verbosity = 0);
+	~SocketServer();
+	SocketServer(const SocketServer&) = delete;
+	SocketServer& operator=(const SocketServer&) = delete;
+
+	// Serves until the process is stopped, false if the socket could not be set up
+	bool run(void);
+private:
+	struct Model;
+	struct Request;
+
+	std::string m_path;
+	unsigned int m_workers;
+	size_t m_cachesize;
+	int m_verbosity;
+	int m_fd;
+
+	// Accepted connections waiting for a worker
+	std::mutex m_queuelock;
+	std::condition_variable m_queuecond;
+	std::list<int> m_queue;
+
+	// Most recently used first
+	std::mutex m_cachelock;
+	std::list<std::pair<std::string,std::shared_ptr<Model>>> m_lru;
+	std::unordered_map<std::string,std::list<std::pair<std::string,std::shared_ptr<Model>>>::iterator> m_cache;
+
+	void worker(void);
+	void serve(int fd);
+	bool handle(const std::vector<uint8_t>& req, std::string& response);
+	std::shared_ptr<Model> model(const Request& req, std::string& error);
+};
+
+#endif /* SOCKETSERVER_H */
@@ -1,14 +1,25 @@
 #include "soesconfigwriter.h"
+#include <algorithm>
+#include <cstdarg>
+#include <functional>
 #include <string>
-#include <sstream>
-#include <fstream>
-#include <iomanip>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "esctoolhelpers.h"
 #include "esctool.h"
 #include "esctooldefs.h"
 #include "utilfunc.h"
+#include "profiler.h"
+#include "runstats.h"
+#include "outputsink.h"
+#include "parallel.h"
+#include "textemitter.h"
 
 #define SOES_DEFAULT_BUFFER_PREALLOC_FACTOR 3
+// Objects per task of objectlist.c, large enough that a task outweighs
+// handing it out
+#define SOES_OBJECTS_PER_CHUNK 256
 std::string objectdictfile	= "objectlist.c";
 std::string utypesfile		= "utypes.h";
 std::string ecatconfig		= "ecat_options.h";
@@ -26,6 +37,34 @@ std::string CNameify(const char* str, bool capitalize = false) {
 	return r;
 };
 
+namespace {
+
+typedef TextEmitter::Hex Hex;
+
+// C identifiers of model names, made once per name. The model owns the
+// names, so their addresses identify them while writing
+class CNames {
+public:
+	const std::string& get(const char* name, bool capitalize) {
+		std::unordered_map<const char*,std::string>& cache = capitalize ? m_upper : m_lower;
+		auto found = cache.find(name);
+		if(found != cache.end()) return found->second;
+		return cache.emplace(name,CNameify(name,capitalize)).first->second;
+	};
+private:
+	std::unordered_map<const char*,std::string> m_upper;
+	std::unordered_map<const char*,std::string> m_lower;
+};
+
+// The whole file in one write, the sink reports failures
+bool writeFile(OutputSink& sink, const std::string& name, const TextEmitter& out) {
+	if(!sink.write(name,out.str())) return false;
+	RunStats::instance().addOutput(name,(unsigned long)out.size());
+	return true;
+}
+
+};
+
 void printFlags (uint16_t index, uint8_t subindex, const ObjectFlags* f) {
 	printf("0x%.4X:%.2X Flags: '%s'\n",index,subindex,f->category ? f->category : "(No category)");
 	if(f->access) {
@@ -33,867 +72,1064 @@ void printFlags (uint16_t index, uint8_t subindex, const ObjectFlags* f) {
 	}
 };
 
-SOESConfigWriter::SOESConfigWriter(const std::string& outdir, bool input_endianness_is_little) :
+SOESConfigWriter::SOESConfigWriter(const std::string& outdir, bool input_endianness_is_little, OutputSink* sink) :
 	m_outputdir(outdir),
-	m_input_endianness_is_little(input_endianness_is_little) {};
+	m_input_endianness_is_little(input_endianness_is_little),
+	m_sink(sink),
+	m_ownsink(NULL == sink)
+{
+	if(m_ownsink) m_sink = new DirectorySink(m_outputdir);
+};
+
+SOESConfigWriter::~SOESConfigWriter() {
+	if(m_ownsink) delete m_sink;
+};
 
-SOESConfigWriter::~SOESConfigWriter() {};
+namespace {
 
-void SOESConfigWriter::writeSSCFiles(Device* dev, OutputParams params) {
+// What the parts of the output are generated from, nothing changes it
+// while they are
+struct Context {
+	const Device* dev = NULL;
+	SSCWriter::OutputParams params;
+	bool little = false;
 	uint16_t dynrxpdo = 0;
 	uint16_t dyntxpdo = 0;
-	for(Pdo* pdo : dev->rxpdo) if(!pdo->fixed) ++dynrxpdo;
-	for(Pdo* pdo : dev->txpdo) if(!pdo->fixed) ++dyntxpdo;
-
 	uint16_t max_mappings_sm2 = 0;
 	uint16_t max_mappings_sm3 = 0;
-	for(Pdo* pdo : dev->rxpdo) max_mappings_sm2 += pdo->entries.size();
-	for(Pdo* pdo : dev->txpdo) max_mappings_sm3 += pdo->entries.size();
+	Dictionary* dictionary = NULL;
+	std::vector<Object*> objects;
+	// Looked up for every object and subitem, so indexed once. The first
+	// DataType of a name wins, as with a linear search
+	std::unordered_map<std::string_view,DataType*> datatypes;
+};
 
-	// TODO: If slots are predefined and fixed, they're not dynamic...
-	if(NULL != dev->slots) dynrxpdo += dev->slots->maxslotcount;
-	if(NULL != dev->slots) dyntxpdo += dev->slots->maxslotcount;
-
-	std::ofstream configout;
-	configout.open((m_outputdir + ecatconfig).c_str(), std::ios::out | std::ios::trunc);
-	if(!configout.fail()) {
-		printf("Writing SOES compatible configuration to '%s'\n",ecatconfig.c_str());
-		configout << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n\n";
-		configout << "#ifndef __ECAT_OPTIONS_H__\n";
-		configout << "#define __ECAT_OPTIONS_H__\n\n";
-		configout << "#include \"cc.h\"\n\n";
-
-		uint8_t coedetails = 0x0;
-		if(dev->mailbox) {
-			configout << "#define USE_FOE          " << std::dec << (dev->mailbox->foe ? 1 : 0) << "\n";
-			configout << "#define USE_EOE          " << std::dec << (dev->mailbox->eoe ? 1 : 0) << "\n";
-			configout << "\n";
+// A piece of output and the messages printed while generating it. Parts
+// are generated in any order, the messages are printed afterwards in the
+// order of a serial run
+struct Part {
+	TextEmitter out;
+	std::string log;
+	bool quiet = false; // Drop messages without formatting them
+
+	void logf(const char* format, ...) __attribute__((format(printf,2,3))) {
+		if(quiet) return;
+		char buf[512];
+		va_list args;
+		va_start(args,format);
+		int len = vsnprintf(buf,sizeof(buf),format,args);
+		va_end(args);
+		if(len >= (int)sizeof(buf)) {
+			std::vector<char> large(len + 1);
+			va_start(args,format);
+			vsnprintf(large.data(),large.size(),format,args);
+			va_end(args);
+			log.append(large.data(),len);
+		} else
+		if(len > 0) log.append(buf,len);
+	};
+};
+
+DataType* findDT(const Context& ctx, const char* dtname) {
+	if(NULL == dtname) return NULL;
+	auto found = ctx.datatypes.find(dtname);
+	return found == ctx.datatypes.end() ? NULL : found->second;
+}
+
+DataType* deduceDT(const Context& ctx, const Object* obj, const int subitemNo, Part& part) {
+//	printf("DeduceDT: %.04X:%.02X type: '%s', datatype: '%s'\n",
+//		obj->index,subitemNo,obj->type?obj->type:"(null)",obj->datatype?obj->datatype->type:"(null)");
+	const char* type = NULL;
+	DataType* dt = obj->datatype ? obj->datatype : findDT(ctx,obj->type);
+	if(dt != NULL) type = dt->type;
+
+	if(dt != NULL && (dt->subitems.size() > 1 && dt->subitems[1]->subindex == 0))
+	{
+//		printf("DeduceDT: %.04X:%.02X is an array\n", obj->index,subitemNo);
+		// DataType is an array
+		dt = findDT(ctx,dt->subitems[1]->type);
+		if(NULL != dt && dt->arrayinfo) {
+			type = dt->basetype;
+			dt = findDT(ctx,type);
+			if(!dt) {
+				part.logf("\033[0;31mWARNING:\033[0m DataType of object '0x%.04X' subitem '%u' seems to be array, but basetype DataType was not found\n",obj->index,subitemNo);
+			}
 		} else {
-			configout << "#define USE_FOE          0\n";
-			configout << "#define USE_EOE          0\n";
-			configout << "\n";
+			part.logf("\033[0;31mWARNING:\033[0m DataType of object '0x%.04X' subitem '%u' seems to be array, but no arrayinfo found\n",obj->index,subitemNo);
 		}
+	}
 
-		uint16_t defaultmbxsz = 128;
-		for(SyncManager* sm : dev->syncmanagers) {
-			if(0 == strcmp(sm->type,"MBoxOut") || 0 == strcmp(sm->type,"MBoxIn")) {
-				defaultmbxsz = sm->defaultsize;
-				if(sm->defaultsize != 0) {
-					configout << "#define MBXSIZE            " << std::dec << sm->defaultsize << "\n";
-					configout << "#define MBXSIZEBOOT        " << std::dec << sm->defaultsize << "\n";
-					if(dev->mailbox && dev->mailbox->coe_completeaccess) {
-						uint16_t bufsz = SOES_DEFAULT_BUFFER_PREALLOC_FACTOR*defaultmbxsz;
-						uint16_t maxbufsz = bufsz;
-						for(SyncManager* sm : dev->syncmanagers) {
-							if(0 == strcmp(sm->type,"Outputs") ||
-								0 == strcmp(sm->type,"Inputs"))
-							{
-								maxbufsz = std::max(maxbufsz,sm->defaultsize);
-							}
-						}
-						uint8_t prealloc_factor = SOES_DEFAULT_BUFFER_PREALLOC_FACTOR;
-						while(bufsz < maxbufsz) {
-							++prealloc_factor;
-							bufsz = defaultmbxsz*prealloc_factor;
-						}
-						configout << "#define PREALLOC_FACTOR    " << std::dec << (uint32_t) prealloc_factor << "\n";
-					}
-					configout << "\n";
-					break;
-				}
-			}
+	if(NULL == dt) {
+		dt = findDT(ctx,obj->type != NULL ? obj->type : (obj->parent ? obj->parent->type : NULL));
+	}
+	if(NULL == type && NULL != dt) {
+		try {
+			dt = dt->subitems.at(subitemNo);
+			type = dt->type;
+		} catch(const std::out_of_range&) {
+			type = NULL;
 		}
+	}
+	if(NULL == type && NULL != dt) {
+		if(!dt->type) type = dt->name;
+		else type = dt->type;
+	}
+	if(NULL == type) type = obj->type; // Fallback
+	return dt;
+}
 
-		auto calculatePDOSize = [] (std::list<Pdo*>& pdoList, const int syncmanager) {
-			uint16_t pdoSize = 0;
-			for(Pdo* pdo : pdoList) {
-				if(syncmanager == pdo->syncmanager) {
-					for(PdoEntry* entry : pdo->entries) {
-						pdoSize += entry->bitlen;
-					}
-				}
+const char* getCType(const char* type, Part& part) {
+	if(0 == strncmp(type,BOOLstr,4) || 0 == strcmp(type,BITstr)) {
+		return "bool";
+	} else
+	if(0 == strcmp(type,SINTstr)) {
+		return "int8_t";
+	} else
+	if(0 == strcmp(type,INTstr)) {
+		return "int16_t";
+	} else
+	if(0 == strcmp(type,DINTstr)) {
+		return "int32_t";
+	} else
+	if(0 == strcmp(type,USINTstr)) {
+		return "uint8_t";
+	} else
+	if(0 == strcmp(type,UINTstr)) {
+		return "uint16_t";
+	} else
+	if(0 == strcmp(type,UDINTstr)) {
+		return "uint32_t";
+	}
+	if(0 == strcmp(type,ULINTstr)) {
+		return "uint64_t";
+	}
+	part.logf("Warning: Unable to find C-type for '%s'\n",type);
+	return (const char*)NULL;
+}
+
+bool isArray(const Context& ctx, const Object* o) {
+	DataType* dt = o->datatype;
+	if(dt == NULL) {
+		dt = findDT(ctx,o->type);
+		if(dt->subitems.size() > 0) {
+			if(dt->subitems[1]->subindex == 0) {
+				return true;
 			}
-			return (pdoSize % 8) + (pdoSize >> 3); // Divide bitsize by 8 + 1 for remainder
-		};
-
-		for(SyncManager* sm : dev->syncmanagers) {
-			if(0 == strcmp(sm->type,"MBoxOut")) {
-				configout << "#define MBX0_sma         " << "0x" << std::hex << sm->startaddress << "\n";
-				configout << "#define MBX0_sml         " << std::dec << sm->defaultsize << "\n";
-				configout << "#define MBX0_sme         MBX0_sma+MBX0_sml-1\n";
-				configout << "#define MBX0_smc         " << "0x" << std::hex << (uint32_t) sm->controlbyte << "\n";
-
-				configout << "#define MBX0_sma_b       " << "0x" << std::hex << sm->startaddress << "\n";
-				configout << "#define MBX0_sml_b       " << std::dec << sm->defaultsize << "\n";
-				configout << "#define MBX0_sme_b       MBX0_sma_b+MBX0_sml_b-1\n";
-				configout << "#define MBX0_smc_B       " << "0x" << std::hex << (uint32_t) sm->controlbyte <<"\n";
-				configout << "\n";
-			} else
-			if(0 == strcmp(sm->type,"MBoxIn")) {
-				configout << "#define MBX1_sma         " << "0x" << std::hex << sm->startaddress << "\n";
-				configout << "#define MBX1_sml         " << std::dec << sm->defaultsize << "\n";
-				configout << "#define MBX1_sme         MBX1_sma+MBX1_sml-1\n";
-				configout << "#define MBX1_smc         " << "0x" << std::hex << (uint32_t) sm->controlbyte <<"\n";
-
-				configout << "#define MBX1_sma_b       " << "0x" << std::hex << sm->startaddress << "\n";
-				configout << "#define MBX1_sml_b       " << std::dec << sm->defaultsize << "\n";
-				configout << "#define MBX1_sme_b       MBX1_sma_b+MBX1_sml_b-1\n";
-				configout << "#define MBX1_smc_b       " << "0x" << std::hex << (uint32_t) sm->controlbyte <<"\n";
-				configout << "\n";
-			} else
-			if(0 == strcmp(sm->type,"Outputs")) { // TODO verify that the actual assigned SyncManager *is* 2
-				uint16_t calculatedSize = calculatePDOSize(dev->rxpdo,2);
-				if(NULL != dev->slots) {
-					if(dev->modules != NULL) {
-						// TODO, go through each slot (if in the list) and check for supported ModuleIdents
-						int largest = 0;
-						for(auto m : *(dev->modules)) {
-							largest = std::max(calculatePDOSize(m->rxpdo,2),largest);
-						}
-						printf("Largest module RXPDO is '%d' bytes\n",largest);
-						calculatedSize += dev->slots->maxslotcount * largest;
-					}
-				}
-				if(0 == sm->defaultsize) {
-					printf("\033[0;32mCalculated size of RXPDO\033[0m: %d bytes\n",calculatedSize);
-					sm->defaultsize = calculatedSize;
-				} else if(sm->defaultsize != calculatedSize) {
-					printf("\033[0;31mWARNING\033[0m: Calculated PDO output size %d does not match decoded size %d\n",calculatedSize,sm->defaultsize);
-				}
-				configout << "#define SM2_sma          " << "0x" << std::hex << sm->startaddress << "\n";
-				configout << "#define SM2_smc          " << "0x" << std::hex << (uint32_t) sm->controlbyte << "\n";
-				configout << "#define SM2_act          " << (sm->enable ? 1 : 0) << "\n";
-				configout << "#define MAX_RXPDO_SIZE   " << std::dec << sm->defaultsize << "\n";
-				configout << "#ifndef MAX_MAPPINGS_SM2\n";
-				configout << "#define MAX_MAPPINGS_SM2 " << std::dec << max_mappings_sm2 << "\n";
-				configout << "#endif /* MAX_MAPPINGS_SM2 */\n";
-				configout << "\n";
-			} else
-			if(0 == strcmp(sm->type,"Inputs")) { // TODO verify that the actual assigned SyncManager *is* 3
-				uint16_t calculatedSize = calculatePDOSize(dev->txpdo,3);
-				if(NULL != dev->slots) {
-					if(dev->modules != NULL) {
-						// TODO, go through each slot (if in the list) and check for supported ModuleIdents
-						int largest = 0;
-						for(auto m : *(dev->modules)) {
-							largest = std::max(calculatePDOSize(m->txpdo,3),largest);
-						}
-						printf("Largest module TXPDO is '%d' bytes\n",largest);
-						calculatedSize += dev->slots->maxslotcount * largest;
+		}
+	}
+	return dt->arrayinfo != NULL;
+}
+
+void initContext(Context& ctx, const Device* dev, bool little, SSCWriter::OutputParams params) {
+	ctx.dev = dev;
+	ctx.params = params;
+	ctx.little = little;
+	for(Pdo* pdo : dev->rxpdo) if(!pdo->fixed) ++ctx.dynrxpdo;
+	for(Pdo* pdo : dev->txpdo) if(!pdo->fixed) ++ctx.dyntxpdo;
+
+	for(Pdo* pdo : dev->rxpdo) ctx.max_mappings_sm2 += pdo->entries.size();
+	for(Pdo* pdo : dev->txpdo) ctx.max_mappings_sm3 += pdo->entries.size();
+
+	// TODO: If slots are predefined and fixed, they're not dynamic...
+	if(NULL != dev->slots) ctx.dynrxpdo += dev->slots->maxslotcount;
+	if(NULL != dev->slots) ctx.dyntxpdo += dev->slots->maxslotcount;
+
+	ctx.dictionary = dev->profile ? dev->profile->dictionary : NULL;
+	if(NULL != ctx.dictionary) {
+		ctx.objects.assign(ctx.dictionary->objects.begin(),ctx.dictionary->objects.end());
+		ctx.datatypes.reserve(ctx.dictionary->datatypes.size());
+		for(DataType* d : ctx.dictionary->datatypes)
+			if(NULL != d->name) ctx.datatypes.emplace(d->name,d);
+	}
+}
+
+// MBXSIZE and PREALLOC_FACTOR of ecat_options.h, from the first mailbox
+// sync manager with a size. 0 if there is none, the factor also without
+// complete access
+void mailboxSize(const Device* dev, uint16_t& mbxsize, uint8_t& prealloc) {
+	mbxsize = 0;
+	prealloc = 0;
+	for(SyncManager* sm : dev->syncmanagers) {
+		if((0 == strcmp(sm->type,"MBoxOut") || 0 == strcmp(sm->type,"MBoxIn")) && sm->defaultsize != 0) {
+			mbxsize = sm->defaultsize;
+			if(dev->mailbox && dev->mailbox->coe_completeaccess) {
+				uint16_t bufsz = SOES_DEFAULT_BUFFER_PREALLOC_FACTOR*mbxsize;
+				uint16_t maxbufsz = bufsz;
+				for(SyncManager* other : dev->syncmanagers) {
+					if(0 == strcmp(other->type,"Outputs") ||
+						0 == strcmp(other->type,"Inputs"))
+					{
+						maxbufsz = std::max(maxbufsz,other->defaultsize);
 					}
 				}
-				if(0 == sm->defaultsize) {
-					sm->defaultsize = calculatedSize;
-					printf("\033[0;32mCalculated size of TXPDO\033[0m: %d bytes\n",calculatedSize);
-				} else if(sm->defaultsize != calculatedSize) {
-					printf("\033[0;31mWARNING\033[0m: Calculated PDO output size %d does not match decoded size %d\n",calculatedSize,sm->defaultsize);
+				prealloc = SOES_DEFAULT_BUFFER_PREALLOC_FACTOR;
+				while(bufsz < maxbufsz) {
+					++prealloc;
+					bufsz = mbxsize*prealloc;
 				}
-				configout << "#define SM3_sma          " << "0x" << std::hex << sm->startaddress << "\n";
-				configout << "#define SM3_smc          " << "0x" << std::hex << (uint32_t) sm->controlbyte << "\n";
-				configout << "#define SM3_act          " << (sm->enable ? 1 : 0) << "\n";
-				configout << "#define MAX_TXPDO_SIZE   " << std::dec << sm->defaultsize << "\n";
-				configout << "#ifndef MAX_MAPPINGS_SM3\n";
-				configout << "#define MAX_MAPPINGS_SM3 " << std::dec << max_mappings_sm3 << "\n";
-				configout << "#endif /* MAX_MAPPINGS_SM3 */\n";
-				configout << "\n";
+			}
+			return;
+		}
+	}
+}
+
+int calculatePDOSize(const std::list<Pdo*>& pdoList, const int syncmanager) {
+	uint16_t pdoSize = 0;
+	for(Pdo* pdo : pdoList) {
+		if(syncmanager == pdo->syncmanager) {
+			for(PdoEntry* entry : pdo->entries) {
+				pdoSize += entry->bitlen;
 			}
 		}
+	}
+	return (pdoSize % 8) + (pdoSize >> 3); // Divide bitsize by 8 + 1 for remainder
+}
+
+// MAX_RXPDO_SIZE/MAX_TXPDO_SIZE of an Outputs/Inputs sync manager: its
+// size, or if it has none calculated from the PDOs and the largest module
+// in every slot. The default size of other sync managers
+uint16_t pdoSize(const Context& ctx, const SyncManager* sm, Part& part) {
+	const bool rx = 0 == strcmp(sm->type,"Outputs");
+	if(!rx && 0 != strcmp(sm->type,"Inputs")) return sm->defaultsize;
+	const Device* dev = ctx.dev;
+	const int smno = rx ? 2 : 3; // TODO verify that the actual assigned SyncManager *is* 2/3
+	uint16_t calculatedSize = calculatePDOSize(rx ? dev->rxpdo : dev->txpdo,smno);
+	if(NULL != dev->slots) {
+		if(dev->modules != NULL) {
+			// TODO, go through each slot (if in the list) and check for supported ModuleIdents
+			int largest = 0;
+			for(auto m : *(dev->modules)) {
+				largest = std::max(calculatePDOSize(rx ? m->rxpdo : m->txpdo,smno),largest);
+			}
+			part.logf("Largest module %s is '%d' bytes\n",rx ? "RXPDO" : "TXPDO",largest);
+			calculatedSize += dev->slots->maxslotcount * largest;
+		}
+	}
+	// The model is left alone, it may be shared with other writers
+	uint16_t pdosize = sm->defaultsize;
+	if(0 == pdosize) {
+		part.logf("\033[0;32mCalculated size of %s\033[0m: %d bytes\n",rx ? "RXPDO" : "TXPDO",calculatedSize);
+		pdosize = calculatedSize;
+	} else if(sm->defaultsize != calculatedSize) {
+		part.logf("\033[0;31mWARNING\033[0m: Calculated PDO output size %d does not match decoded size %d\n",calculatedSize,sm->defaultsize);
+	}
+	return pdosize;
+}
+
+// ecat_options.h
+void writeOptions(const Context& ctx, Part& part) {
+	const Device* dev = ctx.dev;
+	TextEmitter& configout = part.out;
+	part.logf("Writing SOES compatible configuration to '%s'\n",ecatconfig.c_str());
+	configout << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n\n";
+	configout << "#ifndef __ECAT_OPTIONS_H__\n";
+	configout << "#define __ECAT_OPTIONS_H__\n\n";
+	configout << "#include \"cc.h\"\n\n";
 
+	if(dev->mailbox) {
+		configout << "#define USE_FOE          " << (dev->mailbox->foe ? 1 : 0) << "\n";
+		configout << "#define USE_EOE          " << (dev->mailbox->eoe ? 1 : 0) << "\n";
+		configout << "\n";
+	} else {
+		configout << "#define USE_FOE          0\n";
+		configout << "#define USE_EOE          0\n";
+		configout << "\n";
+	}
+
+	uint16_t mbxsize;
+	uint8_t prealloc;
+	mailboxSize(dev,mbxsize,prealloc);
+	if(0 != mbxsize) {
+		configout << "#define MBXSIZE            " << mbxsize << "\n";
+		configout << "#define MBXSIZEBOOT        " << mbxsize << "\n";
+		if(0 != prealloc) configout << "#define PREALLOC_FACTOR    " << (uint32_t) prealloc << "\n";
 		configout << "\n";
-		configout << "#endif /* __ECAT_OPTIONS_H__ */\n";
-		configout.sync_with_stdio();
-		configout.close();
 	}
 
-	auto findDT = [dict=dev->profile->dictionary](const char* dtname) {
-		if(NULL == dtname) return (DataType*)NULL;
-		for(DataType* d : dict->datatypes) {
-//			if(0 == strcmp(UDINTstr,dtname)) { printf("CHecking UDINT vs '%s'\n",d->name); }
-			if(0 == strcmp(d->name,dtname)) return d;
+	// Addresses and control bytes are lower case hex in this file
+	for(SyncManager* sm : dev->syncmanagers) {
+		if(0 == strcmp(sm->type,"MBoxOut")) {
+			configout << "#define MBX0_sma         " << "0x" << Hex(sm->startaddress,0,false) << "\n";
+			configout << "#define MBX0_sml         " << sm->defaultsize << "\n";
+			configout << "#define MBX0_sme         MBX0_sma+MBX0_sml-1\n";
+			configout << "#define MBX0_smc         " << "0x" << Hex(sm->controlbyte,0,false) << "\n";
+
+			configout << "#define MBX0_sma_b       " << "0x" << Hex(sm->startaddress,0,false) << "\n";
+			configout << "#define MBX0_sml_b       " << sm->defaultsize << "\n";
+			configout << "#define MBX0_sme_b       MBX0_sma_b+MBX0_sml_b-1\n";
+			configout << "#define MBX0_smc_B       " << "0x" << Hex(sm->controlbyte,0,false) <<"\n";
+			configout << "\n";
+		} else
+		if(0 == strcmp(sm->type,"MBoxIn")) {
+			configout << "#define MBX1_sma         " << "0x" << Hex(sm->startaddress,0,false) << "\n";
+			configout << "#define MBX1_sml         " << sm->defaultsize << "\n";
+			configout << "#define MBX1_sme         MBX1_sma+MBX1_sml-1\n";
+			configout << "#define MBX1_smc         " << "0x" << Hex(sm->controlbyte,0,false) <<"\n";
+
+			configout << "#define MBX1_sma_b       " << "0x" << Hex(sm->startaddress,0,false) << "\n";
+			configout << "#define MBX1_sml_b       " << sm->defaultsize << "\n";
+			configout << "#define MBX1_sme_b       MBX1_sma_b+MBX1_sml_b-1\n";
+			configout << "#define MBX1_smc_b       " << "0x" << Hex(sm->controlbyte,0,false) <<"\n";
+			configout << "\n";
+		} else
+		if(0 == strcmp(sm->type,"Outputs")) {
+			uint16_t pdosize = pdoSize(ctx,sm,part);
+			configout << "#define SM2_sma          " << "0x" << Hex(sm->startaddress,0,false) << "\n";
+			configout << "#define SM2_smc          " << "0x" << Hex(sm->controlbyte,0,false) << "\n";
+			configout << "#define SM2_act          " << (sm->enable ? 1 : 0) << "\n";
+			configout << "#define MAX_RXPDO_SIZE   " << pdosize << "\n";
+			configout << "#ifndef MAX_MAPPINGS_SM2\n";
+			configout << "#define MAX_MAPPINGS_SM2 " << ctx.max_mappings_sm2 << "\n";
+			configout << "#endif /* MAX_MAPPINGS_SM2 */\n";
+			configout << "\n";
+		} else
+		if(0 == strcmp(sm->type,"Inputs")) {
+			uint16_t pdosize = pdoSize(ctx,sm,part);
+			configout << "#define SM3_sma          " << "0x" << Hex(sm->startaddress,0,false) << "\n";
+			configout << "#define SM3_smc          " << "0x" << Hex(sm->controlbyte,0,false) << "\n";
+			configout << "#define SM3_act          " << (sm->enable ? 1 : 0) << "\n";
+			configout << "#define MAX_TXPDO_SIZE   " << pdosize << "\n";
+			configout << "#ifndef MAX_MAPPINGS_SM3\n";
+			configout << "#define MAX_MAPPINGS_SM3 " << ctx.max_mappings_sm3 << "\n";
+			configout << "#endif /* MAX_MAPPINGS_SM3 */\n";
+			configout << "\n";
 		}
-		return (DataType*)NULL;
-	};
+	}
 
-	auto deduceDT = [dict=dev->profile->dictionary,&findDT](Object* obj, const int subitemNo) {
-//		printf("DeduceDT: %.04X:%.02X type: '%s', datatype: '%s'\n",
-//			obj->index,subitemNo,obj->type?obj->type:"(null)",obj->datatype?obj->datatype->type:"(null)");
-		const char* type = NULL;
-		DataType* dt = obj->datatype ? obj->datatype : findDT(obj->type);
-		if(dt != NULL) type = dt->type;
+	configout << "\n";
+	configout << "#endif /* __ECAT_OPTIONS_H__ */\n";
+}
 
-		if(dt != NULL && (dt->subitems.size() > 1 && dt->subitems[1]->subindex == 0))
-		{
-//			printf("DeduceDT: %.04X:%.02X is an array\n", obj->index,subitemNo);
-			// DataType is an array
-			dt = findDT(dt->subitems[1]->type);
-			if(NULL != dt && dt->arrayinfo) {
-				type = dt->basetype;
-				dt = findDT(type);
-				if(!dt) {
-					printf("\033[0;31mWARNING:\033[0m DataType of object '0x%.04X' subitem '%u' seems to be array, but basetype DataType was not found\n",obj->index,subitemNo);
-				}
-			} else {
-				printf("\033[0;31mWARNING:\033[0m DataType of object '0x%.04X' subitem '%u' seems to be array, but no arrayinfo found\n",obj->index,subitemNo);
+// C type of the variable of an object without subitems in utypes.h
+const char* varType(const Object* o, Part& part) {
+	const char* type = o->datatype ?
+		(o->datatype->type ? o->datatype->type :
+			o->datatype->name) :
+		o->type;
+	return getCType(type,part);
+}
+
+// The variable of an object in utypes.h: a struct of its subitems named
+// in upper case, or a single value
+void writeVarName(TextEmitter& out, const Context& ctx, CNames& cnames, const Object* o) {
+	out << cnames.get(o->name,!o->subitems.empty() || ctx.params.capitalizeStructMembers);
+	if(ctx.params.appendObjectIndexToStructs) out << "0x" << Hex(o->index & 0xFFFF,4);
+}
+
+// Members of the struct of an object in utypes.h, as each(subitem,
+// subindex, C type). Subitems without a type are left out, the subindex
+// counts only those written
+template<typename F>
+void structMembers(const Context& ctx, const Object* o, Part& part, F each) {
+	int subitem = 0;
+	bool array = isArray(ctx,o);
+
+	for(Object* si : o->subitems) {
+		if(0 == subitem) {
+			++subitem;
+			continue;
+		}
+		DataType* dt = deduceDT(ctx,si,subitem,part);
+		const char* type = array? dt->name : dt->type;
+		if(NULL == type) {
+			part.logf("WARNING: Could not determine C-datatype for '%s':'%s' ('%s')\n",o->name,si->name,(si->datatype?si->datatype->name:o->type));
+			continue;
+		}
+		each(si,subitem,getCType(type,part));
+		++subitem;
+	}
+}
+
+// utypes.h
+void writeTypes(const Context& ctx, Part& part) {
+	CNames cnames;
+	TextEmitter& typesout = part.out;
+	typesout.reserve(64*ctx.objects.size() + 1024);
+	part.logf("Writing SOES compatible type definitions to '%s'\n",utypesfile.c_str());
+	typesout << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n\n";
+	typesout << "#ifndef __UTYPES_H__\n";
+	typesout << "#define __UTYPES_H__\n\n";
+	typesout << "#include <stdint.h>\n";
+	typesout << "\n";
+
+	/** Write struct(s) to hold the mapped object "references"*/
+	if(ctx.dynrxpdo) {
+		typesout << "/** When using dynamic RXPDOs remember to initialize max_subindex and so on manually */\n";
+		typesout << "typedef struct {\n";
+		typesout << "\tuint8_t max_subindex;\n";
+		typesout << "\tuint16_t subindex[" << (int)ctx.dynrxpdo << "];" << " /* 0x1600-0x" << Hex(0x1600 + ctx.dynrxpdo) << " */\n";
+		typesout << "} _" << sm2mappings_str << ";\n\n";
+		typesout << "extern _" <<  sm2mappings_str << " " << sm2mappings_str << ";\n\n";
+	}
+
+	if(ctx.dyntxpdo) {
+		typesout << "/** When using dynamic TXPDOs remember to initialize max_subindex and so on manually */\n";
+		typesout << "typedef struct {\n";
+		typesout << "\tuint8_t max_subindex;\n";
+		typesout << "\tuint16_t subindex[" << (int)ctx.dyntxpdo << "];" << " /* 0x1A00-0x" << Hex(0x1A00 + ctx.dyntxpdo) << " */\n";
+		typesout << "} _" << sm3mappings_str << ";\n\n";
+		typesout << "extern _" <<  sm3mappings_str << " " << sm3mappings_str << ";\n\n";
+	}
+
+	for(Object* o : ctx.objects) {
+		uint16_t index = o->index & 0xFFFF;
+		if(index < 0x2000) continue;
+
+		if(!o->subitems.empty()) {
+			typesout << "typedef struct {\n";
+			structMembers(ctx,o,part,[&](const Object* si, int subitem, const char* ctype) {
+				typesout << "\t" << ctype << " ";
+				typesout << cnames.get(si->name,ctx.params.capitalizeStructMembers);
+				typesout << "; /* " << Hex(si->index,4) << "." << Hex(subitem,2) << " */\n";
+			});
+			const std::string& name = cnames.get(o->name,true);
+			typesout << "} _" << name << ";\n\n";
+			typesout << "extern _" << name << " ";
+		} else {
+			typesout << "extern " << varType(o,part) << " ";
+		}
+		writeVarName(typesout,ctx,cnames,o);
+		typesout << ";\n\n";
+	}
+	typesout << "#endif /* UTYPES_H */\n";
+}
+
+// modules.h
+void writeModules(const Context& ctx, const std::string& modulesfile, Part& part) {
+	const Device* dev = ctx.dev;
+	CNames cnames;
+	TextEmitter& out = part.out;
+	part.logf("Writing module type definitions to '%s'\n",modulesfile.c_str());
+	const std::string& devname = cnames.get(dev->name,true);
+	out << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n"
+	    << "#ifndef __" << devname << "_MODULES_H__\n"
+	    << "#define __" << devname << "_MODULES_H__\n"
+	    << "#include <stddef.h>\n"
+	    << "#include <stdint.h>\n"
+	    << "\n";
+
+	out << "#define MODULE_SLOT_INDEX_INCREMENT\t\t(" << (int)(dev->slots->slotindexincrement) << ")\n"
+	    << "#define MODULE_SLOT_PDO_INCREMENT\t\t(" << (int)(dev->slots->slotpdoincrement) << ")\n"
+	    << "\n";
+
+	for(Module* mod : *(dev->modules)) {
+		out << "#define " << cnames.get(mod->type,true) << "_IDENT" << "\t\t(" << mod->ident << ")\n";
+		out << "typedef struct " << cnames.get(mod->type,ctx.params.capitalizeStructMembers) << " {\n";
+		for(Pdo* p : mod->rxpdo) {
+			out << "\t/* RXPDO @ 0x" << Hex(p->index) << " */\n";
+			if(p->dependonslot) {
+				out << "\t/* Index is slot dependent: real-index = index + (slot * MODULE_SLOT_INDEX_INCREMENT) */\n";
 			}
+			for(PdoEntry* e : p->entries) {
+				out << "\t"
+				    << getCType(e->datatype,part)
+				    << " "
+				    << cnames.get(e->name,ctx.params.capitalizeStructMembers)
+				    << "; /* "
+				    << Hex(p->index,4)
+				    << "."
+				    << Hex(e->subindex,2)
+				    << " */\n";
+			}
+			if(p != mod->rxpdo.back()) out << "\n";
+		}
+		if(!mod->rxpdo.empty() && !mod->txpdo.empty()) out << "\n";
+		for(Pdo* p : mod->txpdo) {
+			out << "\t/* TXPDO @ 0x" << Hex(p->index) << " */\n";
+			if(p->dependonslot) {
+				out << "\t/* Index is slot dependent: real-index = index + (slot * MODULE_SLOT_INDEX_INCREMENT) */\n";
+			}
+			for(PdoEntry* e : p->entries) {
+				out << "\t"
+				    << getCType(e->datatype,part)
+				    << " "
+				    << cnames.get(e->name,ctx.params.capitalizeStructMembers)
+				    << "; /* "
+				    << Hex(p->index,4)
+				    << "."
+				    << Hex(e->subindex,2)
+				    << " */\n";
+			}
+			if(p != mod->txpdo.back()) out << "\n";
 		}
+		out << "} " << cnames.get(mod->type,ctx.params.capitalizeStructMembers) << "_t;\n\n";
+	}
+	out << "#endif /* __" << devname << "_MODULES_H__ */\n";
+}
 
-		if(NULL == dt) {
-			dt = findDT(obj->type != NULL ? obj->type : (obj->parent ? obj->parent->type : NULL));
+// Value of the acValue of a STRING object
+void writeStringValue(TextEmitter& out, const Object* o) {
+	if(NULL != o->defaultstring) {
+		out << o->defaultstring;
+	} else
+	if(NULL != o->defaultdata) {
+		// Can we assume strings set in DefaultData are
+		// hex encoded byte values?
+		std::string str("");
+		for(size_t i = 0; i < strlen(o->defaultdata); i+=2) {
+			char s[3];
+			strncpy(s,&(o->defaultdata[i]),2);
+			s[2] = '\0';
+			str += (char)(strtol(s,NULL,16));
 		}
-		if(NULL == type && NULL != dt) {
-			try {
-				dt = dt->subitems.at(subitemNo);
-				type = dt->type;
-			} catch(const std::out_of_range&) {
-				type = NULL;
+		out << str;
+	} else {
+		out << "(null)";
+	}
+}
+
+// Name (and string value) declarations of objects [first,last) of objectlist.c
+void writeObjectNames(const Context& ctx, size_t first, size_t last, Part& part) {
+	TextEmitter& out = part.out;
+	out.reserve(160*(last - first));
+	for(size_t i = first; i < last; ++i) {
+		Object* o = ctx.objects[i];
+		out << "static const char acName" << Hex(o->index & 0xFFFF,4);
+		out << "[] = \"" << o->name << "\";\n";
+		// TODO handle several levels?
+		int subitem = 0;
+		for(Object* si : o->subitems) {
+			out << "static const char acName" << Hex(si->index & 0xFFFF,4);
+			out << "_" << Hex(subitem,2);
+			if(subitem == 0) {
+				out << "[] = \"Max SubIndex\";\n";
+			} else {
+				out << "[] = \"" << si->name << "\";\n";
 			}
+			++subitem;
 		}
-		if(NULL == type && NULL != dt) {
-			if(!dt->type) type = dt->name;
-			else type = dt->type;
+		if(SOESValues::isString(o)) {
+			out << "static char acValue" << Hex(o->index & 0xFFFF,4);
+			out << "_00[] = \"";
+			writeStringValue(out,o);
+			out << "\";\n";
 		}
-		if(NULL == type) type = obj->type; // Fallback
-		return dt;
-	};
+	}
+}
+
+typedef SOESValues::Row Row;
+
+// Row of an SDO table, for a subitem or (without parent) for an object
+// that has none. decimal: the previous row was a mapping of a dynamic
+// PDO. The stream based writer left the stream decimal after those, and
+// the next subindex came out in decimal; kept for identical output
+void describeRow(const Context& ctx, Part& part, const Object* obj, const Object* parent,
+	const int subitem, bool& decimal, Row& row)
+{
+	row = Row();
+	row.object = obj;
+	row.parent = parent;
+	row.subindex = subitem;
+	row.decimal = decimal;
+	decimal = false;
+	bool objref = false;
+	const int nitems = parent ? parent->subitems.size() : 0;
+
+	uint16_t index = obj->index & 0xFFFF;
+
+	DataType* datatype = NULL;
+
+	if(isArray(ctx,obj) && 0 == subitem) {
+		datatype = findDT(ctx,obj->type);
+		if(datatype) datatype = datatype->subitems[0];
+	} else {
+		datatype = obj->datatype ? obj->datatype : deduceDT(ctx,obj,subitem,part);
+	}
+
+	const char* type = datatype ? datatype->type ? datatype->type : datatype->name : NULL;
+
+	if(!datatype && subitem == 0) type = USINTstr; // TODO: FIXME?
+
+	const ObjectFlags* flags = obj->flags ? obj->flags : (datatype ? datatype->flags : NULL);
 
-	auto getCType = [](const char* type) {
+	uint32_t bitsize = obj->bitsize ? obj->bitsize : (datatype ? datatype->bitsize : 0);
+
+	if(NULL == type) {
+		part.logf("\033[0;31mWARNING:\033[0m DataType of object '0x%.04X' subitem '%u' is \033[0;33mNULL\033[0m\n\n\n",obj->index,subitem);
+	} else
+	if(0 == strncmp(type,"STRING",5)) {
+		row.dtype = "DTYPE_VISIBLE_STRING";
+		objref = true;
+	} else  // capitalization of all these strings?
+	{
 		if(0 == strncmp(type,BOOLstr,4) || 0 == strcmp(type,BITstr)) {
-			return "bool";
+			row.dtype = "DTYPE_BOOLEAN";
+			bitsize = 1;
 		} else
 		if(0 == strcmp(type,SINTstr)) {
-			return "int8_t";
+			row.dtype = "DTYPE_INTEGER8";
+			bitsize = 8;
 		} else
 		if(0 == strcmp(type,INTstr)) {
-			return "int16_t";
+			row.dtype = "DTYPE_INTEGER16";
+			bitsize = 16;
 		} else
 		if(0 == strcmp(type,DINTstr)) {
-			return "int32_t";
+			row.dtype = "DTYPE_INTEGER32";
+			bitsize = 32;
 		} else
 		if(0 == strcmp(type,USINTstr)) {
-			return "uint8_t";
+			row.dtype = "DTYPE_UNSIGNED8";
+			bitsize = 8;
 		} else
 		if(0 == strcmp(type,UINTstr)) {
-			return "uint16_t";
+			row.dtype = "DTYPE_UNSIGNED16";
+			bitsize = 16;
 		} else
 		if(0 == strcmp(type,UDINTstr)) {
-			return "uint32_t";
-		}
+			row.dtype = "DTYPE_UNSIGNED32";
+			bitsize = 32;
+		} else
 		if(0 == strcmp(type,ULINTstr)) {
-			return "uint64_t";
+			row.dtype = "DTYPE_UNSIGNED64";
+			bitsize = 64;
+		} else
+		{ // TODO handle more types?
+			part.logf("\033[0;31mWARNING:\033[0m %.04X:%.02X Unhandled Datatype '%s'\n",
+				obj->index,subitem,obj->type);
+			row.dtype = "DTYPE_UNSIGNED32"; // Default
+			bitsize = 32;
 		}
-		printf("Warning: Unable to find C-type for '%s'\n",type);
-		return (const char*)NULL;
-	};
+		row.bitlength = bitsize == 0 ? obj->bitsize : bitsize;
+	}
 
-	auto isArray = [&](Object* o) {
-		DataType* dt = o->datatype;
-		if(dt == NULL) {
-			dt = findDT(o->type);
-			if(dt->subitems.size() > 0) {
-				if(dt->subitems[1]->subindex == 0) {
-					return true;
-				}
-			}
+	// TODO handle the preRW and whatever in read/write-restrictions
+	if(NULL == flags ||
+		NULL == flags->access ||
+		0 == strcmp(flags->access->access,"ro"))
+	{
+		row.atype = "ATYPE_RO";
+	} else
+	if(0 == strcmp(flags->access->access,"rw")) {
+		row.atype = "ATYPE_RW";
+		if(flags->access->writerestrictions &&
+			0 == strcmp(flags->access->writerestrictions,"PreOP"))
+		{
+			row.atype = "ATYPE_RWpre";
 		}
-		return dt->arrayinfo != NULL;
-	};
+	}
 
-	if(dev->profile && dev->profile->dictionary) {
-		std::ofstream typesout;
-		typesout.open((m_outputdir + utypesfile).c_str(), std::ios::out | std::ios::trunc);
-		if(!typesout.fail()) {
-			printf("Writing SOES compatible type definitions to '%s'\n",utypesfile.c_str());
-			typesout << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n\n";
-			typesout << "#ifndef __UTYPES_H__\n";
-			typesout << "#define __UTYPES_H__\n\n";
-			typesout << "#include <stdint.h>\n";
-			typesout << "\n";
-
-			/** Write struct(s) to hold the mapped object "references"*/
-			if(dynrxpdo) {
-				typesout << "/** When using dynamic RXPDOs remember to initialize max_subindex and so on manually */\n";
-				typesout << "typedef struct {\n";
-				typesout << "\tuint8_t max_subindex;\n";
-				typesout << "\tuint16_t subindex[" << std::dec << (int)dynrxpdo << "];" << " /* 0x1600-0x" << std::hex << std::uppercase << (0x1600 + dynrxpdo) << " */\n";
-				typesout << "} _" << sm2mappings_str << ";\n\n";
-				typesout << "extern _" <<  sm2mappings_str << " " << sm2mappings_str << ";\n\n";
+	if(!objref) {
+		if((index < 0x2000 || (0 == subitem || NULL == parent) && (0 != nitems))) {
+			if(0x1c12 == index && 0 != ctx.dynrxpdo) {
+				row.init = Row::Mapping;
+				row.sm = 2;
+				decimal = 0 != subitem;
+			} else if(0x1c13 == index && 0 != ctx.dyntxpdo) {
+				row.init = Row::Mapping;
+				row.sm = 3;
+				decimal = 0 != subitem;
+			} else if(NULL != obj->defaultdata) {
+				row.init = Row::DefaultData;
+			} else {
+				row.init = Row::None;
 			}
+		} else { // Reference the objects from utypes.h
+			row.init = 0 == nitems ? Row::Variable : Row::Member;
+		}
+	} else {
+		row.init = Row::String;
+	}
+}
 
-			if(dyntxpdo) {
-				typesout << "/** When using dynamic TXPDOs remember to initialize max_subindex and so on manually */\n";
-				typesout << "typedef struct {\n";
-				typesout << "\tuint8_t max_subindex;\n";
-				typesout << "\tuint16_t subindex[" << std::dec << (int)dyntxpdo << "];" << " /* 0x1A00-0x" << std::hex << std::uppercase << (0x1A00 + dyntxpdo) << " */\n";
-				typesout << "} _" << sm3mappings_str << ";\n\n";
-				typesout << "extern _" <<  sm3mappings_str << " " << sm3mappings_str << ";\n\n";
+void writeRowValue(TextEmitter& out, const Context& ctx, const Row& row) {
+	if(row.init == Row::Mapping) {
+		out << (0 == row.subindex ? "0x00" : "0x0000");
+	} else
+	if(row.init == Row::DefaultData) {
+		const char* defaultdata = row.object->defaultdata;
+		// TODO: can we assume data is hex or smth? HexDecStr...
+		if(strncmp(defaultdata,"0x",2))
+			out << "0x";
+		if(ctx.little) {
+			for(size_t i = strlen(defaultdata); i > 0; i-=2) {
+				out << std::string_view(&(defaultdata[i-2]),2);
 			}
+		} else {
+			out << defaultdata;
+		}
+	} else {
+		out << "0";
+	}
+}
 
-			for(Object* o : dev->profile->dictionary->objects) {
-				uint16_t index = o->index & 0xFFFF;
-				if(index < 0x2000) continue;
-
-				if(!o->subitems.empty()) {
-					typesout << "typedef struct {\n";
-					int subitem = 0;
-					bool array = isArray(o);
-
-					for(Object* si : o->subitems) {
-						if(0 == subitem) {
-							++subitem;
-							continue;
-						}
-						DataType* dt = deduceDT(si,subitem);
-						const char* type = array? dt->name : dt->type;
-						if(NULL == type) {
-							printf("WARNING: Could not determine C-datatype for '%s':'%s' ('%s')\n",o->name,si->name,(si->datatype?si->datatype->name:o->type));
-							continue;
-						}
-						typesout << "\t";
-						typesout << getCType(type);
-						typesout << " ";
-						typesout << CNameify(si->name,params.capitalizeStructMembers);
-						typesout << ";";
-						typesout << " /* "; 
-						typesout << std::uppercase
-							<< std::hex
-							<< std::setfill('0')
-							<< std::setw(4)
-							<< si->index
-							<< "."
-							<< std::setw(2)
-							<< subitem;
-						typesout << " */\n";
-						++subitem;
-					}
-					typesout << "} _" << CNameify(o->name,true) << ";\n\n";
-					typesout << "extern _";
-					typesout << CNameify(o->name,true);
-					typesout << " ";
-					typesout << CNameify(o->name,true);
-					if(params.appendObjectIndexToStructs) {
-						typesout << "0x";
-						typesout << std::uppercase
-							 << std::hex
-							 << std::setfill('0')
-							 << std::setw(4)
-							 << index;
-					}	
-					typesout << ";\n\n";
-				} else {
-					const char* type = o->datatype ? 
-						(o->datatype->type ? o->datatype->type :
-							o->datatype->name) :
-						o->type;
-					typesout << "extern";
-					typesout << " ";
-					typesout << getCType(type);
-					typesout << " ";
-					typesout << CNameify(o->name,params.capitalizeStructMembers);
-					if(params.appendObjectIndexToStructs) {
-						typesout << "0x";
-						typesout << std::uppercase
-							 << std::hex
-							 << std::setfill('0')
-							 << std::setw(4)
-							 << index;
-					}	
-					typesout << ";\n\n";
-				}
+void writeRowData(TextEmitter& out, const Context& ctx, CNames& cnames, const Row& row) {
+	uint16_t index = row.object->index & 0xFFFF;
+	switch(row.init) {
+		case Row::Mapping: {
+			const std::string& mappings = 2 == row.sm ? sm2mappings_str : sm3mappings_str;
+			if(0 == row.subindex) {
+				out << "&(" << mappings << ".max_subindex)";
+			} else {
+				out << "&(" << mappings << ".subindex[" << (row.subindex - 1) << "])";
 			}
-			typesout << "#endif /* UTYPES_H */\n";
-			typesout.sync_with_stdio();
-			typesout.close();
+			break;
+		}
+		case Row::Variable:
+			out << "&";
+			writeVarName(out,ctx,cnames,row.object);
+			break;
+		case Row::Member:
+			out << "&(";
+			out << cnames.get(row.parent->name,true);
+			if(ctx.params.appendObjectIndexToStructs) out << "0x" << Hex(index,4);
+			out << ".";
+			out << cnames.get(row.object->name,ctx.params.capitalizeStructMembers);
+			out << ")";
+			break;
+		case Row::String:
+			out << "&acValue" << Hex(index,4) << "_00[0]";
+			break;
+		default:
+			out << "NULL";
+			break;
+	}
+}
+
+void writeRow(TextEmitter& out, const Context& ctx, CNames& cnames, const Row& row) {
+	uint16_t index = row.object->index & 0xFFFF;
+	out << "{ 0x";
+	if(row.decimal) {
+		if(row.subindex < 10) out << '0';
+		out << row.subindex;
+	} else {
+		out << Hex(row.subindex,2);
+	}
+	out << ", ";
+	if(NULL != row.dtype) {
+		out << row.dtype << ", ";
+		if(row.init == Row::String) {
+			out << "sizeof(acValue" << Hex(index,4) << "_00) << 3";
 		} else {
-			printf("Couln't open '%s' for writing\n",utypesfile.c_str());
+			out << row.bitlength;
 		}
+	}
+	out << ", " << row.atype << ", ";
 
-		if(dev->modules) {
-			std::string modulesfile = "modules.h";
-			std::ofstream out;
-			out.open((m_outputdir + modulesfile).c_str(), std::ios::out | std::ios::trunc);
-			printf("Writing module type definitions to '%s'\n",modulesfile.c_str());
-			out << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n"
-			    << "#ifndef __" << CNameify(dev->name,true) << "_MODULES_H__\n"
-			    << "#define __" << CNameify(dev->name,true) << "_MODULES_H__\n"
-			    << "#include <stddef.h>\n"
-			    << "#include <stdint.h>\n"
-			    << "\n";
-
-			out << "#define MODULE_SLOT_INDEX_INCREMENT\t\t(" << (int)(dev->slots->slotindexincrement) << ")\n"
-			    << "#define MODULE_SLOT_PDO_INCREMENT\t\t(" << (int)(dev->slots->slotpdoincrement) << ")\n"
-			    << "\n";
-
-			for(Module* mod : *(dev->modules)) {
-				out << "#define " << CNameify(mod->type,true) << "_IDENT" << "\t\t(" << (int)(mod->ident) << ")\n";
-				out << "typedef struct " << CNameify(mod->type,params.capitalizeStructMembers) << " {\n";
-				out << std::hex;
-				for(Pdo* p : mod->rxpdo) {
-					out << "\t/* RXPDO @ 0x" << std::uppercase << p->index << " */\n";
-					if(p->dependonslot) {
-						out << "\t/* Index is slot dependent: real-index = index + (slot * MODULE_SLOT_INDEX_INCREMENT) */\n";
-					}
-					for(PdoEntry* e : p->entries) {
-						out << "\t"
-						    << getCType(e->datatype)
-						    << " "
-						    << CNameify(e->name,params.capitalizeStructMembers)
-						    << "; /* "
-						    << std::setfill('0')
-						    << std::setw(4)
-						    << p->index
-						    << "."
-						    << std::setw(2)
-						    << e->subindex
-						    << " */\n";
-					}
-					if(p != mod->rxpdo.back()) out << "\n";
-				}
-				if(!mod->rxpdo.empty() && !mod->txpdo.empty()) out << "\n";
-				for(Pdo* p : mod->txpdo) {
-					out << "\t/* TXPDO @ 0x" << std::uppercase << p->index << " */\n";
-					if(p->dependonslot) {
-						out << "\t/* Index is slot dependent: real-index = index + (slot * MODULE_SLOT_INDEX_INCREMENT) */\n";
-					}
-					for(PdoEntry* e : p->entries) {
-						out << "\t"
-						    << getCType(e->datatype)
-						    << " "
-						    << CNameify(e->name,params.capitalizeStructMembers)
-						    << "; /* "
-						    << std::setfill('0')
-						    << std::setw(4)
-						    << p->index
-						    << "."
-						    << std::setw(2)
-						    << e->subindex
-						    << " */\n";
-					}
-					if(p != mod->txpdo.back()) out << "\n";
-				}
-				out << std::dec;
-				out << "} " << CNameify(mod->type,params.capitalizeStructMembers) << "_t;\n\n";
-			}
-			out << "#endif /* __" << CNameify(dev->name,true) << "_MODULES_H__ */\n";
-			out.close();
+	out << "&acName" << Hex(index,4);
+	if(NULL == row.parent) {
+		out << "[0]";
+	} else {
+		out << "_" << Hex(row.subindex,2) << "[0]";
+	}
+	out << ", ";
+	writeRowValue(out,ctx,row);
+	out << ", ";
+	writeRowData(out,ctx,cnames,row);
+	out << " }";
+}
+
+// Rows of the SDO table of an object, as each(row)
+template<typename F>
+void objectRows(const Context& ctx, Part& part, const Object* o, F each) {
+	Row row;
+	bool decimal = false;
+	if(o->subitems.empty()) {
+		describeRow(ctx,part,o,NULL,0,decimal,row);
+		each(row);
+	} else {
+		// TODO handle several levels?
+		int subitem = 0;
+		for(Object* si : o->subitems) {
+			describeRow(ctx,part,si,o,subitem++,decimal,row);
+			each(row);
 		}
+	}
+}
 
-		std::ofstream out;
-		out.open((m_outputdir + objectdictfile).c_str(), std::ios::out | std::ios::trunc);
-		if(!out.fail()) {
-			printf("Writing SOES compatible object dictionary to '%s'\n",objectdictfile.c_str());
-			out << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n"
-			    << "#include \"esc_coe.h\"\n"
-			    << "#include \"" << utypesfile << "\"\n"
-			    << "#include <stddef.h>\n"
-			    << "\n";
-
-			// Generate string objects
-			for(Object* o : dev->profile->dictionary->objects) {
-				out << "static const char acName"
-					<< std::hex
-					<< std::setfill('0')
-					<< std::setw(4)
-					<< std::uppercase
-					<< (o->index & 0xFFFF);
-				out << "[] = \"" << o->name << "\";\n";
-				// TODO handle several levels?
-				int subitem = 0;
-				for(Object* si : o->subitems) {
-					out << "static const char acName"
-						<< std::hex
-						<< std::setfill('0')
-						<< std::setw(4)
-						<< std::uppercase
-						<< (si->index & 0xFFFF);
-					out << "_";
-					out << std::setfill('0')
-						<< std::setw(2)
-						<< subitem;
-					if(subitem == 0) {
-						out << "[] = \"Max SubIndex\";\n";
-					} else {
-						out << "[] = \"" << si->name << "\";\n";
-					}
-					++subitem;
-				}
-				if(NULL != o->type && 0 == strncmp("STRING",o->type,5)) {
-					out << "static char acValue"
-						<< std::hex
-						<< std::setfill('0')
-						<< std::setw(4)
-						<< std::uppercase
-						<< (o->index & 0xFFFF);
-					out << "_00[] = \"";
-					if(NULL != o->defaultstring) {
-						out << o->defaultstring;
-					} else
-					if(NULL != o->defaultdata) {
-						// Can we assume strings set in DefaultData are
-						// hex encoded byte values?
-						std::string str("");
-						for(size_t i = 0; i < strlen(o->defaultdata); i+=2) {
-							char s[3];
-							strncpy(s,&(o->defaultdata[i]),2);
-							s[2] = '\0';
-							str += (char)(strtol(s,NULL,16));
-						}
-						out << str;
-					} else {
-						out << "(null)";
-					}
-					out << "\";\n";
-				}
-			}
-			out << "\n";
-
-			auto writeObject = [this,&out,&findDT,&deduceDT,&isArray,&dynrxpdo,&dyntxpdo,&params]
-				(Object* obj, Object* parent, int& subitem, const int nitems, Dictionary* dict = NULL)
-			{
-				bool objref = false;
-				out << "{ 0x"
-					<< std::setw(2)
-					<< subitem
-					<< ", ";
-
-				uint16_t index = obj->index & 0xFFFF;
-
-				DataType* datatype = NULL;
-
-				if(isArray(obj) && 0 == subitem) {
-					datatype = findDT(obj->type);
-					if(datatype) datatype = datatype->subitems[0];
-				} else {
-					datatype = obj->datatype ? obj->datatype : deduceDT(obj,subitem);
-				}
+// SDO tables of objects [first,last) of objectlist.c
+void writeObjectTables(const Context& ctx, size_t first, size_t last, Part& part) {
+	CNames cnames;
+	TextEmitter& out = part.out;
+	out.reserve(384*(last - first));
+	for(size_t i = first; i < last; ++i) {
+		Object* o = ctx.objects[i];
+		out << "const _objd SDO" << Hex(o->index & 0xFFFF,4);
+		out << "[] = {\n";
+		if(0x1C12 == o->index && ctx.dev->slots) {
+			// If we have slots, we will (most likely?) have dynamic mappable PDOs
+			// According to ETG5001 the module PDOs for modules should be in 0x1600-0x16FF
+			// Thus we assume any device specific PDOs will be in 0x1700 and above
+			// Above we made the SM[2/3]_MAPPING types. We will refer them here.
+		}
+		bool separate = false;
+		objectRows(ctx,part,o,[&](const Row& row) {
+			if(separate) out << ",\n";
+			writeRow(out,ctx,cnames,row);
+			separate = true;
+		});
+		out << " };\n\n";
+	}
+}
 
-				const char* type = datatype ? datatype->type ? datatype->type : datatype->name : NULL;
-
-				if(!datatype && subitem == 0) type = USINTstr; // TODO: FIXME?
-
-				const ObjectFlags* flags = obj->flags ? obj->flags : (datatype ? datatype->flags : NULL);
-
-				uint32_t bitsize = obj->bitsize ? obj->bitsize : (datatype ? datatype->bitsize : 0);
-
-				if(NULL == type) {
-					printf("\033[0;31mWARNING:\033[0m DataType of object '0x%.04X' subitem '%u' is \033[0;33mNULL\033[0m\n\n\n",obj->index,subitem);
-				} else
-				if(0 == strncmp(type,"STRING",5)) {
-					out << "DTYPE_VISIBLE_STRING" << ", ";
-					out << "sizeof(";
-					out << "acValue"
-						<< std::hex
-						<< std::setfill('0')
-						<< std::setw(4)
-						<< std::uppercase
-						<< index;
-					out << "_00) << 3";
-					objref = true;
-				} else  // capitalization of all these strings?
-				{
-					if(0 == strncmp(type,BOOLstr,4) || 0 == strcmp(type,BITstr)) {
-						out << "DTYPE_BOOLEAN";
-						bitsize = 1;
-					} else
-					if(0 == strcmp(type,SINTstr)) {
-						out << "DTYPE_INTEGER8";
-						bitsize = 8;
-					} else
-					if(0 == strcmp(type,INTstr)) {
-						out << "DTYPE_INTEGER16";
-						bitsize = 16;
-					} else
-					if(0 == strcmp(type,DINTstr)) {
-						out << "DTYPE_INTEGER32";
-						bitsize = 32;
-					} else
-					if(0 == strcmp(type,USINTstr)) {
-						out << "DTYPE_UNSIGNED8";
-						bitsize = 8;
-					} else
-					if(0 == strcmp(type,UINTstr)) {
-						out << "DTYPE_UNSIGNED16";
-						bitsize = 16;
-					} else
-					if(0 == strcmp(type,UDINTstr)) {
-						out << "DTYPE_UNSIGNED32";
-						bitsize = 32;
-					} else
-					if(0 == strcmp(type,ULINTstr)) {
-						out << "DTYPE_UNSIGNED64";
-						bitsize = 64;
-					} else
-					{ // TODO handle more types?
-						printf("\033[0;31mWARNING:\033[0m %.04X:%.02X Unhandled Datatype '%s'\n",
-							obj->index,subitem,obj->type);
-						out << "DTYPE_UNSIGNED32"; // Default
-						bitsize = 32;
-					}
-					out << ", ";
+// OTYPE_... of an object
+const char* objectType(const Context& ctx, const Object* o, Part& part) {
+	if(o->subitems.empty()) return "OTYPE_VAR";
+	if(isArray(ctx,o)) {
+		part.logf("%04X is OTYPE_ARRAY ('%s')\n",o->index & 0xFFFF,o->type);
+		return "OTYPE_ARRAY";
+	}
+	return "OTYPE_RECORD";
+}
 
-					out << std::dec << (bitsize == 0 ? obj->bitsize : bitsize);
-				}
-				out << ", ";
-
-				// TODO handle the preRW and whatever in read/write-restrictions
-				if(NULL == flags ||
-					NULL == flags->access ||
-					0 == strcmp(flags->access->access,"ro"))
-				{
-					out << "ATYPE_RO";
-				} else
-				if(0 == strcmp(flags->access->access,"rw")) {
-					out << "ATYPE_RW";
-					if(flags->access->writerestrictions &&
-						0 == strcmp(flags->access->writerestrictions,"PreOP"))
-					{
-						out << "pre";
-					}
-				}
-				out << ", ";
-
-				out << "&acName"
-					<< std::hex
-					<< std::setfill('0')
-					<< std::setw(4)
-					<< std::uppercase
-					<< index;
-				if(nitems == 0) {
-					out << "[0]";
-				} else {
-					out << "_"
-						<< std::setw(2)
-						<< subitem
-						<< "[0]";
-				}
-				out << ", ";
-
-				if(!objref) {
-					if((index < 0x2000 || (0 == subitem || NULL == parent) && (0 != nitems))) {
-						if(0x1c12 == index && 0 != dynrxpdo) {
-							if(0 == subitem) {
-								out << "0x00, "
-								    << "&(" << sm2mappings_str << ".max_subindex) }";
-							} else {
-								out << "0x0000, "
-								    << "&(" << sm2mappings_str << ".subindex["
-								    << std::dec
-								    << (subitem - 1)
-								    << "]) }";
-							}
-						} else if(0x1c13 == index && 0 != dyntxpdo) {
-							if(0 == subitem) {
-								out << "0x00, "
-								    << "&(" << sm3mappings_str << ".max_subindex) }";
-							} else {
-								out << "0x0000, "
-								    << "&(" << sm3mappings_str << ".subindex["
-								    << std::dec
-								    << (subitem - 1)
-								    << "]) }";
-							}
-						} else if(NULL != obj->defaultdata) {
-							// TODO: can we assume data is hex or smth? HexDecStr...
-							if(strncmp(obj->defaultdata,"0x",2))
-								out << "0x";
-							out << std::hex;
-							if(m_input_endianness_is_little) {
-								for(size_t i = strlen(obj->defaultdata); i > 0; i-=2) {
-									char s[3];
-									strncpy(s,&(obj->defaultdata[i-2]),2);
-									s[2] = '\0';
-									out << s;
-								}
-							} else {
-								out << obj->defaultdata;
-							}
-							out << ", NULL }";
-						} else {
-							out << 0
-							    << ", NULL }";
-						}
-					} else { // Reference the objects from utypes.h
-						if(0 == nitems) {
-							out << "0, ";
-							out << "&";
-							out << CNameify(obj->name,params.capitalizeStructMembers);
-							if(params.appendObjectIndexToStructs) {
-								out << "0x"
-								<< std::hex
-								<< std::setfill('0')
-								<< std::setw(4)
-								<< std::uppercase
-								<< index;
-							}
-							out << " }";
-						} else {
-							out << "0, ";
-							out << "&(";
-							out << CNameify(parent->name,true);
-							if(params.appendObjectIndexToStructs) {
-								out << "0x"
-								<< std::hex
-								<< std::setfill('0')
-								<< std::setw(4)
-								<< std::uppercase
-								<< index;
-							}
-							out << ".";
-							out << CNameify(obj->name,params.capitalizeStructMembers);
-							out << ") }";
-						}
-					}
-				} else {
-					out << "0, ";
-					out << "&acValue"
-						<< std::hex
-						<< std::setfill('0')
-						<< std::setw(4)
-						<< std::uppercase
-						<< index;
-					out << "_00[0] }";
-				}
-				++subitem;
-				if(subitem < nitems) out << ",\n";
-			};
-
-			for(Object* o : dev->profile->dictionary->objects) {
-				int subitem = 0;
-				out << "const _objd SDO"
-					<< std::hex << std::setfill('0')
-					<< std::setw(4)
-					<< std::uppercase
-					<< (o->index & 0xFFFF);
-				out << "[] = {\n";
-				if(0x1C12 == o->index && dev->slots) {
-					// If we have slots, we will (most likely?) have dynamic mappable PDOs
-					// According to ETG5001 the module PDOs for modules should be in 0x1600-0x16FF
-					// Thus we assume any device specific PDOs will be in 0x1700 and above
-					// Above we made the SM[2/3]_MAPPING types. We will refer them here.
-				}
-				if(o->subitems.empty()) {
-					writeObject(o, NULL, subitem, 0, dev->profile->dictionary);
-				} else {
-					// TODO handle several levels?
-					for(Object* si : o->subitems) {
-						writeObject(si,o,subitem,o->subitems.size(),dev->profile->dictionary);
-					}
-				}
-				out << " };\n\n";
-			}
+// SDOobjects entries of objects [first,last) of objectlist.c
+void writeObjectList(const Context& ctx, size_t first, size_t last, Part& part) {
+	TextEmitter& out = part.out;
+	out.reserve(80*(last - first));
+	for(size_t i = first; i < last; ++i) {
+		Object* o = ctx.objects[i];
+		uint16_t index = o->index & 0xFFFF;
+		out << "{ 0x" << Hex(index,4);
+		out << ", ";
 
-			out << "const _objectlist objlist_end = { 0xFFFF, 0xFF, 0xFF, 0xFF, NULL, NULL };\n";
-			out << "\n";
-			out << "const _objectlist SDOobjects[] = {\n";
-			for(Object* o : dev->profile->dictionary->objects) {
-				uint16_t index = o->index & 0xFFFF;
-				out << "{ 0x"
-					<< std::hex
-					<< std::setfill('0')
-					<< std::setw(4)
-					<< std::uppercase
-					<< index;
-				out << ", ";
-
-				if(o->subitems.empty()) {
-					out << "OTYPE_VAR";
-				} else {
-					if(isArray(o)) {
-						printf("%04X is OTYPE_ARRAY ('%s')\n",index,o->type);
-						out << "OTYPE_ARRAY";
-					} else {
-						out << "OTYPE_RECORD";
-					}
-				}
-				out << ", ";
-
-				out << "0x"
-					<< std::hex
-					<< std::setfill('0')
-					<< std::setw(2)
-					<< (o->subitems.empty() ? 0 : o->subitems.size()-1);
-				out << ", ";
-
-				out << "0x0";
-				out << ", ";
-
-				out << "&acName"
-					<< std::hex
-					<< std::setfill('0')
-					<< std::setw(4)
-					<< std::uppercase
-					<< index << "[0]";
-				out << ", ";
-
-				out << "&SDO"
-					<< std::hex
-					<< std::setfill('0')
-					<< std::setw(4)
-					<< std::uppercase
-					<< index
-					<< "[0]";
-				out << " },\n";
-			}
-			out << "objlist_end };\n";
+		out << objectType(ctx,o,part);
+		out << ", ";
 
-			out << "\n";
+		out << "0x" << Hex(o->subitems.empty() ? 0 : o->subitems.size()-1,2);
+		out << ", ";
 
-			if(dynrxpdo) {
-				out << "_" << sm2mappings_str << " " << sm2mappings_str << " = {\n";
-				out << "\t" << ".max_subindex = " << std::dec << (int)dynrxpdo << ",\n";
-				out << "\t" << ".subindex = {\n";
-				for(Pdo* pdo : dev->rxpdo) if(!pdo->fixed) out << "\t\t0x" << std::hex << std::uppercase << pdo->index << ",\n";
-				out << "\t}\n";
-				out << "};\n";
-			}
+		out << "0x0";
+		out << ", ";
 
-			out << "\n";
+		out << "&acName" << Hex(index,4) << "[0]";
+		out << ", ";
 
-			if(dyntxpdo) {
-				out << "_" << sm3mappings_str << " " << sm3mappings_str << " = {\n";
-				out << "\t" << ".max_subindex = " << std::dec << (int)dyntxpdo << ",\n";
-				out << "\t" << ".subindex = {\n";
-				for(Pdo* pdo : dev->txpdo) if(!pdo->fixed) out << "\t\t0x" << std::hex << std::uppercase << pdo->index << ",\n";
-				out << "\t}\n";
-				out << "};\n";
-			}
+		out << "&SDO" << Hex(index,4) << "[0]";
+		out << " },\n";
+	}
+}
 
-			out << "\n";
+};
 
-			out.sync_with_stdio();
-			out.close();
-		} else {
-			printf("Could not open '%s' for writing object dictionary\n",objectdictfile.c_str());
+bool SOESConfigWriter::writeSSCFiles(Device* dev, OutputParams params) {
+	Context ctx;
+	initContext(ctx,dev,m_input_endianness_is_little,params);
+	const std::string modulesfile = "modules.h";
+	const bool modules = NULL != ctx.dictionary && NULL != dev->modules;
+
+	// The files and the chunks of objectlist.c are independent tasks, put
+	// together in order once all are done
+	Part options, types, moduletypes;
+	const size_t chunks = (ctx.objects.size() + SOES_OBJECTS_PER_CHUNK - 1)/SOES_OBJECTS_PER_CHUNK;
+	std::vector<Part> names(chunks), tables(chunks), list(chunks);
+	std::vector<std::function<void()>> tasks;
+	tasks.push_back([&ctx,&options]() {
+		ScopedTimer timer("Generate",ecatconfig);
+		writeOptions(ctx,options);
+	});
+	if(NULL != ctx.dictionary) {
+		tasks.push_back([&ctx,&types]() {
+			ScopedTimer timer("Generate",utypesfile);
+			writeTypes(ctx,types);
+		});
+	}
+	if(modules) {
+		tasks.push_back([&ctx,&modulesfile,&moduletypes]() {
+			ScopedTimer timer("Generate",modulesfile);
+			writeModules(ctx,modulesfile,moduletypes);
+		});
+	}
+	// The largest part, the tables, first so it does not end up last
+	for(size_t c = 0; c < chunks; ++c) {
+		size_t first = c*SOES_OBJECTS_PER_CHUNK;
+		size_t last = std::min(first + SOES_OBJECTS_PER_CHUNK,ctx.objects.size());
+		tasks.insert(tasks.begin() + c,[&ctx,&tables,c,first,last]() {
+			ScopedTimer timer("Generate",objectdictfile);
+			writeObjectTables(ctx,first,last,tables[c]);
+		});
+		tasks.push_back([&ctx,&names,&list,c,first,last]() {
+			ScopedTimer timer("Generate",objectdictfile);
+			writeObjectNames(ctx,first,last,names[c]);
+			writeObjectList(ctx,first,last,list[c]);
+		});
+	}
+	parallelFor(tasks.size(),params.jobs,[&tasks](size_t i) { tasks[i](); });
+
+	// A file that fails does not keep the others from being written
+	bool ok = true;
+	fputs(options.log.c_str(),stdout);
+	{
+		ScopedTimer timer("Write file",ecatconfig);
+		ok = writeFile(*m_sink,ecatconfig,options.out) && ok;
+	}
+
+	if(NULL != ctx.dictionary) {
+		fputs(types.log.c_str(),stdout);
+		{
+			ScopedTimer timer("Write file",utypesfile);
+			ok = writeFile(*m_sink,utypesfile,types.out) && ok;
 		}
-	} else {
-		printf("No dictionary could be parsed, writing boilerplate '%s' and '%s'\n",utypesfile.c_str(),objectdictfile.c_str());
-		std::ofstream typesout;
-		typesout.open(utypesfile.c_str(), std::ios::out | std::ios::trunc);
-		if(!typesout.fail()) {
-			typesout << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n\n";
-			typesout << "#ifndef __UTYPES_H__\n";
-			typesout << "#define __UTYPES_H__\n\n";
-			typesout << "#include <stdint.h>\n";
-			typesout << "\n";
-			typesout << "#endif /* UTYPES_H */\n";
-			typesout.sync_with_stdio();
-			typesout.close();
-		} else {
-			printf("Couldn't open '%s' for writing\n",utypesfile.c_str());
+
+		if(modules) {
+			fputs(moduletypes.log.c_str(),stdout);
+			ScopedTimer timer("Write file",modulesfile);
+			ok = writeFile(*m_sink,modulesfile,moduletypes.out) && ok;
 		}
-		std::ofstream objout;
-		objout.open(objectdictfile.c_str(), std::ios::out | std::ios::trunc);
-		if(!objout.fail()) {
-			objout << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n\n";
-			objout << "#include \"esc_coe.h\"\n";
-			objout << "const _objectlist SDOobjects[] = {\n";
-			objout << "{ 0xFFFF, 0xFF, 0xFF, 0xFF, NULL, NULL } };\n";
-			objout << "\n\n";
-			objout.sync_with_stdio();
-			objout.close();
-		} else {
-			printf("Couldn't open '%s' for writing\n",objectdictfile.c_str());
+
+		ScopedTimer timer("Write file",objectdictfile);
+		size_t size = 1024;
+		for(size_t c = 0; c < chunks; ++c) size += names[c].out.size() + tables[c].out.size() + list[c].out.size();
+		TextEmitter out(size);
+		printf("Writing SOES compatible object dictionary to '%s'\n",objectdictfile.c_str());
+		out << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n"
+		    << "#include \"esc_coe.h\"\n"
+		    << "#include \"" << utypesfile << "\"\n"
+		    << "#include <stddef.h>\n"
+		    << "\n";
+
+		// Generate string objects
+		for(const Part& part : names) {
+			fputs(part.log.c_str(),stdout);
+			out << part.out;
+		}
+		out << "\n";
+
+		for(const Part& part : tables) {
+			fputs(part.log.c_str(),stdout);
+			out << part.out;
 		}
+
+		out << "const _objectlist objlist_end = { 0xFFFF, 0xFF, 0xFF, 0xFF, NULL, NULL };\n";
+		out << "\n";
+		out << "const _objectlist SDOobjects[] = {\n";
+		for(const Part& part : list) {
+			fputs(part.log.c_str(),stdout);
+			out << part.out;
+		}
+		out << "objlist_end };\n";
+
+		out << "\n";
+
+		if(ctx.dynrxpdo) {
+			out << "_" << sm2mappings_str << " " << sm2mappings_str << " = {\n";
+			out << "\t" << ".max_subindex = " << (int)ctx.dynrxpdo << ",\n";
+			out << "\t" << ".subindex = {\n";
+			for(Pdo* pdo : dev->rxpdo) if(!pdo->fixed) out << "\t\t0x" << Hex(pdo->index) << ",\n";
+			out << "\t}\n";
+			out << "};\n";
+		}
+
+		out << "\n";
+
+		if(ctx.dyntxpdo) {
+			out << "_" << sm3mappings_str << " " << sm3mappings_str << " = {\n";
+			out << "\t" << ".max_subindex = " << (int)ctx.dyntxpdo << ",\n";
+			out << "\t" << ".subindex = {\n";
+			for(Pdo* pdo : dev->txpdo) if(!pdo->fixed) out << "\t\t0x" << Hex(pdo->index) << ",\n";
+			out << "\t}\n";
+			out << "};\n";
+		}
+
+		out << "\n";
+
+		ok = writeFile(*m_sink,objectdictfile,out) && ok;
+	} else {
+		printf("No dictionary could be parsed, writing boilerplate '%s' and '%s'\n",utypesfile.c_str(),objectdictfile.c_str());
+		TextEmitter typesout;
+		typesout << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n\n";
+		typesout << "#ifndef __UTYPES_H__\n";
+		typesout << "#define __UTYPES_H__\n\n";
+		typesout << "#include <stdint.h>\n";
+		typesout << "\n";
+		typesout << "#endif /* UTYPES_H */\n";
+		ok = writeFile(*m_sink,utypesfile,typesout) && ok;
+
+		TextEmitter objout;
+		objout << "/** Autogenerated by " << APP_NAME << " v" << APP_VERSION << " */\n\n";
+		objout << "#include \"esc_coe.h\"\n";
+		objout << "const _objectlist SDOobjects[] = {\n";
+		objout << "{ 0xFFFF, 0xFF, 0xFF, 0xFF, NULL, NULL } };\n";
+		objout << "\n\n";
+		ok = writeFile(*m_sink,objectdictfile,objout) && ok;
 	}
 
 	printf("Finished\n");
-};
\ No newline at end of file
+	return ok;
+};
+
+struct SOESValues::Impl {
+	Context ctx;
+	mutable CNames cnames;
+	mutable Part part; // Quiet, nobody prints the messages
+};
+
+SOESValues::SOESValues(const Device* dev, bool input_endianness_is_little, SSCWriter::OutputParams params) :
+	m_impl(new Impl)
+{
+	initContext(m_impl->ctx,dev,input_endianness_is_little,params);
+	m_impl->part.quiet = true;
+}
+
+SOESValues::~SOESValues() {
+};
+
+uint16_t SOESValues::dynRxPdos(void) const { return m_impl->ctx.dynrxpdo; };
+uint16_t SOESValues::dynTxPdos(void) const { return m_impl->ctx.dyntxpdo; };
+uint16_t SOESValues::maxMappingsSM2(void) const { return m_impl->ctx.max_mappings_sm2; };
+uint16_t SOESValues::maxMappingsSM3(void) const { return m_impl->ctx.max_mappings_sm3; };
+
+uint16_t SOESValues::mailboxSize(void) const {
+	uint16_t mbxsize;
+	uint8_t prealloc;
+	::mailboxSize(m_impl->ctx.dev,mbxsize,prealloc);
+	return mbxsize;
+}
+
+uint8_t SOESValues::preallocFactor(void) const {
+	uint16_t mbxsize;
+	uint8_t prealloc;
+	::mailboxSize(m_impl->ctx.dev,mbxsize,prealloc);
+	return prealloc;
+}
+
+uint16_t SOESValues::pdoSize(const SyncManager* sm) const {
+	return ::pdoSize(m_impl->ctx,sm,m_impl->part);
+}
+
+const char* SOESValues::objectType(const Object* o) const {
+	return ::objectType(m_impl->ctx,o,m_impl->part);
+}
+
+bool SOESValues::isString(const Object* o) {
+	return NULL != o->type && 0 == strncmp("STRING",o->type,5);
+}
+
+void SOESValues::stringValue(const Object* o, TextEmitter& out) const {
+	writeStringValue(out,o);
+}
+
+void SOESValues::varName(const Object* o, TextEmitter& out) const {
+	writeVarName(out,m_impl->ctx,m_impl->cnames,o);
+}
+
+const char* SOESValues::varType(const Object* o) const {
+	return ::varType(o,m_impl->part);
+}
+
+void SOESValues::rows(const Object* o, std::vector<Row>& rows) const {
+	rows.clear();
+	objectRows(m_impl->ctx,m_impl->part,o,[&rows](const Row& row) { rows.push_back(row); });
+}
+
+void SOESValues::members(const Object* o, std::vector<Member>& members) const {
+	members.clear();
+	structMembers(m_impl->ctx,o,m_impl->part,[&members](const Object* si, int subitem, const char* ctype) {
+		Member m;
+		m.object = si;
+		m.subindex = subitem;
+		m.ctype = ctype;
+		members.push_back(m);
+	});
+}
+
+void SOESValues::memberName(const Object* o, TextEmitter& out) const {
+	out << m_impl->cnames.get(o->name,m_impl->ctx.params.capitalizeStructMembers);
+}
+
+void SOESValues::value(const Row& row, TextEmitter& out) const {
+	writeRowValue(out,m_impl->ctx,row);
+}
+
+void SOESValues::data(const Row& row, TextEmitter& out) const {
+	writeRowData(out,m_impl->ctx,m_impl->cnames,row);
+}
@@ -1,16 +1,99 @@
 #ifndef SOESCONFIGWRITER_H
 #define SOESCONFIGWRITER_H
 #include "sscwriter.h"
+#include <memory>
 #include <string>
+#include <vector>
+
+class OutputSink;
+class TextEmitter;
 
 class SOESConfigWriter : public SSCWriter {
 public:
-	SOESConfigWriter(const std::string& outdir = "", bool input_endianness_is_little = false);
+	// Without a sink the files are written to outdir
+	SOESConfigWriter(const std::string& outdir = "", bool input_endianness_is_little = false, OutputSink* sink = NULL);
 	virtual ~SOESConfigWriter();
-	void writeSSCFiles(Device* dev, OutputParams params) override;
+	SOESConfigWriter(const SOESConfigWriter&) = delete;
+	SOESConfigWriter& operator=(const SOESConfigWriter&) = delete;
+	bool writeSSCFiles(Device* dev, OutputParams params) override;
 private:
 	std::string m_outputdir;
 	bool m_input_endianness_is_little;
+	OutputSink* m_sink;
+	bool m_ownsink;
+};
+
+/**
+ * What SOESConfigWriter derives from a device for its files, for templates
+ * writing the same files (templateengine.h). Messages of the derivation
+ * are dropped, the writer prints them. Struct and variable names follow
+ * the output parameters like those of the writer.
+ */
+class SOESValues {
+public:
+	// A row of the SDO table of an object in objectlist.c
+	struct Row {
+		enum Init : uint8_t {
+			None,		// 0, NULL
+			DefaultData,	// The default data, NULL
+			Mapping,	// A dynamic PDO mapping of SMx_MAPPINGS
+			Variable,	// The variable in utypes.h
+			Member,		// The member of the struct in utypes.h
+			String		// The acValue of the object
+		};
+		const Object* object = NULL;	// The object or the subitem
+		const Object* parent = NULL;
+		unsigned int subindex = 0;
+		bool decimal = false;		// The writer prints the subindex in decimal here
+		const char* dtype = NULL;	// NULL if the data type is unknown
+		uint32_t bitlength = 0;
+		const char* atype = "";		// Empty if the access is neither ro nor rw
+		Init init = None;
+		uint8_t sm = 0;			// Of a Mapping
+	};
+	// A struct member of an object in utypes.h
+	struct Member {
+		const Object* object = NULL;
+		unsigned int subindex = 0;
+		const char* ctype = NULL;
+	};
+
+	SOESValues(const Device* dev, bool input_endianness_is_little = false,
+		SSCWriter::OutputParams params = {});
+	~SOESValues();
+	SOESValues(const SOESValues&) = delete;
+	SOESValues& operator=(const SOESValues&) = delete;
+
+	// Dynamic Rx/TxPDOs, including one per slot
+	uint16_t dynRxPdos(void) const;
+	uint16_t dynTxPdos(void) const;
+	// PDO entries of SM2/SM3
+	uint16_t maxMappingsSM2(void) const;
+	uint16_t maxMappingsSM3(void) const;
+	// Mailbox size and preallocation factor of ecat_options.h, 0 if none
+	uint16_t mailboxSize(void) const;
+	uint8_t preallocFactor(void) const;
+	// Size of the PDOs of an Outputs/Inputs sync manager, else the default size
+	uint16_t pdoSize(const SyncManager* sm) const;
+
+	// OTYPE_... of an object in the object list
+	const char* objectType(const Object* o) const;
+	// Objects of a STRING type get an acValue
+	static bool isString(const Object* o);
+	void stringValue(const Object* o, TextEmitter& out) const;
+	// Name and C type of the variable of an object in utypes.h
+	void varName(const Object* o, TextEmitter& out) const;
+	const char* varType(const Object* o) const;
+	void rows(const Object* o, std::vector<Row>& rows) const;
+	void members(const Object* o, std::vector<Member>& members) const;
+	// Name of a struct member in utypes.h
+	void memberName(const Object* o, TextEmitter& out) const;
+	// The last two columns of a row
+	void value(const Row& row, TextEmitter& out) const;
+	void data(const Row& row, TextEmitter& out) const;
+private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
 };
 
 #endif /* SOESCONFIGWRITER_H */
\ No newline at end of file
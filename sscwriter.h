@@ -7,10 +7,12 @@ public:
 	struct OutputParams {
 		bool capitalizeStructMembers = false;
 		bool appendObjectIndexToStructs = false;
+		unsigned int jobs = 1; // Threads generating the files, 0: one per core
 	};
 
 	virtual ~SSCWriter() {};
-	virtual void writeSSCFiles(Device* dev, OutputParams params) = 0;
+	// False if a file could not be written, the sink reports which
+	virtual bool writeSSCFiles(Device* dev, OutputParams params) = 0;
 protected:
 	SSCWriter() {};
 };
@@ -0,0 +1,808 @@
+#include "templateengine.h"
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include "esctool.h"
+#include "esctoolhelpers.h"
+#include "soesconfigwriter.h"
+#include "textemitter.h"
+
+// Loops nested deeper are refused when compiling, so the scopes of a
+// render fit on the stack
+#define TEMPLATE_MAX_DEPTH 16
+
+namespace {
+
+enum Kind : uint8_t { KDevice, KObject, KPdo, KEntry, KModule, KSyncManager, KRow, KMember };
+
+// Text: a string the SOES writer writes out
+enum ValueType : uint8_t { Number, String, Text };
+
+enum Field : uint8_t {
+	F_N, F_First, F_Last,
+	F_DevName, F_DevType, F_DevPhysics, F_DevGroup, F_DevProductCode, F_DevRevision, F_DevVendorId,
+	F_DevEepromSize, F_DevCoE, F_DevFoE, F_DevEoE, F_DevSoE, F_DevSdoInfo, F_DevPdoAssign,
+	F_DevPdoConfig, F_DevCompleteAccess, F_DevDC, F_DevTool, F_DevToolVersion,
+	F_DevSlotIndexIncrement, F_DevSlotPdoIncrement, F_DevMaxSlots, F_DevDictionary, F_DevCapitalize,
+	F_DevAppendIndex,
+	F_ObjIndex, F_ObjName, F_ObjType, F_ObjBitsize, F_ObjBitoffset, F_ObjAccess, F_ObjDefault, F_ObjCType, F_ObjMaxSub,
+	F_ObjString,
+	F_PdoIndex, F_PdoName, F_PdoSM, F_PdoFixed, F_PdoMandatory, F_PdoDependOnSlot,
+	F_EntryIndex, F_EntrySubindex, F_EntryBitlen, F_EntryName, F_EntryDataType, F_EntryCType,
+	F_ModIdent, F_ModType,
+	F_SMType, F_SMStartAddress, F_SMDefaultSize, F_SMMinSize, F_SMMaxSize, F_SMControlByte, F_SMEnable,
+	// Derived by the SOES writer
+	F_DevDynRxPdos, F_DevDynTxPdos, F_DevDynRxPdoEnd, F_DevDynTxPdoEnd, F_DevMaxMappingsSM2,
+	F_DevMaxMappingsSM3, F_DevMbxSize, F_DevPreallocFactor,
+	F_ObjOType, F_ObjStringValue, F_ObjVariable, F_ObjVarName, F_ObjVarType,
+	F_SMPdoSize,
+	F_RowIndex, F_RowSubindex, F_RowDecimal, F_RowDType, F_RowString, F_RowBitlength, F_RowAType,
+	F_RowValue, F_RowData,
+	F_MemberIndex, F_MemberSubindex, F_MemberCType, F_MemberName,
+	F_Count
+};
+
+struct FieldDef {
+	Kind kind;
+	const char* name;
+	Field id;
+	ValueType type;
+};
+
+const FieldDef fields[] = {
+	{ KDevice, "name", F_DevName, String },
+	{ KDevice, "type", F_DevType, String },
+	{ KDevice, "physics", F_DevPhysics, String },
+	{ KDevice, "group", F_DevGroup, String },
+	{ KDevice, "productcode", F_DevProductCode, Number },
+	{ KDevice, "revision", F_DevRevision, Number },
+	{ KDevice, "vendorid", F_DevVendorId, Number },
+	{ KDevice, "eepromsize", F_DevEepromSize, Number },
+	{ KDevice, "coe", F_DevCoE, Number },
+	{ KDevice, "foe", F_DevFoE, Number },
+	{ KDevice, "eoe", F_DevEoE, Number },
+	{ KDevice, "soe", F_DevSoE, Number },
+	{ KDevice, "sdoinfo", F_DevSdoInfo, Number },
+	{ KDevice, "pdoassign", F_DevPdoAssign, Number },
+	{ KDevice, "pdoconfig", F_DevPdoConfig, Number },
+	{ KDevice, "completeaccess", F_DevCompleteAccess, Number },
+	{ KDevice, "dc", F_DevDC, Number },
+	{ KDevice, "tool", F_DevTool, String },
+	{ KDevice, "toolversion", F_DevToolVersion, String },
+	{ KDevice, "slotindexincrement", F_DevSlotIndexIncrement, Number },
+	{ KDevice, "slotpdoincrement", F_DevSlotPdoIncrement, Number },
+	{ KDevice, "maxslots", F_DevMaxSlots, Number },
+	{ KDevice, "dictionary", F_DevDictionary, Number },
+	{ KDevice, "capitalize", F_DevCapitalize, Number },
+	{ KDevice, "appendindex", F_DevAppendIndex, Number },
+	{ KDevice, "dynrxpdos", F_DevDynRxPdos, Number },
+	{ KDevice, "dyntxpdos", F_DevDynTxPdos, Number },
+	{ KDevice, "dynrxpdoend", F_DevDynRxPdoEnd, Number },
+	{ KDevice, "dyntxpdoend", F_DevDynTxPdoEnd, Number },
+	{ KDevice, "maxmappingssm2", F_DevMaxMappingsSM2, Number },
+	{ KDevice, "maxmappingssm3", F_DevMaxMappingsSM3, Number },
+	{ KDevice, "mbxsize", F_DevMbxSize, Number },
+	{ KDevice, "preallocfactor", F_DevPreallocFactor, Number },
+	{ KObject, "index", F_ObjIndex, Number },
+	{ KObject, "name", F_ObjName, String },
+	{ KObject, "type", F_ObjType, String },
+	{ KObject, "bitsize", F_ObjBitsize, Number },
+	{ KObject, "bitoffset", F_ObjBitoffset, Number },
+	{ KObject, "access", F_ObjAccess, String },
+	{ KObject, "default", F_ObjDefault, String },
+	{ KObject, "ctype", F_ObjCType, String },
+	{ KObject, "maxsub", F_ObjMaxSub, Number },
+	{ KObject, "string", F_ObjString, Number },
+	{ KObject, "otype", F_ObjOType, String },
+	{ KObject, "stringvalue", F_ObjStringValue, Text },
+	{ KObject, "variable", F_ObjVariable, Number },
+	{ KObject, "varname", F_ObjVarName, Text },
+	{ KObject, "vartype", F_ObjVarType, String },
+	{ KPdo, "index", F_PdoIndex, Number },
+	{ KPdo, "name", F_PdoName, String },
+	{ KPdo, "sm", F_PdoSM, Number },
+	{ KPdo, "fixed", F_PdoFixed, Number },
+	{ KPdo, "mandatory", F_PdoMandatory, Number },
+	{ KPdo, "dependonslot", F_PdoDependOnSlot, Number },
+	{ KEntry, "index", F_EntryIndex, Number },
+	{ KEntry, "subindex", F_EntrySubindex, Number },
+	{ KEntry, "bitlen", F_EntryBitlen, Number },
+	{ KEntry, "name", F_EntryName, String },
+	{ KEntry, "datatype", F_EntryDataType, String },
+	{ KEntry, "ctype", F_EntryCType, String },
+	{ KModule, "ident", F_ModIdent, Number },
+	{ KModule, "type", F_ModType, String },
+	{ KSyncManager, "type", F_SMType, String },
+	{ KSyncManager, "startaddress", F_SMStartAddress, Number },
+	{ KSyncManager, "defaultsize", F_SMDefaultSize, Number },
+	{ KSyncManager, "minsize", F_SMMinSize, Number },
+	{ KSyncManager, "maxsize", F_SMMaxSize, Number },
+	{ KSyncManager, "controlbyte", F_SMControlByte, Number },
+	{ KSyncManager, "enable", F_SMEnable, Number },
+	{ KSyncManager, "pdosize", F_SMPdoSize, Number },
+	{ KRow, "index", F_RowIndex, Number },
+	{ KRow, "subindex", F_RowSubindex, Number },
+	{ KRow, "decimal", F_RowDecimal, Number },
+	{ KRow, "dtype", F_RowDType, String },
+	{ KRow, "string", F_RowString, Number },
+	{ KRow, "bitlength", F_RowBitlength, Number },
+	{ KRow, "atype", F_RowAType, String },
+	{ KRow, "value", F_RowValue, Text },
+	{ KRow, "data", F_RowData, Text },
+	{ KMember, "index", F_MemberIndex, Number },
+	{ KMember, "subindex", F_MemberSubindex, Number },
+	{ KMember, "ctype", F_MemberCType, String },
+	{ KMember, "name", F_MemberName, Text },
+};
+
+// n, first and last of any loop item
+const FieldDef position = { KDevice, "n", F_N, Number };
+
+enum List : uint8_t { L_Objects, L_Subitems, L_DevRxPdos, L_DevTxPdos, L_ModRxPdos, L_ModTxPdos, L_Entries, L_Modules, L_SyncManagers,
+	L_Rows, L_Members };
+
+struct ListDef {
+	Kind kind;
+	const char* name;
+	List id;
+	Kind item;
+};
+
+const ListDef lists[] = {
+	{ KDevice, "objects", L_Objects, KObject },
+	{ KObject, "subitems", L_Subitems, KObject },
+	{ KDevice, "rxpdos", L_DevRxPdos, KPdo },
+	{ KDevice, "txpdos", L_DevTxPdos, KPdo },
+	{ KModule, "rxpdos", L_ModRxPdos, KPdo },
+	{ KModule, "txpdos", L_ModTxPdos, KPdo },
+	{ KPdo, "entries", L_Entries, KEntry },
+	{ KDevice, "modules", L_Modules, KModule },
+	{ KDevice, "syncmanagers", L_SyncManagers, KSyncManager },
+	{ KObject, "sdo", L_Rows, KRow },
+	{ KObject, "members", L_Members, KMember },
+};
+
+enum Format : uint8_t { FDefault, FHex, FLowerHex, FDecimal, FBool, FCName, FCNameUpper, FCString };
+
+// Fields and lists from F_DevDynRxPdos and L_Rows on are what the SOES
+// writer derives, a render sets that up only for templates using them
+bool isDerived(const FieldDef* f) { return f->id >= F_DevDynRxPdos; }
+bool isDerived(const ListDef* l) { return l->id >= L_Rows; }
+
+std::string_view trim(std::string_view s) {
+	while(!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+	while(!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+	return s;
+}
+
+bool blank(std::string_view s) {
+	for(char c : s)
+		if(c != ' ' && c != '\t') return false;
+	return true;
+}
+
+const char* cType(const char* type) {
+	if(NULL == type) return NULL;
+	if(0 == strncmp(type,BOOLstr,4) || 0 == strcmp(type,BITstr)) return "bool";
+	if(0 == strcmp(type,SINTstr)) return "int8_t";
+	if(0 == strcmp(type,INTstr)) return "int16_t";
+	if(0 == strcmp(type,DINTstr)) return "int32_t";
+	if(0 == strcmp(type,USINTstr)) return "uint8_t";
+	if(0 == strcmp(type,UINTstr)) return "uint16_t";
+	if(0 == strcmp(type,UDINTstr)) return "uint32_t";
+	if(0 == strcmp(type,ULINTstr)) return "uint64_t";
+	return NULL;
+}
+
+const char* objectType(const Object* o) {
+	if(o->type) return o->type;
+	if(o->datatype) return o->datatype->type ? o->datatype->type : o->datatype->name;
+	return NULL;
+}
+
+void writeNumber(TextEmitter& out, unsigned long long num, uint8_t format, uint8_t width) {
+	if(format == FHex || format == FLowerHex) {
+		out << TextEmitter::Hex(num,width,format == FHex);
+	} else
+	if(format == FDecimal) {
+		char digits[24];
+		std::to_chars_result r = std::to_chars(digits,digits + sizeof(digits),num);
+		for(long d = r.ptr - digits; d < width; ++d) out << '0';
+		out << std::string_view(digits,r.ptr - digits);
+	} else
+	if(format == FBool) {
+		out << (num ? "true" : "false");
+	} else {
+		out << num;
+	}
+}
+
+void writeString(TextEmitter& out, const char* s, uint8_t format) {
+	if(NULL == s) return;
+	if(format == FDefault) {
+		out << s;
+		return;
+	}
+	for(; *s; ++s) {
+		char c = *s;
+		if(format == FCName || format == FCNameUpper) {
+			if(c == ' ') c = '_';
+			else c = format == FCName ? std::tolower((unsigned char)c) : std::toupper((unsigned char)c);
+			out << c;
+		} else
+		if(c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else
+		if(c == '\n') {
+			out << "\\n";
+		} else
+		if((unsigned char)c < 0x20) {
+			// Octal, hex escapes would run into following digits
+			out << '\\' << (char)('0' + ((c >> 6) & 7)) << (char)('0' + ((c >> 3) & 7)) << (char)('0' + (c & 7));
+		} else {
+			out << c;
+		}
+	}
+}
+
+typedef SOESValues::Row Row;
+typedef SOESValues::Member Member;
+
+// Loop items: lists of the model hold pointers, those of SOESValues values
+template<typename T> const void* address(T* const& item) { return item; }
+template<typename T> const void* address(const T& item) { return &item; }
+
+};
+
+struct Template::Scope {
+	const void* item;
+	size_t n;
+	bool first;
+	bool last;
+};
+
+// What a render needs besides the scopes
+struct Template::State {
+	uint32_t vendorid;
+	SSCWriter::OutputParams params;
+	const SOESValues* soes;		 // Only for templates using derived values
+	TextEmitter text;		 // Strings the SOES writer makes
+	// Items of the sdo/members loops, per depth so a nested loop does not
+	// overwrite them and the buffers are reused from object to object
+	std::vector<Row> rows[TEMPLATE_MAX_DEPTH];
+	std::vector<Member> members[TEMPLATE_MAX_DEPTH];
+};
+
+// Value of number field F. The accessors are instantiated for every field,
+// so the switch folds to the one field and an op calls that directly
+template<uint8_t F>
+unsigned long long Template::number(const Scope& s, const State& state)
+{
+	const void* item = s.item;
+	const Device* dev = (const Device*)item;
+	const Object* o = (const Object*)item;
+	const Pdo* p = (const Pdo*)item;
+	const PdoEntry* e = (const PdoEntry*)item;
+	const Module* m = (const Module*)item;
+	const SyncManager* sm = (const SyncManager*)item;
+	const Row* row = (const Row*)item;
+	const Member* member = (const Member*)item;
+	const SOESValues* soes = state.soes;
+	switch(F) {
+		case F_N:			return s.n;
+		case F_First:			return s.first;
+		case F_Last:			return s.last;
+		case F_DevProductCode:		return dev->product_code;
+		case F_DevRevision:		return dev->revision_no;
+		case F_DevVendorId:		return state.vendorid;
+		case F_DevEepromSize:		return dev->eepromsize;
+		case F_DevCoE:			return dev->mailbox && dev->mailbox->coe;
+		case F_DevFoE:			return dev->mailbox && dev->mailbox->foe;
+		case F_DevEoE:			return dev->mailbox && dev->mailbox->eoe;
+		case F_DevSoE:			return dev->mailbox && dev->mailbox->soe;
+		case F_DevSdoInfo:		return dev->mailbox && dev->mailbox->coe_sdoinfo;
+		case F_DevPdoAssign:		return dev->mailbox && dev->mailbox->coe_pdoassign;
+		case F_DevPdoConfig:		return dev->mailbox && dev->mailbox->coe_pdoconfig;
+		case F_DevCompleteAccess:	return dev->mailbox && dev->mailbox->coe_completeaccess;
+		case F_DevDC:			return NULL != dev->dc;
+		case F_DevSlotIndexIncrement:	return dev->slots ? dev->slots->slotindexincrement : 0;
+		case F_DevSlotPdoIncrement:	return dev->slots ? dev->slots->slotpdoincrement : 0;
+		case F_DevMaxSlots:		return dev->slots ? dev->slots->maxslotcount : 0;
+		case F_DevDictionary:		return dev->profile && dev->profile->dictionary;
+		case F_DevCapitalize:		return state.params.capitalizeStructMembers;
+		case F_DevAppendIndex:		return state.params.appendObjectIndexToStructs;
+		case F_DevDynRxPdos:		return soes->dynRxPdos();
+		case F_DevDynTxPdos:		return soes->dynTxPdos();
+		case F_DevDynRxPdoEnd:		return 0x1600 + soes->dynRxPdos();
+		case F_DevDynTxPdoEnd:		return 0x1A00 + soes->dynTxPdos();
+		case F_DevMaxMappingsSM2:	return soes->maxMappingsSM2();
+		case F_DevMaxMappingsSM3:	return soes->maxMappingsSM3();
+		case F_DevMbxSize:		return soes->mailboxSize();
+		case F_DevPreallocFactor:	return soes->preallocFactor();
+		case F_ObjIndex:		return o->index;
+		case F_ObjBitsize:		return o->bitsize ? o->bitsize : (o->datatype ? o->datatype->bitsize : 0);
+		case F_ObjBitoffset:		return o->bitoffset;
+		case F_ObjMaxSub:		return o->subitems.empty() ? 0 : o->subitems.size() - 1;
+		case F_ObjString:		return SOESValues::isString(o);
+		case F_ObjVariable:		return (o->index & 0xFFFF) >= 0x2000;
+		case F_PdoIndex:		return p->index;
+		case F_PdoSM:			return p->syncmanager;
+		case F_PdoFixed:		return p->fixed;
+		case F_PdoMandatory:		return p->mandatory;
+		case F_PdoDependOnSlot:		return p->dependonslot;
+		case F_EntryIndex:		return e->index;
+		case F_EntrySubindex:		return e->subindex;
+		case F_EntryBitlen:		return e->bitlen;
+		case F_ModIdent:		return m->ident;
+		case F_SMStartAddress:		return sm->startaddress;
+		case F_SMDefaultSize:		return sm->defaultsize;
+		case F_SMMinSize:		return sm->minsize;
+		case F_SMMaxSize:		return sm->maxsize;
+		case F_SMControlByte:		return sm->controlbyte;
+		case F_SMEnable:		return sm->enable;
+		case F_SMPdoSize:		return soes->pdoSize(sm);
+		case F_RowIndex:		return row->object->index & 0xFFFF;
+		case F_RowSubindex:		return row->subindex;
+		case F_RowDecimal:		return row->decimal;
+		case F_RowString:		return row->init == Row::String;
+		case F_RowBitlength:		return row->bitlength;
+		case F_MemberIndex:		return member->object->index;
+		case F_MemberSubindex:		return member->subindex;
+		default:			return 0;
+	}
+}
+
+// Strings the SOES writer makes for field F, written straight to out.
+// False for any other field
+template<uint8_t F>
+bool Template::writeText(const Scope& s, State& state, TextEmitter& out)
+{
+	const SOESValues* soes = state.soes;
+	switch(F) {
+		case F_ObjStringValue:	soes->stringValue((const Object*)s.item,out); return true;
+		case F_ObjVarName:	soes->varName((const Object*)s.item,out); return true;
+		case F_RowValue:	soes->value(*(const Row*)s.item,out); return true;
+		case F_RowData:		soes->data(*(const Row*)s.item,out); return true;
+		case F_MemberName:	soes->memberName(((const Member*)s.item)->object,out); return true;
+		default:		return false;
+	}
+}
+
+// Value of string field F, NULL if it is missing. Strings made by the SOES
+// writer end up in state.text
+template<uint8_t F>
+const char* Template::string(const Scope& s, State& state)
+{
+	const void* item = s.item;
+	const Device* dev = (const Device*)item;
+	const Object* o = (const Object*)item;
+	const Pdo* p = (const Pdo*)item;
+	const PdoEntry* e = (const PdoEntry*)item;
+	const Module* m = (const Module*)item;
+	const SyncManager* sm = (const SyncManager*)item;
+	const Row* row = (const Row*)item;
+	const Member* member = (const Member*)item;
+	const SOESValues* soes = state.soes;
+	switch(F) {
+		case F_DevName:			return dev->name;
+		case F_DevType:			return dev->type;
+		case F_DevPhysics:		return dev->physics;
+		case F_DevGroup:		return dev->group ? dev->group->name : NULL;
+		case F_DevTool:			return APP_NAME;
+		case F_DevToolVersion:		return APP_VERSION;
+		case F_ObjName:			return o->name;
+		case F_ObjType:			return objectType(o);
+		case F_ObjAccess: {
+			const ObjectFlags* flags = o->flags ? o->flags : (o->datatype ? o->datatype->flags : NULL);
+			return flags && flags->access ? flags->access->access : NULL;
+		}
+		case F_ObjDefault:		return o->defaultstring ? o->defaultstring : o->defaultdata;
+		case F_ObjCType:		return cType(objectType(o));
+		case F_ObjOType:		return soes->objectType(o);
+		case F_ObjVarType:		return soes->varType(o);
+		case F_PdoName:			return p->name;
+		case F_EntryName:		return e->name;
+		case F_EntryDataType:		return e->datatype;
+		case F_EntryCType:		return cType(e->datatype);
+		case F_ModType:			return m->type;
+		case F_SMType:			return sm->type;
+		case F_RowDType:		return row->dtype;
+		case F_RowAType:		return row->atype;
+		case F_MemberCType:		return member->ctype;
+		default:
+			state.text.clear();
+			return writeText<F>(s,state,state.text) ? state.text.str().c_str() : NULL;
+	}
+}
+
+template<uint8_t F>
+void Template::emitNumber(const Op& op, const Scope& s, State& state, TextEmitter& out) {
+	writeNumber(out,number<F>(s,state),op.format,op.width);
+}
+
+template<uint8_t F>
+void Template::emitString(const Op& op, const Scope& s, State& state, TextEmitter& out) {
+	writeString(out,string<F>(s,state),op.format);
+}
+
+template<uint8_t F>
+void Template::emitText(const Op& op, const Scope& s, State& state, TextEmitter& out) {
+	writeText<F>(s,state,out);
+}
+
+// A number is set if not 0, or compared in decimal
+template<uint8_t F>
+bool Template::testNumber(const Op& op, const Scope& s, State& state, std::string_view value) {
+	unsigned long long num = number<F>(s,state);
+	if(!op.compare) return 0 != num;
+	char digits[24];
+	std::to_chars_result r = std::to_chars(digits,digits + sizeof(digits),num);
+	return value == std::string_view(digits,r.ptr - digits);
+}
+
+// A string is set if there is one and it is not empty
+template<uint8_t F>
+bool Template::testString(const Op& op, const Scope& s, State& state, std::string_view value) {
+	const char* str = string<F>(s,state);
+	if(NULL == str) return false;
+	return op.compare ? value == str : '\0' != *str;
+}
+
+// The accessors of every field, indexed by Field
+struct Template::Accessors {
+	template<uint8_t... F>
+	static void pick(Op& op, ValueType type, std::integer_sequence<uint8_t,F...>) {
+		static const Emit numbers[] = { &emitNumber<F>... };
+		static const Emit strings[] = { &emitString<F>... };
+		static const Emit texts[] = { &emitText<F>... };
+		static const Test numbertests[] = { &testNumber<F>... };
+		static const Test stringtests[] = { &testString<F>... };
+		if(op.code == Op::If) {
+			op.test = type == Number ? numbertests[op.id] : stringtests[op.id];
+		} else {
+			// Text needing no formatting goes straight to the output
+			op.emit = type == Number ? numbers[op.id] :
+				(type == Text && op.format == FDefault ? texts[op.id] : strings[op.id]);
+		}
+	}
+	static void pick(Op& op, ValueType type) {
+		pick(op,type,std::make_integer_sequence<uint8_t,F_Count>());
+	}
+};
+
+bool Template::compile(std::string_view text, std::string& error) {
+	m_ops.clear();
+	m_text.clear();
+	m_derived = false;
+
+	auto fail = [&](size_t pos, const std::string& reason) {
+		size_t line = 1;
+		for(size_t i = 0; i < pos && i < text.size(); ++i)
+			if(text[i] == '\n') ++line;
+		error = "line " + std::to_string(line) + ": " + reason;
+		m_ops.clear();
+		m_text.clear();
+		return false;
+	};
+	// Text around a comment extends the text before it, never across the
+	// start or end of a section
+	bool extend = false;
+	auto addText = [&](std::string_view s) {
+		if(s.empty()) return;
+		if(extend) {
+			m_ops.back().length += s.size();
+		} else {
+			Op op;
+			op.offset = m_text.size();
+			op.length = s.size();
+			m_ops.push_back(op);
+			extend = true;
+		}
+		m_text.append(s);
+	};
+
+	// Kinds of the scopes while rendering, the device scope outermost
+	std::vector<Kind> kinds { KDevice };
+	struct Open {
+		std::string_view name;
+		size_t op;
+		bool loop;
+	};
+	std::vector<Open> open;
+
+	// "../" prefixes skip scopes, the rest is looked up from there outward
+	auto scopes = [&](std::string_view& name) {
+		uint8_t up = 0;
+		while(name.substr(0,3) == "../") {
+			name.remove_prefix(3);
+			++up;
+		}
+		return up;
+	};
+	auto findField = [&](std::string_view name, Op& op) {
+		uint8_t up = scopes(name);
+		for(size_t i = up; i < kinds.size(); ++i) {
+			size_t level = kinds.size() - 1 - i;
+			if(level > 0 && (name == "n" || name == "first" || name == "last")) {
+				op.up = i;
+				op.id = name == "n" ? F_N : (name == "first" ? F_First : F_Last);
+				return &position;
+			}
+			for(const FieldDef& f : fields) {
+				if(f.kind == kinds[level] && name == f.name) {
+					op.up = i;
+					op.id = f.id;
+					if(isDerived(&f)) m_derived = true;
+					return &f;
+				}
+			}
+		}
+		return (const FieldDef*)NULL;
+	};
+	auto findList = [&](std::string_view name, Op& op) {
+		uint8_t up = scopes(name);
+		for(size_t i = up; i < kinds.size(); ++i) {
+			size_t level = kinds.size() - 1 - i;
+			for(const ListDef& l : lists) {
+				if(l.kind == kinds[level] && name == l.name) {
+					op.up = i;
+					op.id = l.id;
+					if(isDerived(&l)) m_derived = true;
+					return &l;
+				}
+			}
+		}
+		return (const ListDef*)NULL;
+	};
+	// Digits of a hexN/decN format
+	auto width = [](std::string_view digits, Op& op) {
+		if(digits.size() > 2) return false;
+		for(char c : digits) {
+			if(c < '0' || c > '9') return false;
+			op.width = op.width * 10 + (c - '0');
+		}
+		return true;
+	};
+
+	size_t pos = 0;
+	size_t textstart = 0;
+	for(;;) {
+		size_t tag = text.find("{{",pos);
+		if(tag == std::string_view::npos) {
+			addText(text.substr(textstart));
+			break;
+		}
+		size_t close = text.find("}}",tag + 2);
+		if(close == std::string_view::npos) return fail(tag,"'{{' without '}}'");
+		std::string_view body = trim(text.substr(tag + 2,close - tag - 2));
+		size_t after = close + 2;
+		size_t textend = tag;
+		char sigil = body.empty() ? '\0' : body[0];
+		if('\0' == sigil || NULL == strchr("#/?^!",sigil)) sigil = '\0';
+
+		// A section or comment alone on its line takes the line with it
+		if('\0' != sigil) {
+			size_t linestart = tag == 0 ? std::string_view::npos : text.rfind('\n',tag - 1);
+			linestart = linestart == std::string_view::npos ? 0 : linestart + 1;
+			if(linestart >= textstart && blank(text.substr(linestart,tag - linestart))) {
+				size_t e = after;
+				while(e < text.size() && (text[e] == ' ' || text[e] == '\t' || text[e] == '\r')) ++e;
+				if(e == text.size() || text[e] == '\n') {
+					textend = linestart;
+					after = e < text.size() ? e + 1 : e;
+				}
+			}
+		}
+		addText(text.substr(textstart,textend - textstart));
+		pos = textstart = after;
+
+		std::string_view name = trim(body.substr(sigil == '\0' ? 0 : 1));
+		if(sigil == '!') {
+			continue;
+		}
+		extend = false;
+		if(sigil == '#') {
+			Op op;
+			op.code = Op::Loop;
+			const ListDef* l = findList(name,op);
+			if(NULL == l) return fail(tag,"no list '" + std::string(name) + "' here");
+			if(kinds.size() >= TEMPLATE_MAX_DEPTH) return fail(tag,"loops nested too deep");
+			open.push_back({ name, m_ops.size(), true });
+			kinds.push_back(l->item);
+			m_ops.push_back(op);
+		} else
+		if(sigil == '?' || sigil == '^') {
+			Op op;
+			op.code = Op::If;
+			op.invert = sigil == '^';
+			size_t equals = name.find('=');
+			const FieldDef* f;
+			if(equals != std::string_view::npos) {
+				std::string_view value = trim(name.substr(equals + 1));
+				name = trim(name.substr(0,equals));
+				if(NULL == (f = findField(name,op))) return fail(tag,"no field '" + std::string(name) + "' here");
+				op.compare = true;
+				op.offset = m_text.size();
+				op.length = value.size();
+				m_text.append(value);
+				Accessors::pick(op,f->type);
+			} else
+			if(NULL != (f = findField(name,op))) {
+				Accessors::pick(op,f->type);
+			} else {
+				if(NULL == findList(name,op)) return fail(tag,"no field or list '" + std::string(name) + "' here");
+				op.list = true;
+			}
+			open.push_back({ name, m_ops.size(), false });
+			m_ops.push_back(op);
+		} else
+		if(sigil == '/') {
+			if(open.empty()) return fail(tag,"'{{/" + std::string(name) + "}}' closes nothing");
+			if(open.back().name != name)
+				return fail(tag,"'{{/" + std::string(name) + "}}' closes '" + std::string(open.back().name) + "'");
+			m_ops[open.back().op].end = m_ops.size();
+			if(open.back().loop) kinds.pop_back();
+			open.pop_back();
+		} else {
+			Op op;
+			op.code = Op::Value;
+			std::string_view format;
+			size_t bar = name.find('|');
+			if(bar != std::string_view::npos) {
+				format = trim(name.substr(bar + 1));
+				name = trim(name.substr(0,bar));
+			}
+			const FieldDef* f = findField(name,op);
+			if(NULL == f) return fail(tag,"no field '" + std::string(name) + "' here");
+			if(format.empty()) {
+				op.format = FDefault;
+			} else
+			if(f->type == Number && (format.substr(0,3) == "hex" || format.substr(0,4) == "lhex")) {
+				op.format = format[0] == 'l' ? FLowerHex : FHex;
+				std::string_view digits = format.substr(format[0] == 'l' ? 4 : 3);
+				if(!width(digits,op)) return fail(tag,"bad width '" + std::string(digits) + "'");
+			} else
+			if(f->type == Number && format == "dec") {
+				op.format = FDefault;
+			} else
+			if(f->type == Number && format.substr(0,3) == "dec") {
+				op.format = FDecimal;
+				std::string_view digits = format.substr(3);
+				if(!width(digits,op)) return fail(tag,"bad width '" + std::string(digits) + "'");
+			} else
+			if(f->type == Number && format == "bool") {
+				op.format = FBool;
+			} else
+			if(f->type != Number && format == "cname") {
+				op.format = FCName;
+			} else
+			if(f->type != Number && format == "CNAME") {
+				op.format = FCNameUpper;
+			} else
+			if(f->type != Number && format == "cstr") {
+				op.format = FCString;
+			} else {
+				return fail(tag,"format '" + std::string(format) + "' does not apply to '" + std::string(name) + "'");
+			}
+			Accessors::pick(op,f->type);
+			m_ops.push_back(op);
+		}
+	}
+	if(!open.empty())
+		return fail(text.size(),"'" + std::string(open.back().name) + "' is not closed");
+	return true;
+}
+
+bool Template::load(const std::string& file, std::string& error) {
+	FILE* f = fopen(file.c_str(),"rb");
+	if(NULL == f) {
+		error = "can not open '" + file + "'";
+		return false;
+	}
+	std::string text;
+	char buf[65536];
+	for(size_t n; (n = fread(buf,1,sizeof(buf),f)) > 0; ) text.append(buf,n);
+	bool readerror = ferror(f);
+	fclose(f);
+	if(readerror) {
+		error = "can not read '" + file + "'";
+		return false;
+	}
+	if(!compile(text,error)) {
+		error = file + ": " + error;
+		return false;
+	}
+	return true;
+}
+
+void Template::render(const Device* dev, uint32_t vendorid, TextEmitter& out, bool little,
+	SSCWriter::OutputParams params) const
+{
+	std::unique_ptr<SOESValues> values;
+	if(m_derived) values.reset(new SOESValues(dev,little,params));
+	render(dev,vendorid,out,values.get(),params);
+}
+
+void Template::render(const Device* dev, uint32_t vendorid, TextEmitter& out, const SOESValues* values,
+	SSCWriter::OutputParams params) const
+{
+	Scope scopes[TEMPLATE_MAX_DEPTH];
+	scopes[0] = { dev, 0, true, true };
+	State state { vendorid, params, values, TextEmitter(256), {}, {} };
+	render(0,m_ops.size(),scopes,0,state,out);
+}
+
+// Items of a list, for a Loop rendered each with its own scope
+template<typename Items>
+bool Template::each(const Items& items, size_t i, Scope* scopes, int depth, State& state, TextEmitter& out) const {
+	const Op& op = m_ops[i];
+	if(op.code != Op::Loop) return !items.empty();
+	size_t n = 0;
+	size_t count = items.size();
+	for(const auto& item : items) {
+		scopes[depth + 1] = { address(item), n, n == 0, n + 1 == count };
+		render(i + 1,op.end,scopes,depth + 1,state,out);
+		++n;
+	}
+	return 0 != count;
+}
+
+// Renders the items of a Loop, for an If returns if the list has any
+bool Template::list(size_t i, Scope* scopes, int depth, State& state, TextEmitter& out) const {
+	const Op& op = m_ops[i];
+	const Scope& s = scopes[depth - op.up];
+	const Device* dev = (const Device*)s.item;
+	const Module* m = (const Module*)s.item;
+	switch(op.id) {
+		case L_Objects:
+			if(NULL == dev->profile || NULL == dev->profile->dictionary) return false;
+			return each(dev->profile->dictionary->objects,i,scopes,depth,state,out);
+		case L_Subitems:	return each(((const Object*)s.item)->subitems,i,scopes,depth,state,out);
+		case L_DevRxPdos:	return each(dev->rxpdo,i,scopes,depth,state,out);
+		case L_DevTxPdos:	return each(dev->txpdo,i,scopes,depth,state,out);
+		case L_ModRxPdos:	return each(m->rxpdo,i,scopes,depth,state,out);
+		case L_ModTxPdos:	return each(m->txpdo,i,scopes,depth,state,out);
+		case L_Entries:		return each(((const Pdo*)s.item)->entries,i,scopes,depth,state,out);
+		case L_Modules:
+			if(NULL == dev->modules) return false;
+			return each(*dev->modules,i,scopes,depth,state,out);
+		case L_SyncManagers:	return each(dev->syncmanagers,i,scopes,depth,state,out);
+		case L_Rows:
+			state.soes->rows((const Object*)s.item,state.rows[depth]);
+			return each(state.rows[depth],i,scopes,depth,state,out);
+		case L_Members:
+			state.soes->members((const Object*)s.item,state.members[depth]);
+			return each(state.members[depth],i,scopes,depth,state,out);
+		default:
+			return false;
+	}
+}
+
+void Template::render(size_t first, size_t last, Scope* scopes, int depth, State& state, TextEmitter& out) const {
+	for(size_t i = first; i < last; ++i) {
+		const Op& op = m_ops[i];
+		const Scope& s = scopes[depth - op.up];
+		switch(op.code) {
+			case Op::Text:
+				out << std::string_view(m_text.data() + op.offset,op.length);
+				break;
+			case Op::Value:
+				op.emit(op,s,state,out);
+				break;
+			case Op::Loop:
+				list(i,scopes,depth,state,out);
+				i = op.end - 1;
+				break;
+			case Op::If: {
+				bool set = op.list ? list(i,scopes,depth,state,out) :
+					op.test(op,s,state,std::string_view(m_text.data() + op.offset,op.length));
+				if(set != op.invert) render(i + 1,op.end,scopes,depth,state,out);
+				i = op.end - 1;
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#ifndef TEMPLATEENGINE_H
+#define TEMPLATEENGINE_H
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "esctooldefs.h"
+#include "sscwriter.h"
+
+class TextEmitter;
+class SOESValues;
+
+/**
+ * Text template for generated sources, compiled once into a list of
+ * instructions and rendered against any number of device models.
+ *
+ * Everything outside of tags is copied. Tags:
+ *   {{field}} {{field|format}}  value of a field of the innermost scope
+ *                               that has it, {{../field}} starts one
+ *                               scope further out
+ *   {{#list}} ... {{/list}}     repeated for every item of a list
+ *   {{?cond}} ... {{/cond}}     only if the field is not 0/empty, the list
+ *                               is not empty, or for first/last the item is
+ *                               the first/last of its loop
+ *   {{?field=text}} ... {{/field}} only if the field is the text (numbers
+ *                               in decimal)
+ *   {{^cond}} ... {{/cond}}     the opposite
+ *   {{! comment}}
+ * A line holding nothing but a section or comment tag produces no output.
+ *
+ * Scopes, their fields and lists:
+ *   device       name type physics group productcode revision vendorid
+ *                eepromsize coe foe eoe soe sdoinfo pdoassign pdoconfig
+ *                completeaccess dc tool toolversion slotindexincrement
+ *                slotpdoincrement maxslots dictionary capitalize appendindex
+ *                #objects #rxpdos #txpdos #modules #syncmanagers
+ *   objects      index name type bitsize bitoffset access default ctype
+ *                maxsub string #subitems (Objects again)
+ *   rxpdos/txpdos index name sm fixed mandatory dependonslot #entries
+ *   entries      index subindex bitlen name datatype ctype
+ *   modules      ident type #rxpdos #txpdos
+ *   syncmanagers type startaddress defaultsize minsize maxsize controlbyte
+ *                enable
+ * Every loop item also has n (position from 0), first and last.
+ *
+ * What SOESConfigWriter derives (SOESValues) is there as well:
+ *   device       dynrxpdos dyntxpdos dynrxpdoend dyntxpdoend maxmappingssm2
+ *                maxmappingssm3 mbxsize preallocfactor
+ *   objects      otype stringvalue variable varname vartype #sdo #members
+ *   syncmanagers pdosize
+ *   sdo          index subindex decimal dtype string bitlength atype value
+ *                data (the rows of the SDO table of objectlist.c)
+ *   members      index subindex ctype name (the struct in utypes.h)
+ * templates/ has the files of the writer written this way.
+ *
+ * Formats: numbers dec (default), decN (N digits, zero padded), hex, hexN
+ * (N digits, upper case), lhex, lhexN (lower case) and bool (true/false).
+ * Strings cname (lower case C identifier), CNAME (upper case) and cstr
+ * (escaped for a C string literal). Missing strings render empty.
+ */
+class Template {
+public:
+	Template() {};
+
+	// Parses the template, error gets the line and reason on failure
+	bool compile(std::string_view text, std::string& error);
+	bool load(const std::string& file, std::string& error);
+	// little and params as for SOESConfigWriter, for the values it derives
+	void render(const Device* dev, uint32_t vendorid, TextEmitter& out, bool little = false,
+		SSCWriter::OutputParams params = {}) const;
+	// With values made once for all templates of dev, with the same
+	// params. May be NULL if no template uses derived()
+	void render(const Device* dev, uint32_t vendorid, TextEmitter& out, const SOESValues* values,
+		SSCWriter::OutputParams params = {}) const;
+
+	size_t instructions(void) const { return m_ops.size(); };
+	// Uses values SOESConfigWriter derives
+	bool derived(void) const { return m_derived; };
+private:
+	struct Op;
+	struct Scope;
+	struct State;
+	struct Accessors;
+	// Accessors of one field, picked when compiling: writes the value of
+	// a Value, tests the field of an If against the text of the op
+	typedef void (*Emit)(const Op& op, const Scope& s, State& state, TextEmitter& out);
+	typedef bool (*Test)(const Op& op, const Scope& s, State& state, std::string_view value);
+
+	struct Op {
+		enum Code : uint8_t { Text, Value, Loop, If };
+		Code code = Text;
+		uint8_t up = 0;		// Scopes outward from the innermost
+		uint8_t id = 0;		// Field, or list of a Loop/If
+		uint8_t format = 0;
+		uint8_t width = 0;
+		bool list = false;	// If tests a list
+		bool compare = false;	// If compares the field with the text
+		bool invert = false;
+		uint32_t offset = 0;	// Text in m_text
+		uint32_t length = 0;
+		uint32_t end = 0;	// Loop/If: first instruction after the section
+		Emit emit = NULL;
+		Test test = NULL;	// If of a field
+	};
+
+	template<uint8_t F> static unsigned long long number(const Scope& s, const State& state);
+	template<uint8_t F> static const char* string(const Scope& s, State& state);
+	template<uint8_t F> static bool writeText(const Scope& s, State& state, TextEmitter& out);
+	template<uint8_t F> static void emitNumber(const Op& op, const Scope& s, State& state, TextEmitter& out);
+	template<uint8_t F> static void emitString(const Op& op, const Scope& s, State& state, TextEmitter& out);
+	template<uint8_t F> static void emitText(const Op& op, const Scope& s, State& state, TextEmitter& out);
+	template<uint8_t F> static bool testNumber(const Op& op, const Scope& s, State& state, std::string_view value);
+	template<uint8_t F> static bool testString(const Op& op, const Scope& s, State& state, std::string_view value);
+	template<typename Items>
+	bool each(const Items& items, size_t i, Scope* scopes, int depth, State& state, TextEmitter& out) const;
+	bool list(size_t i, Scope* scopes, int depth, State& state, TextEmitter& out) const;
+	void render(size_t first, size_t last, Scope* scopes, int depth, State& state, TextEmitter& out) const;
+
+	std::vector<Op> m_ops;
+	std::string m_text;
+	bool m_derived = false; // Uses values SOESValues derives
+};
+
+#endif /* TEMPLATEENGINE_H */
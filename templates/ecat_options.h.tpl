@@ -0,0 +1,65 @@
+{{! ecat_options.h as SOESConfigWriter writes it }}
+/** Autogenerated by {{tool}} v{{toolversion}} */
+
+#ifndef __ECAT_OPTIONS_H__
+#define __ECAT_OPTIONS_H__
+
+#include "cc.h"
+
+#define USE_FOE          {{foe}}
+#define USE_EOE          {{eoe}}
+
+{{?mbxsize}}
+#define MBXSIZE            {{mbxsize}}
+#define MBXSIZEBOOT        {{mbxsize}}
+{{?preallocfactor}}
+#define PREALLOC_FACTOR    {{preallocfactor}}
+{{/preallocfactor}}
+
+{{/mbxsize}}
+{{#syncmanagers}}
+{{?type=MBoxOut}}
+#define MBX0_sma         0x{{startaddress|lhex}}
+#define MBX0_sml         {{defaultsize}}
+#define MBX0_sme         MBX0_sma+MBX0_sml-1
+#define MBX0_smc         0x{{controlbyte|lhex}}
+#define MBX0_sma_b       0x{{startaddress|lhex}}
+#define MBX0_sml_b       {{defaultsize}}
+#define MBX0_sme_b       MBX0_sma_b+MBX0_sml_b-1
+#define MBX0_smc_B       0x{{controlbyte|lhex}}
+
+{{/type}}
+{{?type=MBoxIn}}
+#define MBX1_sma         0x{{startaddress|lhex}}
+#define MBX1_sml         {{defaultsize}}
+#define MBX1_sme         MBX1_sma+MBX1_sml-1
+#define MBX1_smc         0x{{controlbyte|lhex}}
+#define MBX1_sma_b       0x{{startaddress|lhex}}
+#define MBX1_sml_b       {{defaultsize}}
+#define MBX1_sme_b       MBX1_sma_b+MBX1_sml_b-1
+#define MBX1_smc_b       0x{{controlbyte|lhex}}
+
+{{/type}}
+{{?type=Outputs}}
+#define SM2_sma          0x{{startaddress|lhex}}
+#define SM2_smc          0x{{controlbyte|lhex}}
+#define SM2_act          {{enable}}
+#define MAX_RXPDO_SIZE   {{pdosize}}
+#ifndef MAX_MAPPINGS_SM2
+#define MAX_MAPPINGS_SM2 {{maxmappingssm2}}
+#endif /* MAX_MAPPINGS_SM2 */
+
+{{/type}}
+{{?type=Inputs}}
+#define SM3_sma          0x{{startaddress|lhex}}
+#define SM3_smc          0x{{controlbyte|lhex}}
+#define SM3_act          {{enable}}
+#define MAX_TXPDO_SIZE   {{pdosize}}
+#ifndef MAX_MAPPINGS_SM3
+#define MAX_MAPPINGS_SM3 {{maxmappingssm3}}
+#endif /* MAX_MAPPINGS_SM3 */
+
+{{/type}}
+{{/syncmanagers}}
+
+#endif /* __ECAT_OPTIONS_H__ */
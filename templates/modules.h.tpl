@@ -0,0 +1,46 @@
+{{! modules.h as SOESConfigWriter writes it, for devices with modules }}
+/** Autogenerated by {{tool}} v{{toolversion}} */
+#ifndef __{{name|CNAME}}_MODULES_H__
+#define __{{name|CNAME}}_MODULES_H__
+#include <stddef.h>
+#include <stdint.h>
+
+#define MODULE_SLOT_INDEX_INCREMENT		({{slotindexincrement}})
+#define MODULE_SLOT_PDO_INCREMENT		({{slotpdoincrement}})
+
+{{#modules}}
+#define {{type|CNAME}}_IDENT		({{ident}})
+typedef struct {{?capitalize}}{{type|CNAME}}{{/capitalize}}{{^capitalize}}{{type|cname}}{{/capitalize}} {
+{{#rxpdos}}
+	/* RXPDO @ 0x{{index|hex}} */
+{{?dependonslot}}
+	/* Index is slot dependent: real-index = index + (slot * MODULE_SLOT_INDEX_INCREMENT) */
+{{/dependonslot}}
+{{#entries}}
+	{{ctype}} {{?capitalize}}{{name|CNAME}}{{/capitalize}}{{^capitalize}}{{name|cname}}{{/capitalize}}; /* {{../index|hex4}}.{{subindex|hex2}} */
+{{/entries}}
+{{^last}}
+
+{{/last}}
+{{/rxpdos}}
+{{?rxpdos}}
+{{?txpdos}}
+
+{{/txpdos}}
+{{/rxpdos}}
+{{#txpdos}}
+	/* TXPDO @ 0x{{index|hex}} */
+{{?dependonslot}}
+	/* Index is slot dependent: real-index = index + (slot * MODULE_SLOT_INDEX_INCREMENT) */
+{{/dependonslot}}
+{{#entries}}
+	{{ctype}} {{?capitalize}}{{name|CNAME}}{{/capitalize}}{{^capitalize}}{{name|cname}}{{/capitalize}}; /* {{../index|hex4}}.{{subindex|hex2}} */
+{{/entries}}
+{{^last}}
+
+{{/last}}
+{{/txpdos}}
+} {{?capitalize}}{{type|CNAME}}{{/capitalize}}{{^capitalize}}{{type|cname}}{{/capitalize}}_t;
+
+{{/modules}}
+#endif /* __{{name|CNAME}}_MODULES_H__ */
@@ -0,0 +1,70 @@
+{{! objectlist.c as SOESConfigWriter writes it }}
+{{?dictionary}}
+/** Autogenerated by {{tool}} v{{toolversion}} */
+#include "esc_coe.h"
+#include "utypes.h"
+#include <stddef.h>
+
+{{#objects}}
+static const char acName{{index|hex4}}[] = "{{name}}";
+{{#subitems}}
+static const char acName{{index|hex4}}_{{n|hex2}}[] = "{{?first}}Max SubIndex{{/first}}{{^first}}{{name}}{{/first}}";
+{{/subitems}}
+{{?string}}
+static char acValue{{index|hex4}}_00[] = "{{stringvalue}}";
+{{/string}}
+{{/objects}}
+
+{{#objects}}
+const _objd SDO{{index|hex4}}[] = {
+{{#sdo}}
+{ 0x{{?decimal}}{{subindex|dec2}}{{/decimal}}{{^decimal}}{{subindex|hex2}}{{/decimal}}, {{?dtype}}{{dtype}}, {{?string}}sizeof(acValue{{index|hex4}}_00) << 3{{/string}}{{^string}}{{bitlength}}{{/string}}{{/dtype}}, {{atype}}, &acName{{index|hex4}}{{?../subitems}}_{{subindex|hex2}}{{/../subitems}}[0], {{value}}, {{data}} }{{^last}},
+{{/last}}
+{{/sdo}}
+ };
+
+{{/objects}}
+const _objectlist objlist_end = { 0xFFFF, 0xFF, 0xFF, 0xFF, NULL, NULL };
+
+const _objectlist SDOobjects[] = {
+{{#objects}}
+{ 0x{{index|hex4}}, {{otype}}, 0x{{maxsub|hex2}}, 0x0, &acName{{index|hex4}}[0], &SDO{{index|hex4}}[0] },
+{{/objects}}
+objlist_end };
+
+{{?dynrxpdos}}
+_SM2_MAPPINGS SM2_MAPPINGS = {
+	.max_subindex = {{dynrxpdos}},
+	.subindex = {
+{{#rxpdos}}
+{{^fixed}}
+		0x{{index|hex}},
+{{/fixed}}
+{{/rxpdos}}
+	}
+};
+{{/dynrxpdos}}
+
+{{?dyntxpdos}}
+_SM3_MAPPINGS SM3_MAPPINGS = {
+	.max_subindex = {{dyntxpdos}},
+	.subindex = {
+{{#txpdos}}
+{{^fixed}}
+		0x{{index|hex}},
+{{/fixed}}
+{{/txpdos}}
+	}
+};
+{{/dyntxpdos}}
+
+{{/dictionary}}
+{{^dictionary}}
+/** Autogenerated by {{tool}} v{{toolversion}} */
+
+#include "esc_coe.h"
+const _objectlist SDOobjects[] = {
+{ 0xFFFF, 0xFF, 0xFF, 0xFF, NULL, NULL } };
+
+
+{{/dictionary}}
@@ -0,0 +1,49 @@
+{{! utypes.h as SOESConfigWriter writes it }}
+/** Autogenerated by {{tool}} v{{toolversion}} */
+
+#ifndef __UTYPES_H__
+#define __UTYPES_H__
+
+#include <stdint.h>
+
+{{?dictionary}}
+{{?dynrxpdos}}
+/** When using dynamic RXPDOs remember to initialize max_subindex and so on manually */
+typedef struct {
+	uint8_t max_subindex;
+	uint16_t subindex[{{dynrxpdos}}]; /* 0x1600-0x{{dynrxpdoend|hex}} */
+} _SM2_MAPPINGS;
+
+extern _SM2_MAPPINGS SM2_MAPPINGS;
+
+{{/dynrxpdos}}
+{{?dyntxpdos}}
+/** When using dynamic TXPDOs remember to initialize max_subindex and so on manually */
+typedef struct {
+	uint8_t max_subindex;
+	uint16_t subindex[{{dyntxpdos}}]; /* 0x1A00-0x{{dyntxpdoend|hex}} */
+} _SM3_MAPPINGS;
+
+extern _SM3_MAPPINGS SM3_MAPPINGS;
+
+{{/dyntxpdos}}
+{{#objects}}
+{{?variable}}
+{{?subitems}}
+typedef struct {
+{{#members}}
+	{{ctype}} {{name}}; /* {{index|hex4}}.{{subindex|hex2}} */
+{{/members}}
+} _{{name|CNAME}};
+
+extern _{{name|CNAME}} {{varname}};
+
+{{/subitems}}
+{{^subitems}}
+extern {{vartype}} {{varname}};
+
+{{/subitems}}
+{{/variable}}
+{{/objects}}
+{{/dictionary}}
+#endif /* UTYPES_H */
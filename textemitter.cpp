@@ -0,0 +1,39 @@
+#include "textemitter.h"
+#include <charconv>
+
+TextEmitter& TextEmitter::operator<<(long long v) {
+	if(m_failed) return *this;
+	char buf[24];
+	std::to_chars_result r = std::to_chars(buf,buf + sizeof(buf),v);
+	m_out.append(buf,r.ptr - buf);
+	return *this;
+}
+
+TextEmitter& TextEmitter::operator<<(unsigned long long v) {
+	if(m_failed) return *this;
+	char buf[24];
+	std::to_chars_result r = std::to_chars(buf,buf + sizeof(buf),v);
+	m_out.append(buf,r.ptr - buf);
+	return *this;
+}
+
+TextEmitter& TextEmitter::operator<<(const Hex& h) {
+	if(m_failed) return *this;
+	char buf[16];
+	std::to_chars_result r = std::to_chars(buf,buf + sizeof(buf),h.v,16);
+	int digits = r.ptr - buf;
+	if(h.width > digits) m_out.append(h.width - digits,'0');
+	if(h.upper) {
+		for(int i = 0; i < digits; ++i)
+			if(buf[i] >= 'a') buf[i] -= 'a' - 'A';
+	}
+	m_out.append(buf,digits);
+	return *this;
+}
+
+TextEmitter& TextEmitter::operator<<(const TextEmitter& other) {
+	if(m_failed) return *this;
+	m_out.append(other.m_out);
+	m_failed = other.m_failed;
+	return *this;
+}
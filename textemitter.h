@@ -0,0 +1,56 @@
+#ifndef TEXTEMITTER_H
+#define TEXTEMITTER_H
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * Text writer for generated sources: appends to one preallocated string so
+ * a file goes to its sink with a single write, numbers are formatted with
+ * std::to_chars. Unlike an ostream there is no sticky formatting state,
+ * every number says how it is printed. As with an ostream, a NULL string
+ * stops all further output (the file ends there).
+ */
+class TextEmitter {
+public:
+	// Hexadecimal without prefix, zero padded to at least width digits
+	struct Hex {
+		Hex(unsigned long long v, int width = 0, bool upper = true) : v(v), width(width), upper(upper) {};
+		unsigned long long v;
+		int width;
+		bool upper;
+	};
+
+	TextEmitter(size_t reserve = 4096) : m_failed(false) { m_out.reserve(reserve); };
+
+	TextEmitter& operator<<(const char* s) {
+		if(NULL == s) m_failed = true;
+		else if(!m_failed) m_out.append(s);
+		return *this;
+	};
+	TextEmitter& operator<<(std::string_view s) { if(!m_failed) m_out.append(s); return *this; };
+	TextEmitter& operator<<(const std::string& s) { return *this << std::string_view(s); };
+	TextEmitter& operator<<(char c) { if(!m_failed) m_out += c; return *this; };
+	TextEmitter& operator<<(long long v);
+	TextEmitter& operator<<(unsigned long long v);
+	TextEmitter& operator<<(int v) { return *this << (long long)v; };
+	TextEmitter& operator<<(long v) { return *this << (long long)v; };
+	TextEmitter& operator<<(unsigned int v) { return *this << (unsigned long long)v; };
+	TextEmitter& operator<<(unsigned long v) { return *this << (unsigned long long)v; };
+	TextEmitter& operator<<(const Hex& h);
+	// Output of another emitter, e.g. a part generated separately
+	TextEmitter& operator<<(const TextEmitter& other);
+
+	void reserve(size_t size) { m_out.reserve(size); };
+	// Empty again, keeping the buffer
+	void clear(void) { m_out.clear(); m_failed = false; };
+	const std::string& str(void) const { return m_out; };
+	size_t size(void) const { return m_out.size(); };
+	// A NULL string was written
+	bool failed(void) const { return m_failed; };
+private:
+	std::string m_out;
+	bool m_failed;
+};
+
+#endif /* TEXTEMITTER_H */